@@ -77,6 +77,12 @@ public:
             double dataStart, bool printRoutes, std::string CSVfileName);
   void setRunParam(uint32_t nWifis, uint32_t nSinks, double shortestPathFactor, 
             double backpressurFactor);
+  /**
+   * Select how OLSB forwards packets
+   * \param forwardingMode "Routed" or "Backpressure"
+   * \param backpressureLifo serve the commodity queues last in first out
+   */
+  void setForwardingMode(std::string forwardingMode, bool backpressureLifo);
 
 
 private:
@@ -90,6 +96,8 @@ private:
   uint32_t m_settlingTime; ///< routing setting time
   double m_shortestPathFactor; ///< shorest path factor
   double m_backpressurFactor; ///< backpressure factor
+  std::string m_forwardingMode; ///< OLSB forwarding mode
+  bool m_backpressureLifo; ///< serve the commodity queues last in first out
   double m_dataStart; ///< time to start data transmissions (seconds)
   uint32_t bytesTotal; ///< total bytes received by all nodes
   uint32_t packetsReceived; ///< total packets received by all nodes
@@ -148,6 +156,8 @@ OlsbRoutingExperiment::OlsbRoutingExperiment ()
   m_traceMobility = true;
   m_shortestPathFactor = 0.5;
   m_backpressurFactor = 0.5;
+  m_forwardingMode = "Routed";
+  m_backpressureLifo = false;
   m_protocolName = "05-olsb";
   m_nWifis = 30;
   m_nSinks = 10;
@@ -295,6 +305,8 @@ OlsbRoutingExperiment::InstallInternetStack (std::string tr_name)
   olsb.Set ("SettlingTime", TimeValue (Seconds (m_settlingTime)));
   olsb.Set("ShortestPathFactor", DoubleValue(m_shortestPathFactor));
   olsb.Set("BackpressureFactor", DoubleValue(m_backpressurFactor));
+  olsb.Set("ForwardingMode", StringValue(m_forwardingMode));
+  olsb.Set("BackpressureLifo", BooleanValue(m_backpressureLifo));
   InternetStackHelper stack;
   stack.SetRoutingHelper (olsb); // has effect on the next Install ()
   stack.Install (nodes);
@@ -347,6 +359,10 @@ OlsbRoutingExperiment::change_protocol(double newShortestPathFactor, double newB
     m_shortestPathFactor = newShortestPathFactor;
     m_backpressurFactor = newBackpressurFactor;
     m_protocolName = std::to_string(int(newShortestPathFactor*10)) + "-olsb";
+    if (m_forwardingMode != "Routed")
+      {
+        m_protocolName += "-" + m_forwardingMode + (m_backpressureLifo ? "-lifo" : "");
+      }
     m_CSVfileName = m_protocolName + "-routing-experiment.output.csv";
     
     std::ofstream out (m_CSVfileName.c_str ());
@@ -390,6 +406,14 @@ OlsbRoutingExperiment::setRunParam(uint32_t nWifis, uint32_t nSinks, double shor
   change_protocol(shortestPathFactor, backpressurFactor);
 }
 
+void
+OlsbRoutingExperiment::setForwardingMode(std::string forwardingMode, bool backpressureLifo)
+{
+  m_forwardingMode = forwardingMode;
+  m_backpressureLifo = backpressureLifo;
+  change_protocol(m_shortestPathFactor, m_backpressurFactor);
+}
+
 
 void
 OlsbRoutingExperiment::CaseRun ()
@@ -467,5 +491,15 @@ main (int argc, char *argv[])
   experiment.setRunParam(30, 10, 0.8, 0.2);
   experiment.CaseRun();
 
+  // per-packet backpressure, against the first trail
+  experiment = OlsbRoutingExperiment();
+  experiment.setForwardingMode("Backpressure", false);
+  experiment.CaseRun();
+
+  // per-packet backpressure with LIFO service
+  experiment = OlsbRoutingExperiment();
+  experiment.setForwardingMode("Backpressure", true);
+  experiment.CaseRun();
+
   return 1;
 }
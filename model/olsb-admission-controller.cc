@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#include "olsb-admission-controller.h"
+#include <algorithm>
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OlsbAdmissionController");
+
+namespace olsb {
+AdmissionController::AdmissionController ()
+  : m_v (100),
+    m_maxRate (100),
+    m_interval (MilliSeconds (100))
+{
+}
+
+double
+AdmissionController::GetMaxAdmitted () const
+{
+  return m_maxRate * m_interval.GetSeconds ();
+}
+
+bool
+AdmissionController::Admit (Ipv4Address dst)
+{
+  std::map<Ipv4Address, Flow>::iterator i = m_flows.find (dst);
+  if (i == m_flows.end ())
+    {
+      // A new flow starts with a full budget until its first update
+      Flow flow = { 0, GetMaxAdmitted (), 0, 0 };
+      i = m_flows.insert (std::make_pair (dst,flow)).first;
+    }
+  i->second.offered++;
+  if (i->second.budget < 1)
+    {
+      return false;
+    }
+  i->second.budget -= 1;
+  i->second.admitted++;
+  return true;
+}
+
+void
+AdmissionController::Update (const std::map<Ipv4Address, double> &prices, std::map<Ipv4Address, double> &rates)
+{
+  rates.clear ();
+  double maxAdmitted = GetMaxAdmitted ();
+  for (std::map<Ipv4Address, Flow>::iterator i = m_flows.begin (); i != m_flows.end (); )
+    {
+      Flow &flow = i->second;
+      if (flow.offered == 0)
+        {
+          m_flows.erase (i++);
+          continue;
+        }
+      // Target of the log utility: V / (1 + gamma) = Z
+      double gamma = maxAdmitted;
+      if (flow.virtualQueue > 0)
+        {
+          gamma = std::min (std::max (m_v / flow.virtualQueue - 1, 0.0), maxAdmitted);
+        }
+      flow.virtualQueue = std::max (flow.virtualQueue - flow.admitted, 0.0) + gamma;
+      std::map<Ipv4Address, double>::const_iterator j = prices.find (i->first);
+      double price = j != prices.end () ? j->second : 0;
+      flow.budget = flow.virtualQueue > price ? maxAdmitted : 0;
+      rates[i->first] = flow.admitted / m_interval.GetSeconds ();
+      NS_LOG_LOGIC ("Flow to " << i->first << ": admitted " << flow.admitted << " of " << flow.offered
+                               << ", virtual queue " << flow.virtualQueue << ", price " << price
+                               << ", budget " << flow.budget);
+      flow.admitted = 0;
+      flow.offered = 0;
+      ++i;
+    }
+}
+
+void
+AdmissionController::GetFlows (std::vector<Ipv4Address> &dsts) const
+{
+  dsts.clear ();
+  for (std::map<Ipv4Address, Flow>::const_iterator i = m_flows.begin (); i != m_flows.end (); ++i)
+    {
+      dsts.push_back (i->first);
+    }
+}
+
+double
+AdmissionController::GetVirtualQueue (Ipv4Address dst) const
+{
+  std::map<Ipv4Address, Flow>::const_iterator i = m_flows.find (dst);
+  return i != m_flows.end () ? i->second.virtualQueue : 0;
+}
+
+}
+}
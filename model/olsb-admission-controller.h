@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#ifndef OLSB_ADMISSION_CONTROLLER_H
+#define OLSB_ADMISSION_CONTROLLER_H
+
+#include <map>
+#include <vector>
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+namespace olsb {
+/**
+ * \ingroup olsb
+ * \brief Drift-plus-penalty admission of locally originated packets
+ *
+ * Every destination of local traffic is a flow with a virtual queue Z. At the end of every control
+ * interval the controller
+ *
+ * - picks the target amount gamma in [0, A] that maximises V * log (1 + gamma) - Z * gamma,
+ *   that is gamma = V / Z - 1, where A is the largest amount admitted per interval;
+ * - updates Z = max (Z - admitted, 0) + gamma, so Z grows while fewer packets than the
+ *   utility asks for get through;
+ * - allows up to A packets in the next interval if Z exceeds the congestion price of the flow,
+ *   and none otherwise.
+ *
+ * The congestion price is the backlog towards the destination, so network queues stay bounded
+ * by about V while the long term admitted rates maximise the sum of the log utilities.
+ */
+class AdmissionController
+{
+public:
+  /// c-tor
+  AdmissionController ();
+  /**
+   * Admit a packet of a flow if the flow has budget left in the current interval
+   * \param dst the destination of the flow
+   * \returns true if the packet is admitted
+   */
+  bool
+  Admit (Ipv4Address dst);
+  /**
+   * End the current interval of every flow and set its budget for the next one. Flows that offered
+   * no packet during the interval are forgotten.
+   * \param prices the congestion price of every flow, flows left out have none
+   * \param rates the admitted rate of every flow over the interval, in packets per second
+   */
+  void
+  Update (const std::map<Ipv4Address, double> &prices, std::map<Ipv4Address, double> &rates);
+  /**
+   * Get the destinations of the flows
+   * \param dsts the destination of every flow
+   */
+  void
+  GetFlows (std::vector<Ipv4Address> &dsts) const;
+  /**
+   * Get the virtual queue of a flow
+   * \param dst the destination of the flow
+   * \returns the virtual queue, 0 for an unknown flow
+   */
+  double
+  GetVirtualQueue (Ipv4Address dst) const;
+  /// Forget all flows
+  void
+  Clear ()
+  {
+    m_flows.clear ();
+  }
+  /**
+   * Set the utility weight V
+   * \param v the weight, larger values trade larger queues for more utility
+   */
+  void
+  SetUtilityWeight (double v)
+  {
+    m_v = v;
+  }
+  /**
+   * Set the largest rate of a flow
+   * \param rate the rate in packets per second
+   */
+  void
+  SetMaxRate (double rate)
+  {
+    m_maxRate = rate;
+  }
+  /**
+   * Set the control interval
+   * \param interval the interval
+   */
+  void
+  SetInterval (Time interval)
+  {
+    m_interval = interval;
+  }
+
+private:
+  /// State of a flow
+  struct Flow
+  {
+    /// virtual queue
+    double virtualQueue;
+    /// packets that can still be admitted in the current interval
+    double budget;
+    /// packets admitted in the current interval
+    uint32_t admitted;
+    /// packets offered in the current interval
+    uint32_t offered;
+  };
+  /**
+   * Get the largest number of packets admitted per interval
+   * \returns the number of packets
+   */
+  double
+  GetMaxAdmitted () const;
+  /// State of every flow
+  std::map<Ipv4Address, Flow> m_flows;
+  /// utility weight V
+  double m_v;
+  /// largest rate of a flow, in packets per second
+  double m_maxRate;
+  /// control interval
+  Time m_interval;
+};
+
+}
+}
+
+#endif /* OLSB_ADMISSION_CONTROLLER_H */
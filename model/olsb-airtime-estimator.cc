@@ -0,0 +1,181 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#include "olsb-airtime-estimator.h"
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/arp-cache.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-mac-header.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OlsbAirtimeEstimator");
+
+namespace olsb {
+AirtimeEstimator::LinkStats::LinkStats ()
+  : attempts (0),
+    failures (0),
+    rate (0)
+{
+}
+
+AirtimeEstimator::AirtimeEstimator ()
+  : m_referenceSize (1024),
+    m_alpha (0.1)
+{
+}
+
+void
+AirtimeEstimator::Dispose ()
+{
+  for (std::map<Ptr<NetDevice>, Ptr<WifiPhy> >::iterator i = m_tracedPhys.begin (); i != m_tracedPhys.end (); ++i)
+    {
+      i->second->TraceDisconnectWithoutContext ("MonitorSnifferTx", MakeCallback (&AirtimeEstimator::PhyTx, this));
+    }
+  for (std::map<Ptr<NetDevice>, Ptr<WifiRemoteStationManager> >::iterator i = m_tracedManagers.begin ();
+       i != m_tracedManagers.end (); ++i)
+    {
+      i->second->TraceDisconnectWithoutContext ("MacTxDataFailed", MakeCallback (&AirtimeEstimator::TxDataFailed, this));
+    }
+  m_tracedPhys.clear ();
+  m_tracedManagers.clear ();
+  m_links.clear ();
+}
+
+void
+AirtimeEstimator::AddDevice (Ptr<NetDevice> dev)
+{
+  NS_LOG_FUNCTION (this << dev);
+  Ptr<WifiNetDevice> wifiDev = DynamicCast<WifiNetDevice> (dev);
+  if (wifiDev == 0 || m_tracedPhys.find (dev) != m_tracedPhys.end ())
+    {
+      return;
+    }
+  Ptr<WifiPhy> phy = wifiDev->GetPhy ();
+  Ptr<WifiRemoteStationManager> manager = wifiDev->GetRemoteStationManager ();
+  if (phy == 0 || manager == 0)
+    {
+      return;
+    }
+  phy->TraceConnectWithoutContext ("MonitorSnifferTx", MakeCallback (&AirtimeEstimator::PhyTx, this));
+  manager->TraceConnectWithoutContext ("MacTxDataFailed", MakeCallback (&AirtimeEstimator::TxDataFailed, this));
+  m_tracedPhys.insert (std::make_pair (dev,phy));
+  m_tracedManagers.insert (std::make_pair (dev,manager));
+}
+
+void
+AirtimeEstimator::RemoveDevice (Ptr<NetDevice> dev)
+{
+  NS_LOG_FUNCTION (this << dev);
+  std::map<Ptr<NetDevice>, Ptr<WifiPhy> >::iterator phy = m_tracedPhys.find (dev);
+  if (phy != m_tracedPhys.end ())
+    {
+      phy->second->TraceDisconnectWithoutContext ("MonitorSnifferTx", MakeCallback (&AirtimeEstimator::PhyTx, this));
+      m_tracedPhys.erase (phy);
+    }
+  std::map<Ptr<NetDevice>, Ptr<WifiRemoteStationManager> >::iterator manager = m_tracedManagers.find (dev);
+  if (manager != m_tracedManagers.end ())
+    {
+      manager->second->TraceDisconnectWithoutContext ("MacTxDataFailed",
+                                                      MakeCallback (&AirtimeEstimator::TxDataFailed, this));
+      m_tracedManagers.erase (manager);
+    }
+}
+
+void
+AirtimeEstimator::PhyTx (Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector, MpduInfo aMpdu,
+                         uint16_t staId)
+{
+  if (aMpdu.type != NORMAL_MPDU)
+    {
+      // A-MPDU subframes carry delimiters in front of the MAC header
+      return;
+    }
+  WifiMacHeader hdr;
+  if (packet->PeekHeader (hdr) == 0 || !hdr.IsData () || hdr.GetAddr1 ().IsGroup ())
+    {
+      return;
+    }
+  LinkStats &link = m_links[hdr.GetAddr1 ()];
+  double rate = static_cast<double> (txVector.GetMode ().GetDataRate (txVector));
+  link.rate = link.attempts > 0 ? (1 - m_alpha) * link.rate + m_alpha * rate : rate;
+  link.attempts = (1 - m_alpha) * link.attempts + 1;
+  link.failures = (1 - m_alpha) * link.failures;
+}
+
+void
+AirtimeEstimator::TxDataFailed (Mac48Address address)
+{
+  std::map<Mac48Address, LinkStats>::iterator i = m_links.find (address);
+  if (i != m_links.end ())
+    {
+      // Every failure follows the attempt that was just counted
+      i->second.failures = std::min (i->second.failures + 1, i->second.attempts);
+    }
+}
+
+Time
+AirtimeEstimator::GetEtt (Mac48Address neighbor, DataRate fallback) const
+{
+  double rate = static_cast<double> (fallback.GetBitRate ());
+  double success = 1;
+  std::map<Mac48Address, LinkStats>::const_iterator i = m_links.find (neighbor);
+  if (i != m_links.end () && i->second.attempts > 0)
+    {
+      rate = i->second.rate;
+      // A link that never delivers is costed as if one attempt in a hundred succeeded
+      success = std::max (1 - i->second.failures / i->second.attempts, 0.01);
+    }
+  if (rate <= 0)
+    {
+      return Time (0);
+    }
+  return Seconds (m_referenceSize * 8 / rate / success);
+}
+
+Time
+AirtimeEstimator::GetEtt (Ptr<NetDevice> dev, Ipv4Address neighbor, DataRate fallback) const
+{
+  Ptr<Ipv4L3Protocol> l3 = dev->GetNode ()->GetObject<Ipv4L3Protocol> ();
+  if (l3 != 0 && m_tracedPhys.find (dev) != m_tracedPhys.end ())
+    {
+      int32_t interface = l3->GetInterfaceForDevice (dev);
+      Ptr<ArpCache> arp = interface >= 0 ? l3->GetInterface (interface)->GetArpCache () : 0;
+      ArpCache::Entry *entry = arp != 0 ? arp->Lookup (neighbor) : 0;
+      if (entry != 0 && (entry->IsAlive () || entry->IsPermanent ()))
+        {
+          return GetEtt (Mac48Address::ConvertFrom (entry->GetMacAddress ()), fallback);
+        }
+    }
+  return GetEtt (Mac48Address (), fallback);
+}
+
+}
+}
@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#ifndef OLSB_AIRTIME_ESTIMATOR_H
+#define OLSB_AIRTIME_ESTIMATOR_H
+
+#include <map>
+#include <vector>
+#include "ns3/ipv4-address.h"
+#include "ns3/mac48-address.h"
+#include "ns3/net-device.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/wifi-phy.h"
+#include "ns3/wifi-remote-station-manager.h"
+
+namespace ns3 {
+namespace olsb {
+/**
+ * \ingroup olsb
+ * \brief Per neighbor expected transmission time (ETT) of the Wi-Fi links
+ *
+ * The estimator follows the unicast data frames that the Wi-Fi PHY of every OLSB interface
+ * transmits, and the failed transmissions reported by the remote station manager. For every
+ * neighbor it keeps a moving average of the rate chosen by the rate control and of the
+ * probability that a transmission attempt succeeds, and derives the expected time to deliver a
+ * reference packet over the link, retransmissions included:
+ *
+ *   ETT = ReferenceSize / rate / success
+ *
+ * Neighbors are identified by their MAC address. OLSB knows them by IPv4 address, so the
+ * interface ARP cache is used to map one to the other. Neighbors without any unicast
+ * transmission yet are costed at the fallback rate given by the caller without losses.
+ */
+class AirtimeEstimator
+{
+public:
+  /// c-tor
+  AirtimeEstimator ();
+  /// Disconnect from the traces of all devices
+  void
+  Dispose ();
+  /**
+   * Start following the transmissions of a device
+   * \param dev the net device, ignored if it is not a Wi-Fi device
+   */
+  void
+  AddDevice (Ptr<NetDevice> dev);
+  /**
+   * Stop following the transmissions of a device
+   * \param dev the net device
+   */
+  void
+  RemoveDevice (Ptr<NetDevice> dev);
+  /**
+   * Get the expected transmission time of a reference packet to a neighbor
+   * \param dev the net device towards the neighbor
+   * \param neighbor the neighbor IPv4 address
+   * \param fallback the data rate used when nothing is known about the link
+   * \returns the expected transmission time
+   */
+  Time
+  GetEtt (Ptr<NetDevice> dev, Ipv4Address neighbor, DataRate fallback) const;
+  /**
+   * Get the expected transmission time of a reference packet to a neighbor
+   * \param neighbor the neighbor MAC address
+   * \param fallback the data rate used when nothing is known about the link
+   * \returns the expected transmission time
+   */
+  Time
+  GetEtt (Mac48Address neighbor, DataRate fallback) const;
+  /**
+   * Set the size of the reference packet
+   * \param bytes the reference packet size
+   */
+  void
+  SetReferenceSize (uint32_t bytes)
+  {
+    m_referenceSize = bytes;
+  }
+  /**
+   * Get the size of the reference packet
+   * \returns the reference packet size
+   */
+  uint32_t
+  GetReferenceSize () const
+  {
+    return m_referenceSize;
+  }
+  /**
+   * Set the weight of a new sample in the moving averages
+   * \param alpha the weight, in (0, 1]
+   */
+  void
+  SetAveragingWeight (double alpha)
+  {
+    m_alpha = alpha;
+  }
+  /**
+   * Get the weight of a new sample in the moving averages
+   * \returns the weight
+   */
+  double
+  GetAveragingWeight () const
+  {
+    return m_alpha;
+  }
+
+private:
+  /// Transmission statistics of the link to one neighbor
+  struct LinkStats
+  {
+    /// c-tor
+    LinkStats ();
+    double attempts; ///< moving count of transmission attempts
+    double failures; ///< moving count of failed attempts
+    double rate; ///< moving average of the data rate in bit/s
+  };
+  /**
+   * Trace sink for frames handed to the PHY
+   * \param packet the frame
+   * \param channelFreqMhz the channel frequency
+   * \param txVector the transmission parameters
+   * \param aMpdu the A-MPDU information
+   * \param staId the station ID
+   */
+  void
+  PhyTx (Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector, MpduInfo aMpdu, uint16_t staId);
+  /**
+   * Trace sink for data frames that were not acknowledged
+   * \param address the neighbor MAC address
+   */
+  void
+  TxDataFailed (Mac48Address address);
+  /// link statistics per neighbor MAC address
+  std::map<Mac48Address, LinkStats> m_links;
+  /// size of the reference packet in bytes
+  uint32_t m_referenceSize;
+  /// weight of a new sample in the moving averages
+  double m_alpha;
+  /// PHYs whose traces are connected
+  std::map<Ptr<NetDevice>, Ptr<WifiPhy> > m_tracedPhys;
+  /// remote station managers whose traces are connected
+  std::map<Ptr<NetDevice>, Ptr<WifiRemoteStationManager> > m_tracedManagers;
+};
+
+}
+}
+
+#endif /* OLSB_AIRTIME_ESTIMATOR_H */
@@ -0,0 +1,493 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#include "olsb-backlog-monitor.h"
+#include <cmath>
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/pointer.h"
+#include "ns3/traffic-control-layer.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-phy.h"
+#include "ns3/wifi-mode.h"
+#include "ns3/wifi-remote-station-manager.h"
+#include "ns3/txop.h"
+#include "ns3/llc-snap-header.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-queue-disc-item.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OlsbBacklogMonitor");
+
+namespace olsb {
+BacklogMonitor::Backlog::Backlog ()
+  : packets (0),
+    bytes (0),
+    smoothedBytes (0),
+    lastChange (Simulator::Now ())
+{
+}
+
+BacklogMonitor::BacklogMonitor ()
+  : m_source (EGRESS),
+    m_defaultDataRate (DataRate ("11Mbps")),
+    m_timeConstant (Seconds (1))
+{
+}
+
+void
+BacklogMonitor::Dispose ()
+{
+  for (std::vector<Ptr<QueueDisc> >::iterator i = m_tracedQueueDiscs.begin (); i != m_tracedQueueDiscs.end (); ++i)
+    {
+      (*i)->TraceDisconnectWithoutContext ("Enqueue", MakeCallback (&BacklogMonitor::QueueDiscEnqueue, this));
+      (*i)->TraceDisconnectWithoutContext ("Dequeue", MakeCallback (&BacklogMonitor::QueueDiscDequeue, this));
+      (*i)->TraceDisconnectWithoutContext ("DropAfterDequeue",
+                                           MakeCallback (&BacklogMonitor::QueueDiscDropAfterDequeue, this));
+    }
+  for (std::vector<Ptr<WifiMacQueue> >::iterator i = m_tracedMacQueues.begin (); i != m_tracedMacQueues.end (); ++i)
+    {
+      (*i)->TraceDisconnectWithoutContext ("Enqueue", MakeCallback (&BacklogMonitor::MacQueueEnqueue, this));
+      (*i)->TraceDisconnectWithoutContext ("Dequeue", MakeCallback (&BacklogMonitor::MacQueueDequeue, this));
+      (*i)->TraceDisconnectWithoutContext ("DropAfterDequeue", MakeCallback (&BacklogMonitor::MacQueueDequeue, this));
+    }
+  m_tracedQueueDiscs.clear ();
+  m_tracedMacQueues.clear ();
+  m_devices.clear ();
+  m_perDst.clear ();
+  m_total = Backlog ();
+}
+
+void
+BacklogMonitor::AddDevice (Ptr<NetDevice> dev)
+{
+  NS_LOG_FUNCTION (this << dev);
+  m_devices.insert (std::make_pair (dev,DeviceQueues ()));
+}
+
+void
+BacklogMonitor::RemoveDevice (Ptr<NetDevice> dev)
+{
+  NS_LOG_FUNCTION (this << dev);
+  m_devices.erase (dev);
+}
+
+BacklogMonitor::DeviceQueues *
+BacklogMonitor::Resolve (Ptr<NetDevice> dev)
+{
+  std::map<Ptr<NetDevice>, DeviceQueues>::iterator i = m_devices.find (dev);
+  if (i == m_devices.end ())
+    {
+      return 0;
+    }
+  DeviceQueues &queues = i->second;
+  bool queueDiscFound = queues.queueDisc != 0;
+  bool macQueueFound = queues.macQueue != 0;
+  FindQueues (dev, queues);
+  if (!queueDiscFound && queues.queueDisc != 0 && (m_source == QUEUE_DISC || m_source == EGRESS))
+    {
+      queues.queueDisc->TraceConnectWithoutContext ("Enqueue", MakeCallback (&BacklogMonitor::QueueDiscEnqueue, this));
+      queues.queueDisc->TraceConnectWithoutContext ("Dequeue", MakeCallback (&BacklogMonitor::QueueDiscDequeue, this));
+      queues.queueDisc->TraceConnectWithoutContext ("DropAfterDequeue",
+                                                    MakeCallback (&BacklogMonitor::QueueDiscDropAfterDequeue, this));
+      m_tracedQueueDiscs.push_back (queues.queueDisc);
+    }
+  if (!macQueueFound && queues.macQueue != 0 && (m_source == MAC_QUEUE || m_source == EGRESS))
+    {
+      queues.macQueue->TraceConnectWithoutContext ("Enqueue", MakeCallback (&BacklogMonitor::MacQueueEnqueue, this));
+      queues.macQueue->TraceConnectWithoutContext ("Dequeue", MakeCallback (&BacklogMonitor::MacQueueDequeue, this));
+      queues.macQueue->TraceConnectWithoutContext ("DropAfterDequeue", MakeCallback (&BacklogMonitor::MacQueueDequeue, this));
+      m_tracedMacQueues.push_back (queues.macQueue);
+    }
+  return &queues;
+}
+
+void
+BacklogMonitor::FindQueues (Ptr<NetDevice> dev, DeviceQueues &queues)
+{
+  if (queues.queueDisc == 0)
+    {
+      Ptr<TrafficControlLayer> tc = dev->GetNode ()->GetObject<TrafficControlLayer> ();
+      if (tc != 0)
+        {
+          queues.queueDisc = tc->GetRootQueueDiscOnDevice (dev);
+        }
+    }
+  Ptr<WifiNetDevice> wifiDev = DynamicCast<WifiNetDevice> (dev);
+  if (queues.macQueue == 0 && wifiDev != 0 && wifiDev->GetMac () != 0)
+    {
+      // Non-QoS MACs use a single Txop, QoS MACs keep best effort traffic in BE_Txop
+      PointerValue txop;
+      if (wifiDev->GetMac ()->GetAttributeFailSafe ("Txop", txop) && txop.Get<Txop> () != 0)
+        {
+          queues.macQueue = txop.Get<Txop> ()->GetWifiMacQueue ();
+        }
+      else if (wifiDev->GetMac ()->GetAttributeFailSafe ("BE_Txop", txop) && txop.Get<Txop> () != 0)
+        {
+          queues.macQueue = txop.Get<Txop> ()->GetWifiMacQueue ();
+        }
+    }
+}
+
+uint32_t
+BacklogMonitor::GetBacklogPackets (Ptr<NetDevice> dev)
+{
+  DeviceQueues *queues = Resolve (dev);
+  if (queues == 0)
+    {
+      return 0;
+    }
+  uint32_t packets = 0;
+  if ((m_source == QUEUE_DISC || m_source == EGRESS) && queues->queueDisc != 0)
+    {
+      packets += queues->queueDisc->GetNPackets ();
+    }
+  if ((m_source == MAC_QUEUE || m_source == EGRESS) && queues->macQueue != 0)
+    {
+      packets += queues->macQueue->GetNPackets ();
+    }
+  return packets;
+}
+
+uint32_t
+BacklogMonitor::GetBacklogBytes (Ptr<NetDevice> dev)
+{
+  DeviceQueues *queues = Resolve (dev);
+  if (queues == 0)
+    {
+      return 0;
+    }
+  uint32_t bytes = 0;
+  if ((m_source == QUEUE_DISC || m_source == EGRESS) && queues->queueDisc != 0)
+    {
+      bytes += queues->queueDisc->GetNBytes ();
+    }
+  if ((m_source == MAC_QUEUE || m_source == EGRESS) && queues->macQueue != 0)
+    {
+      bytes += queues->macQueue->GetNBytes ();
+    }
+  return bytes;
+}
+
+uint32_t
+BacklogMonitor::GetEgressPackets (Ptr<NetDevice> dev)
+{
+  DeviceQueues *queues = Resolve (dev);
+  DeviceQueues unmonitored;
+  if (queues == 0)
+    {
+      FindQueues (dev, unmonitored);
+      queues = &unmonitored;
+    }
+  uint32_t packets = 0;
+  if (queues->queueDisc != 0)
+    {
+      packets += queues->queueDisc->GetNPackets ();
+    }
+  if (queues->macQueue != 0)
+    {
+      packets += queues->macQueue->GetNPackets ();
+    }
+  return packets;
+}
+
+DataRate
+BacklogMonitor::GetDataRate (Ptr<NetDevice> dev)
+{
+  DeviceQueues *queues = Resolve (dev);
+  if (queues == 0)
+    {
+      return m_defaultDataRate;
+    }
+  if (queues->rate.GetBitRate () == 0)
+    {
+      Ptr<WifiNetDevice> wifiDev = DynamicCast<WifiNetDevice> (dev);
+      DataRateValue rate;
+      WifiModeValue mode;
+      if (wifiDev != 0 && wifiDev->GetPhy () != 0 && wifiDev->GetRemoteStationManager () != 0
+          && wifiDev->GetRemoteStationManager ()->GetAttributeFailSafe ("DataMode", mode))
+        {
+          // Only constant rate managers expose the rate they transmit at
+          queues->rate = DataRate (mode.Get ().GetDataRate (wifiDev->GetPhy ()->GetChannelWidth ()));
+        }
+      else if (dev->GetAttributeFailSafe ("DataRate", rate))
+        {
+          queues->rate = rate.Get ();
+        }
+      else
+        {
+          NS_LOG_DEBUG ("Data rate of device " << dev->GetIfIndex () << " unknown, using " << m_defaultDataRate);
+          return m_defaultDataRate;
+        }
+    }
+  return queues->rate;
+}
+
+Time
+BacklogMonitor::GetDrainTime (Ptr<NetDevice> dev)
+{
+  uint32_t bytes = GetBacklogBytes (dev);
+  if (bytes == 0)
+    {
+      return Seconds (0);
+    }
+  return GetDataRate (dev).CalculateBytesTxTime (bytes);
+}
+
+uint32_t
+BacklogMonitor::GetBacklogPackets (Ipv4Address dst) const
+{
+  std::map<Ipv4Address, Backlog>::const_iterator i = m_perDst.find (dst);
+  if (i == m_perDst.end ())
+    {
+      return 0;
+    }
+  return i->second.packets;
+}
+
+uint32_t
+BacklogMonitor::GetBacklogBytes (Ipv4Address dst) const
+{
+  std::map<Ipv4Address, Backlog>::const_iterator i = m_perDst.find (dst);
+  if (i == m_perDst.end ())
+    {
+      return 0;
+    }
+  return i->second.bytes;
+}
+
+Time
+BacklogMonitor::GetDrainTime (Ptr<NetDevice> dev, Ipv4Address dst)
+{
+  if (Resolve (dev) == 0)
+    {
+      return Seconds (0);
+    }
+  Reconcile ();
+  uint32_t bytes = GetBacklogBytes (dst);
+  if (bytes == 0)
+    {
+      return Seconds (0);
+    }
+  return GetDataRate (dev).CalculateBytesTxTime (bytes);
+}
+
+void
+BacklogMonitor::Account (Ipv4Address dst, uint32_t bytes, bool enqueued)
+{
+  std::map<Ipv4Address, Backlog>::iterator i = m_perDst.find (dst);
+  if (i == m_perDst.end ())
+    {
+      if (!enqueued)
+        {
+          // The packet was queued before the traces were connected
+          return;
+        }
+      i = m_perDst.insert (std::make_pair (dst,Backlog ())).first;
+    }
+  Change (i->second, bytes, enqueued);
+  Change (m_total, bytes, enqueued);
+}
+
+double
+BacklogMonitor::GetSmoothedBytes (const Backlog &backlog) const
+{
+  if (m_timeConstant.IsZero ())
+    {
+      return backlog.bytes;
+    }
+  double weight = std::exp (-(Simulator::Now () - backlog.lastChange).GetSeconds () / m_timeConstant.GetSeconds ());
+  return weight * backlog.smoothedBytes + (1.0 - weight) * backlog.bytes;
+}
+
+void
+BacklogMonitor::Change (Backlog &backlog, uint32_t bytes, bool enqueued)
+{
+  backlog.smoothedBytes = GetSmoothedBytes (backlog);
+  backlog.lastChange = Simulator::Now ();
+  if (enqueued)
+    {
+      backlog.packets++;
+      backlog.bytes += bytes;
+    }
+  else if (backlog.packets <= 1 || backlog.bytes <= bytes)
+    {
+      backlog.packets = 0;
+      backlog.bytes = 0;
+    }
+  else
+    {
+      backlog.packets--;
+      backlog.bytes -= bytes;
+    }
+}
+
+void
+BacklogMonitor::Reconcile ()
+{
+  // Packets removed without a dequeue trace (e.g. expired MAC queue items) would otherwise linger
+  bool empty = true;
+  // Only the queues of the configured source are traced, so only they can confirm an empty backlog
+  for (std::map<Ptr<NetDevice>, DeviceQueues>::const_iterator i = m_devices.begin (); i != m_devices.end (); ++i)
+    {
+      if (((m_source == QUEUE_DISC || m_source == EGRESS) && i->second.queueDisc != 0
+           && i->second.queueDisc->GetNPackets () > 0)
+          || ((m_source == MAC_QUEUE || m_source == EGRESS) && i->second.macQueue != 0
+              && i->second.macQueue->GetNPackets () > 0))
+        {
+          empty = false;
+          break;
+        }
+    }
+  if (empty && m_total.packets > 0)
+    {
+      Change (m_total, m_total.bytes, false);
+    }
+  for (std::map<Ipv4Address, Backlog>::iterator i = m_perDst.begin (); i != m_perDst.end (); )
+    {
+      if (empty && i->second.packets > 0)
+        {
+          Change (i->second, i->second.bytes, false);
+        }
+      if (i->second.packets == 0 && GetSmoothedBytes (i->second) < 1.0)
+        {
+          m_perDst.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+Time
+BacklogMonitor::GetTxTime (Ptr<NetDevice> dev, double bytes)
+{
+  if (bytes <= 0)
+    {
+      return Seconds (0);
+    }
+  return Seconds (bytes * 8.0 / static_cast<double> (GetDataRate (dev).GetBitRate ()));
+}
+
+Time
+BacklogMonitor::GetSmoothedDrainTime (Ptr<NetDevice> dev)
+{
+  if (Resolve (dev) == 0)
+    {
+      return Seconds (0);
+    }
+  Reconcile ();
+  return GetTxTime (dev, GetSmoothedBytes (m_total));
+}
+
+Time
+BacklogMonitor::GetSmoothedDrainTime (Ptr<NetDevice> dev, Ipv4Address dst)
+{
+  if (Resolve (dev) == 0)
+    {
+      return Seconds (0);
+    }
+  Reconcile ();
+  std::map<Ipv4Address, Backlog>::const_iterator i = m_perDst.find (dst);
+  if (i == m_perDst.end ())
+    {
+      return Seconds (0);
+    }
+  return GetTxTime (dev, GetSmoothedBytes (i->second));
+}
+
+void
+BacklogMonitor::QueueDiscEnqueue (Ptr<const QueueDiscItem> item)
+{
+  Ptr<const Ipv4QueueDiscItem> ipv4Item = DynamicCast<const Ipv4QueueDiscItem> (item);
+  if (ipv4Item != 0)
+    {
+      Account (ipv4Item->GetHeader ().GetDestination (), item->GetSize (), true);
+    }
+}
+
+void
+BacklogMonitor::QueueDiscDequeue (Ptr<const QueueDiscItem> item)
+{
+  Ptr<const Ipv4QueueDiscItem> ipv4Item = DynamicCast<const Ipv4QueueDiscItem> (item);
+  if (ipv4Item != 0)
+    {
+      Account (ipv4Item->GetHeader ().GetDestination (), item->GetSize (), false);
+    }
+}
+
+void
+BacklogMonitor::QueueDiscDropAfterDequeue (Ptr<const QueueDiscItem> item, const char* reason)
+{
+  QueueDiscDequeue (item);
+}
+
+bool
+BacklogMonitor::GetDestination (Ptr<const WifiMacQueueItem> item, Ipv4Address &dst)
+{
+  Ptr<Packet> packet = item->GetPacket ()->Copy ();
+  LlcSnapHeader llc;
+  if (packet->GetSize () < llc.GetSerializedSize ())
+    {
+      return false;
+    }
+  packet->RemoveHeader (llc);
+  if (llc.GetType () != Ipv4L3Protocol::PROT_NUMBER)
+    {
+      return false;
+    }
+  Ipv4Header ipv4Header;
+  packet->PeekHeader (ipv4Header);
+  dst = ipv4Header.GetDestination ();
+  return true;
+}
+
+void
+BacklogMonitor::MacQueueEnqueue (Ptr<const WifiMacQueueItem> item)
+{
+  Ipv4Address dst;
+  if (GetDestination (item, dst))
+    {
+      Account (dst, item->GetPacket ()->GetSize (), true);
+    }
+}
+
+void
+BacklogMonitor::MacQueueDequeue (Ptr<const WifiMacQueueItem> item)
+{
+  Ipv4Address dst;
+  if (GetDestination (item, dst))
+    {
+      Account (dst, item->GetPacket ()->GetSize (), false);
+    }
+}
+
+}
+}
@@ -0,0 +1,343 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#ifndef OLSB_BACKLOG_MONITOR_H
+#define OLSB_BACKLOG_MONITOR_H
+
+#include <map>
+#include <vector>
+#include "ns3/ipv4-address.h"
+#include "ns3/net-device.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/queue-disc.h"
+#include "ns3/wifi-mac-queue.h"
+
+namespace ns3 {
+namespace olsb {
+/**
+ * \ingroup olsb
+ * \brief Source of the queue metric advertised in OLSB updates
+ */
+enum QueueMetricSource
+{
+  ROUTE_BUFFER = 0,     // !< packets waiting for a route (PacketQueue)
+  QUEUE_DISC = 1,     // !< root traffic control queue disc of the interface
+  MAC_QUEUE = 2,     // !< Wi-Fi MAC queue of the interface
+  EGRESS = 3,     // !< queue disc and Wi-Fi MAC queue together
+};
+
+/**
+ * \ingroup olsb
+ * \brief Egress backlog of the OLSB interfaces
+ *
+ * The backlog that OLSB uses for backpressure is the traffic waiting to leave the node on an
+ * interface: the root queue disc installed by the traffic control layer and, for Wi-Fi devices,
+ * the MAC queue. Queues are looked up lazily because the default queue disc is only installed
+ * after the interface has been brought up.
+ *
+ * Besides the totals read from the queues, the monitor follows their enqueue and dequeue traces
+ * to keep the backlog per IPv4 destination (per commodity), so that a node can advertise how much
+ * traffic it holds towards each destination rather than one node-wide value.
+ *
+ * The traced backlogs are also smoothed by an exponentially weighted moving average. The backlog
+ * is piecewise constant between enqueue and dequeue events, so the average is updated on every
+ * event and aged in continuous time: after dt it keeps a weight of exp(-dt/TimeConstant).
+ */
+class BacklogMonitor
+{
+public:
+  /// c-tor
+  BacklogMonitor ();
+  /// Disconnect from the traces of all queues
+  void
+  Dispose ();
+  /**
+   * Start monitoring the egress queues of a device
+   * \param dev the net device
+   */
+  void
+  AddDevice (Ptr<NetDevice> dev);
+  /**
+   * Stop monitoring the egress queues of a device
+   * \param dev the net device
+   */
+  void
+  RemoveDevice (Ptr<NetDevice> dev);
+  /**
+   * Get the number of packets waiting on the egress queues of a device
+   * \param dev the net device
+   * \returns the number of packets
+   */
+  uint32_t
+  GetBacklogPackets (Ptr<NetDevice> dev);
+  /**
+   * Get the number of bytes waiting on the egress queues of a device
+   * \param dev the net device
+   * \returns the number of bytes
+   */
+  uint32_t
+  GetBacklogBytes (Ptr<NetDevice> dev);
+  /**
+   * Get the number of packets waiting on the queue disc and the MAC queue of a device, whatever the source
+   * of the queue metric and whether the device is monitored
+   * \param dev the net device
+   * \returns the number of packets
+   */
+  uint32_t
+  GetEgressPackets (Ptr<NetDevice> dev);
+  /**
+   * Get the time the device needs to drain its egress backlog at its data rate
+   * \param dev the net device
+   * \returns the time to drain
+   */
+  Time
+  GetDrainTime (Ptr<NetDevice> dev);
+  /**
+   * Get the number of packets towards a destination waiting on the egress queues of the node
+   * \param dst the destination IPv4 address
+   * \returns the number of packets
+   */
+  uint32_t
+  GetBacklogPackets (Ipv4Address dst) const;
+  /**
+   * Get the number of bytes towards a destination waiting on the egress queues of the node
+   * \param dst the destination IPv4 address
+   * \returns the number of bytes
+   */
+  uint32_t
+  GetBacklogBytes (Ipv4Address dst) const;
+  /**
+   * Get the time a device needs to drain the backlog towards a destination at its data rate
+   * \param dev the net device
+   * \param dst the destination IPv4 address
+   * \returns the time to drain
+   */
+  Time
+  GetDrainTime (Ptr<NetDevice> dev, Ipv4Address dst);
+  /**
+   * Get the time a device needs to drain the smoothed backlog of the node
+   * \param dev the net device
+   * \returns the time to drain
+   */
+  Time
+  GetSmoothedDrainTime (Ptr<NetDevice> dev);
+  /**
+   * Get the time a device needs to drain the smoothed backlog towards a destination
+   * \param dev the net device
+   * \param dst the destination IPv4 address
+   * \returns the time to drain
+   */
+  Time
+  GetSmoothedDrainTime (Ptr<NetDevice> dev, Ipv4Address dst);
+  /**
+   * Set the time constant of the moving average
+   * \param tau the time constant, zero disables smoothing
+   */
+  void
+  SetTimeConstant (Time tau)
+  {
+    m_timeConstant = tau;
+  }
+  /**
+   * Get the time constant of the moving average
+   * \returns the time constant
+   */
+  Time
+  GetTimeConstant () const
+  {
+    return m_timeConstant;
+  }
+  /**
+   * Set which queues contribute to the backlog
+   * \param source the queue metric source
+   */
+  void
+  SetSource (QueueMetricSource source)
+  {
+    m_source = source;
+  }
+  /**
+   * Get which queues contribute to the backlog
+   * \returns the queue metric source
+   */
+  QueueMetricSource
+  GetSource () const
+  {
+    return m_source;
+  }
+  /**
+   * Set the data rate used for devices whose rate cannot be detected
+   * \param rate the data rate
+   */
+  void
+  SetDefaultDataRate (DataRate rate)
+  {
+    m_defaultDataRate = rate;
+  }
+  /**
+   * Get the data rate used for devices whose rate cannot be detected
+   * \returns the data rate
+   */
+  DataRate
+  GetDefaultDataRate () const
+  {
+    return m_defaultDataRate;
+  }
+  /**
+   * Get the data rate of a device
+   * \param dev the net device
+   * \returns the data rate
+   */
+  DataRate
+  GetDataRate (Ptr<NetDevice> dev);
+
+private:
+  /// Backlog towards one destination
+  struct Backlog
+  {
+    /// c-tor
+    Backlog ();
+    uint32_t packets; ///< number of packets
+    uint32_t bytes; ///< number of bytes
+    double smoothedBytes; ///< moving average of bytes, aged up to lastChange
+    Time lastChange; ///< time of the last enqueue or dequeue
+  };
+  /// Egress queues of a monitored device
+  struct DeviceQueues
+  {
+    Ptr<QueueDisc> queueDisc; ///< root queue disc, if any
+    Ptr<WifiMacQueue> macQueue; ///< Wi-Fi MAC queue, if any
+    DataRate rate; ///< data rate, zero if not yet detected
+  };
+  /**
+   * Look up the queues of a device that were not found yet
+   * \param dev the net device
+   * \returns the queues of the device, or 0 if the device is not monitored
+   */
+  DeviceQueues *
+  Resolve (Ptr<NetDevice> dev);
+  /**
+   * Look up the egress queues of a device that are missing from a set of queues
+   * \param dev the net device
+   * \param queues the queues of the device
+   */
+  static void
+  FindQueues (Ptr<NetDevice> dev, DeviceQueues &queues);
+  /**
+   * Account a packet entering or leaving an egress queue
+   * \param dst the destination IPv4 address of the packet
+   * \param bytes the size of the packet
+   * \param enqueued true if the packet entered the queue
+   */
+  void
+  Account (Ipv4Address dst, uint32_t bytes, bool enqueued);
+  /**
+   * Get the moving average of a backlog aged up to now
+   * \param backlog the backlog
+   * \returns the smoothed number of bytes
+   */
+  double
+  GetSmoothedBytes (const Backlog &backlog) const;
+  /**
+   * Age the moving average of a backlog and apply an enqueue or dequeue
+   * \param backlog the backlog
+   * \param bytes the size of the packet
+   * \param enqueued true if the packet entered the queue
+   */
+  void
+  Change (Backlog &backlog, uint32_t bytes, bool enqueued);
+  /**
+   * Get the time a device needs to transmit a number of bytes
+   * \param dev the net device
+   * \param bytes the number of bytes
+   * \returns the transmission time
+   */
+  Time
+  GetTxTime (Ptr<NetDevice> dev, double bytes);
+  /**
+   * Trace sink for packets entering the queue disc
+   * \param item the queue disc item
+   */
+  void
+  QueueDiscEnqueue (Ptr<const QueueDiscItem> item);
+  /**
+   * Trace sink for packets leaving the queue disc
+   * \param item the queue disc item
+   */
+  void
+  QueueDiscDequeue (Ptr<const QueueDiscItem> item);
+  /**
+   * Trace sink for packets dropped by the queue disc after they were dequeued
+   * \param item the queue disc item
+   * \param reason the drop reason
+   */
+  void
+  QueueDiscDropAfterDequeue (Ptr<const QueueDiscItem> item, const char* reason);
+  /**
+   * Trace sink for packets entering the Wi-Fi MAC queue
+   * \param item the Wi-Fi MAC queue item
+   */
+  void
+  MacQueueEnqueue (Ptr<const WifiMacQueueItem> item);
+  /**
+   * Trace sink for packets leaving the Wi-Fi MAC queue
+   * \param item the Wi-Fi MAC queue item
+   */
+  void
+  MacQueueDequeue (Ptr<const WifiMacQueueItem> item);
+  /**
+   * Get the IPv4 destination of a packet waiting in the Wi-Fi MAC queue
+   * \param item the Wi-Fi MAC queue item
+   * \param dst the destination IPv4 address, if any
+   * \returns true if the item carries an IPv4 packet
+   */
+  static bool
+  GetDestination (Ptr<const WifiMacQueueItem> item, Ipv4Address &dst);
+  /// Reset the traced backlogs once all egress queues are empty and forget averages that decayed
+  void
+  Reconcile ();
+  /// monitored devices
+  std::map<Ptr<NetDevice>, DeviceQueues> m_devices;
+  /// which queues contribute to the backlog
+  QueueMetricSource m_source;
+  /// data rate used if the rate of a device cannot be detected
+  DataRate m_defaultDataRate;
+  /// backlog per destination over all egress queues of the node
+  std::map<Ipv4Address, Backlog> m_perDst;
+  /// traced backlog of the node over all destinations
+  Backlog m_total;
+  /// time constant of the moving average
+  Time m_timeConstant;
+  /// queue discs whose traces are connected
+  std::vector<Ptr<QueueDisc> > m_tracedQueueDiscs;
+  /// Wi-Fi MAC queues whose traces are connected
+  std::vector<Ptr<WifiMacQueue> > m_tracedMacQueues;
+};
+
+}
+}
+
+#endif /* OLSB_BACKLOG_MONITOR_H */
@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#include "olsb-backpressure-scheduler.h"
+#include <algorithm>
+#include <limits>
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OlsbBackpressureScheduler");
+
+namespace olsb {
+BackpressureScheduler::BackpressureScheduler ()
+  : m_backlogLifetime (Seconds (1))
+{
+}
+
+void
+BackpressureScheduler::UpdateNeighborBacklog (Ipv4Address neighbor, const std::map<Ipv4Address, uint32_t> &backlogs)
+{
+  Advertisement &advertisement = m_neighbors[neighbor];
+  advertisement.backlogs = backlogs;
+  advertisement.received = Simulator::Now ();
+}
+
+uint32_t
+BackpressureScheduler::GetNeighborBacklog (Ipv4Address neighbor, Ipv4Address dst) const
+{
+  if (neighbor == dst)
+    {
+      return 0;
+    }
+  std::map<Ipv4Address, Advertisement>::const_iterator i = m_neighbors.find (neighbor);
+  if (i == m_neighbors.end () || Simulator::Now () - i->second.received > m_backlogLifetime)
+    {
+      return 0;
+    }
+  std::map<Ipv4Address, uint32_t>::const_iterator j = i->second.backlogs.find (dst);
+  return j != i->second.backlogs.end () ? j->second : 0;
+}
+
+void
+BackpressureScheduler::Clear ()
+{
+  m_neighbors.clear ();
+}
+
+bool
+BackpressureScheduler::Select (const std::map<Ipv4Address, uint32_t> &backlogs,
+                               const std::map<Ipv4Address, std::map<Ipv4Address, uint32_t> > &distances,
+                               double shortestPathFactor, double backpressureFactor,
+                               Ipv4Address &dst, Ipv4Address &neighbor) const
+{
+  double bestWeight = 0;
+  bool found = false;
+  for (std::map<Ipv4Address, uint32_t>::const_iterator c = backlogs.begin (); c != backlogs.end (); ++c)
+    {
+      std::map<Ipv4Address, std::map<Ipv4Address, uint32_t> >::const_iterator d = distances.find (c->first);
+      if (c->second == 0 || d == distances.end () || d->second.empty ())
+        {
+          continue;
+        }
+      // The local distance is one hop more than that of the closest neighbor
+      uint32_t hops = std::numeric_limits<uint32_t>::max ();
+      for (std::map<Ipv4Address, uint32_t>::const_iterator n = d->second.begin (); n != d->second.end (); ++n)
+        {
+          hops = std::min (hops, n->second + 1);
+        }
+      for (std::map<Ipv4Address, uint32_t>::const_iterator n = d->second.begin (); n != d->second.end (); ++n)
+        {
+          uint32_t neighborHops = (n->first == c->first) ? 0 : n->second;
+          double weight = backpressureFactor * ((double) c->second - (double) GetNeighborBacklog (n->first,c->first))
+            + shortestPathFactor * ((double) hops - (double) neighborHops);
+          NS_LOG_LOGIC ("Commodity " << c->first << " via " << n->first << ": weight " << weight);
+          if (weight > bestWeight)
+            {
+              bestWeight = weight;
+              dst = c->first;
+              neighbor = n->first;
+              found = true;
+            }
+        }
+    }
+  return found;
+}
+
+}
+}
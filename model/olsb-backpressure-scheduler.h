@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#ifndef OLSB_BACKPRESSURE_SCHEDULER_H
+#define OLSB_BACKPRESSURE_SCHEDULER_H
+
+#include <map>
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+namespace olsb {
+/**
+ * \ingroup olsb
+ * \brief How transit packets are forwarded
+ */
+enum ForwardingMode
+{
+  ROUTED,       //!< Every packet follows the next hop installed by the route updates
+  BACKPRESSURE, //!< Packets wait in per-destination queues and are served by max-weight backpressure
+};
+
+/**
+ * \ingroup olsb
+ * \brief Max-weight choice of the commodity and neighbor served at a transmit opportunity
+ *
+ * A commodity is the set of packets towards one destination. The weight of sending a packet of
+ * commodity c to neighbor n is
+ *
+ *   BackpressureFactor * (Q(c) - Q(n, c)) + ShortestPathFactor * (H(c) - H(n, c))
+ *
+ * where Q(c) is the local backlog of c, Q(n, c) the backlog that n advertised for c, H(c) the local
+ * distance to the destination in hops and H(n, c) that of n. A neighbor that is the destination has
+ * no backlog and no distance. The shortest path term keeps packets on short routes while queues are
+ * small; the backpressure term spreads them over longer routes as queues build up. Only pairs with a
+ * positive weight are served.
+ */
+class BackpressureScheduler
+{
+public:
+  /// c-tor
+  BackpressureScheduler ();
+  /**
+   * Replace the backlogs advertised by a neighbor
+   * \param neighbor the neighbor
+   * \param backlogs the backlog per destination, destinations left out have no backlog
+   */
+  void
+  UpdateNeighborBacklog (Ipv4Address neighbor, const std::map<Ipv4Address, uint32_t> &backlogs);
+  /**
+   * Get the backlog that a neighbor advertised for a destination
+   * \param neighbor the neighbor
+   * \param dst the destination
+   * \returns the backlog, 0 if the neighbor is the destination or its advertisement expired
+   */
+  uint32_t
+  GetNeighborBacklog (Ipv4Address neighbor, Ipv4Address dst) const;
+  /// Forget the backlogs of all neighbors
+  void
+  Clear ();
+  /**
+   * Choose the commodity and neighbor with the largest positive weight
+   * \param backlogs the local backlog per destination
+   * \param distances per destination, the distance in hops from every eligible neighbor to it
+   * \param shortestPathFactor the shortest path factor
+   * \param backpressureFactor the backpressure factor
+   * \param dst the destination chosen
+   * \param neighbor the neighbor chosen
+   * \returns true if some pair has a positive weight
+   */
+  bool
+  Select (const std::map<Ipv4Address, uint32_t> &backlogs,
+          const std::map<Ipv4Address, std::map<Ipv4Address, uint32_t> > &distances,
+          double shortestPathFactor, double backpressureFactor, Ipv4Address &dst, Ipv4Address &neighbor) const;
+  /**
+   * Set the time after which the backlogs advertised by a neighbor are ignored
+   * \param lifetime the lifetime
+   */
+  void
+  SetBacklogLifetime (Time lifetime)
+  {
+    m_backlogLifetime = lifetime;
+  }
+  /**
+   * Get the time after which the backlogs advertised by a neighbor are ignored
+   * \returns the lifetime
+   */
+  Time
+  GetBacklogLifetime () const
+  {
+    return m_backlogLifetime;
+  }
+
+private:
+  /// Last backlog advertisement of a neighbor
+  struct Advertisement
+  {
+    /// backlog per destination
+    std::map<Ipv4Address, uint32_t> backlogs;
+    /// time of the advertisement
+    Time received;
+  };
+  /// Last advertisement of every neighbor
+  std::map<Ipv4Address, Advertisement> m_neighbors;
+  /// Time after which an advertisement is ignored
+  Time m_backlogLifetime;
+};
+
+}
+}
+
+#endif /* OLSB_BACKPRESSURE_SCHEDULER_H */
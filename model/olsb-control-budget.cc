@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "olsb-control-budget.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OlsbControlBudget");
+
+namespace olsb {
+
+ControlBudget::ControlBudget ()
+  : m_rate (0),
+    m_burst (8192),
+    m_tokens (8192),
+    m_sentBytes (0)
+{
+}
+
+void
+ControlBudget::Refill ()
+{
+  Time now = Simulator::Now ();
+  m_tokens = std::min (m_tokens + m_rate * (now - m_lastRefill).GetSeconds (),m_burst);
+  m_lastRefill = now;
+}
+
+double
+ControlBudget::GetAvailable ()
+{
+  Refill ();
+  return m_tokens;
+}
+
+void
+ControlBudget::Charge (uint32_t bytes)
+{
+  Refill ();
+  m_tokens -= bytes;
+  m_sentBytes += bytes;
+  NS_LOG_LOGIC ("Charged " << bytes << " bytes, " << m_tokens << " left");
+}
+
+Time
+ControlBudget::GetDelay (uint32_t bytes)
+{
+  Refill ();
+  if (!IsLimited () || m_tokens >= bytes)
+    {
+      return Seconds (0);
+    }
+  return MicroSeconds (std::ceil ((bytes - m_tokens) / m_rate * 1e6));
+}
+
+void
+ControlBudget::Defer (uint32_t priority, uint32_t records)
+{
+  if (priority >= m_deferred.size ())
+    {
+      m_deferred.resize (priority + 1, 0);
+    }
+  m_deferred[priority] += records;
+}
+
+uint32_t
+ControlBudget::GetDeferred (uint32_t priority) const
+{
+  return priority < m_deferred.size () ? m_deferred[priority] : 0;
+}
+
+void
+ControlBudget::Reset ()
+{
+  m_tokens = m_burst;
+  m_lastRefill = Simulator::Now ();
+  m_sentBytes = 0;
+  m_deferred.clear ();
+}
+
+}
+}
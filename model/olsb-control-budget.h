@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#ifndef OLSB_CONTROL_BUDGET_H
+#define OLSB_CONTROL_BUDGET_H
+
+#include <vector>
+#include "ns3/nstime.h"
+
+namespace ns3 {
+namespace olsb {
+/**
+ * \ingroup olsb
+ * \brief Token bucket that bounds the rate of control bytes a node sends
+ *
+ * Tokens are bytes. They accumulate at the configured rate up to the burst size, and every control
+ * packet sent takes its size out of the bucket. Updates that cannot wait, like periodic updates,
+ * are charged even when the bucket is empty and leave it in debt, which holds back the triggered
+ * updates that follow. The bucket also counts the records of triggered updates deferred for lack
+ * of budget, per priority.
+ */
+class ControlBudget
+{
+public:
+  /// c-tor
+  ControlBudget ();
+  /**
+   * Get the bytes that can be sent now
+   * \returns the tokens in the bucket, negative while in debt
+   */
+  double
+  GetAvailable ();
+  /**
+   * Take sent bytes out of the bucket
+   * \param bytes the size of the control packet
+   */
+  void
+  Charge (uint32_t bytes);
+  /**
+   * Get the time until the bucket holds enough tokens
+   * \param bytes the size of the control packets to send
+   * \returns the time until they can be sent, 0 if they can be sent now
+   */
+  Time
+  GetDelay (uint32_t bytes);
+  /**
+   * Count records that were not sent for lack of budget
+   * \param priority the priority of the records, 0 being the highest
+   * \param records the number of records
+   */
+  void
+  Defer (uint32_t priority, uint32_t records);
+  /**
+   * Get the number of records deferred
+   * \param priority the priority of the records
+   * \returns the number of records of that priority deferred so far
+   */
+  uint32_t
+  GetDeferred (uint32_t priority) const;
+  /**
+   * Get the number of control bytes sent
+   * \returns the bytes charged so far
+   */
+  uint64_t
+  GetSentBytes () const
+  {
+    return m_sentBytes;
+  }
+  /**
+   * Check whether the rate is bounded
+   * \returns false if the rate is 0, which leaves control traffic unbounded
+   */
+  bool
+  IsLimited () const
+  {
+    return m_rate > 0;
+  }
+  /**
+   * Set the rate at which tokens accumulate
+   * \param rate the rate in bytes per second, 0 for no bound
+   */
+  void
+  SetRate (double rate)
+  {
+    m_rate = rate;
+  }
+  /**
+   * Set the largest number of tokens in the bucket
+   * \param burst the burst size in bytes
+   */
+  void
+  SetBurst (uint32_t burst)
+  {
+    m_burst = burst;
+  }
+  /// Fill the bucket and reset the counters
+  void
+  Reset ();
+
+private:
+  /// Add the tokens accumulated since the last refill
+  void
+  Refill ();
+  /// rate at which tokens accumulate, in bytes per second
+  double m_rate;
+  /// largest number of tokens
+  double m_burst;
+  /// tokens in the bucket, negative while in debt
+  double m_tokens;
+  /// time of the last refill
+  Time m_lastRefill;
+  /// bytes charged
+  uint64_t m_sentBytes;
+  /// records deferred per priority
+  std::vector<uint32_t> m_deferred;
+};
+
+}
+}
+
+#endif /* OLSB_CONTROL_BUDGET_H */
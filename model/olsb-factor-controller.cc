@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#include "olsb-factor-controller.h"
+#include <algorithm>
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OlsbFactorController");
+
+namespace olsb {
+FactorController::FactorController ()
+  : m_sum (1),
+    m_share (0.5),
+    m_step (0.05),
+    m_minShare (0.1),
+    m_maxShare (0.9),
+    m_maxRouteChangeRate (1),
+    m_deadband (0.001)
+{
+}
+
+void
+FactorController::Reset (double shortestPathFactor, double backpressureFactor)
+{
+  m_sum = shortestPathFactor + backpressureFactor;
+  if (m_sum <= 0)
+    {
+      // Nothing to share, start from the original OLSB pair
+      m_sum = 1;
+      m_share = 0.5;
+    }
+  else
+    {
+      m_share = backpressureFactor / m_sum;
+    }
+  m_share = std::min (std::max (m_share, m_minShare), m_maxShare);
+}
+
+bool
+FactorController::Update (Time interval, double backlogTrend, uint32_t drops, uint32_t routeChanges)
+{
+  double delta = 0;
+  if (routeChanges > m_maxRouteChangeRate * interval.GetSeconds ())
+    {
+      delta = -m_step;
+    }
+  else if (drops > 0 || backlogTrend > m_deadband)
+    {
+      delta = m_step;
+    }
+  else if (backlogTrend < -m_deadband)
+    {
+      delta = -m_step / 2;
+    }
+  double share = std::min (std::max (m_share + delta, m_minShare), m_maxShare);
+  NS_LOG_LOGIC ("Backlog trend " << backlogTrend << "s, " << drops << " drops, " << routeChanges
+                                 << " route changes: backpressure share " << m_share << " -> " << share);
+  if (share == m_share)
+    {
+      return false;
+    }
+  m_share = share;
+  return true;
+}
+
+}
+}
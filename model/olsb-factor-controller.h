@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#ifndef OLSB_FACTOR_CONTROLLER_H
+#define OLSB_FACTOR_CONTROLLER_H
+
+#include "ns3/nstime.h"
+
+namespace ns3 {
+namespace olsb {
+/**
+ * \ingroup olsb
+ * \brief Online tuning of the shortest path and backpressure factors
+ *
+ * The controller keeps the sum of the two factors constant and moves the share of the
+ * backpressure factor by at most one step per adaptation interval, within configured bounds:
+ *
+ * - if routes changed more often than MaxRouteChangeRate, the backlog terms are making the
+ *   routes oscillate, so the share moves towards shortest path;
+ * - otherwise, if packets were dropped or the backlog grew, the share moves towards backpressure;
+ * - otherwise, if the backlog shrank, the share moves back towards shortest path by half a step,
+ *   since short paths give the lowest delay once the load subsides.
+ *
+ * Backlog trends within the deadband are treated as noise and leave the share unchanged, so that
+ * a steady load does not make the share hunt around its operating point.
+ */
+class FactorController
+{
+public:
+  /// c-tor
+  FactorController ();
+  /**
+   * Restart from a pair of factors
+   * \param shortestPathFactor the shortest path factor
+   * \param backpressureFactor the backpressure factor
+   */
+  void
+  Reset (double shortestPathFactor, double backpressureFactor);
+  /**
+   * Adapt the factors to the signals observed over the last interval
+   * \param interval the length of the interval
+   * \param backlogTrend the change of the local backlog over the interval, in seconds to drain
+   * \param drops the number of packets dropped over the interval
+   * \param routeChanges the number of next hop changes over the interval
+   * \returns true if the factors changed
+   */
+  bool
+  Update (Time interval, double backlogTrend, uint32_t drops, uint32_t routeChanges);
+  /**
+   * Get the shortest path factor
+   * \returns the shortest path factor
+   */
+  double
+  GetShortestPathFactor () const
+  {
+    return m_sum * (1 - m_share);
+  }
+  /**
+   * Get the backpressure factor
+   * \returns the backpressure factor
+   */
+  double
+  GetBackpressureFactor () const
+  {
+    return m_sum * m_share;
+  }
+  /**
+   * Set the largest change of the backpressure share per interval
+   * \param step the step
+   */
+  void
+  SetStep (double step)
+  {
+    m_step = step;
+  }
+  /**
+   * Set the bounds of the backpressure share
+   * \param minShare the smallest share
+   * \param maxShare the largest share
+   */
+  void
+  SetShareBounds (double minShare, double maxShare)
+  {
+    m_minShare = minShare;
+    m_maxShare = maxShare;
+  }
+  /**
+   * Set the rate of route changes above which routes are considered oscillating
+   * \param rate the rate in changes per second
+   */
+  void
+  SetMaxRouteChangeRate (double rate)
+  {
+    m_maxRouteChangeRate = rate;
+  }
+  /**
+   * Set the backlog trend below which the share is kept
+   * \param deadband the deadband in seconds to drain
+   */
+  void
+  SetDeadband (double deadband)
+  {
+    m_deadband = deadband;
+  }
+
+private:
+  /// sum of the two factors
+  double m_sum;
+  /// share of the backpressure factor in the sum
+  double m_share;
+  /// largest change of the share per interval
+  double m_step;
+  /// smallest share
+  double m_minShare;
+  /// largest share
+  double m_maxShare;
+  /// rate of route changes above which routes are considered oscillating, per second
+  double m_maxRouteChangeRate;
+  /// backlog trend below which the share is kept, in seconds to drain
+  double m_deadband;
+};
+
+}
+}
+
+#endif /* OLSB_FACTOR_CONTROLLER_H */
@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#include "olsb-link-estimator.h"
+#include <algorithm>
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OlsbLinkEstimator");
+
+namespace olsb {
+
+const uint32_t LinkEstimator::ETX_SCALE;
+const uint32_t LinkEstimator::MAX_ETX;
+
+LinkEstimator::LinkEstimator ()
+  : m_windowSize (10),
+    m_updateInterval (Seconds (15))
+{
+}
+
+void
+LinkEstimator::NotifyUpdate (Ipv4Address neighbor, uint32_t seqNo)
+{
+  std::map<Ipv4Address, LinkHistory>::iterator i = m_links.find (neighbor);
+  if (i == m_links.end ())
+    {
+      LinkHistory history;
+      history.lastSeqNo = seqNo;
+      history.lastReception = Simulator::Now ();
+      history.received.push_back (true);
+      m_links.insert (std::make_pair (neighbor,history));
+      return;
+    }
+  LinkHistory &history = i->second;
+  if (seqNo == history.lastSeqNo)
+    {
+      // Triggered updates repeat the sequence number of the last periodic update
+      return;
+    }
+  if (seqNo < history.lastSeqNo)
+    {
+      NS_LOG_DEBUG ("Sequence number of " << neighbor << " went back, restarting its link history");
+      history.received.clear ();
+    }
+  else
+    {
+      // Own sequence numbers grow by two per periodic update
+      uint32_t missed = std::min (std::max ((seqNo - history.lastSeqNo) / 2, 1u), m_windowSize) - 1;
+      for (uint32_t k = 0; k < missed; k++)
+        {
+          history.received.push_back (false);
+        }
+    }
+  history.received.push_back (true);
+  while (history.received.size () > m_windowSize)
+    {
+      history.received.pop_front ();
+    }
+  history.lastSeqNo = seqNo;
+  history.lastReception = Simulator::Now ();
+}
+
+double
+LinkEstimator::GetDeliveryRatio (Ipv4Address neighbor) const
+{
+  std::map<Ipv4Address, LinkHistory>::const_iterator i = m_links.find (neighbor);
+  if (i == m_links.end ())
+    {
+      return 1.0;
+    }
+  const LinkHistory &history = i->second;
+  uint32_t received = std::count (history.received.begin (), history.received.end (), true);
+  uint32_t expected = history.received.size ();
+  if (m_updateInterval.IsStrictlyPositive ())
+    {
+      // Periodic updates are jittered, so only count an update as lost once a whole interval is overdue
+      uint64_t overdue = (Simulator::Now () - history.lastReception).GetNanoSeconds () / m_updateInterval.GetNanoSeconds ();
+      if (overdue > 1)
+        {
+          expected += std::min<uint64_t> (overdue - 1, m_windowSize);
+        }
+    }
+  if (expected > m_windowSize)
+    {
+      // Overdue updates push the oldest receptions out of the window
+      uint32_t shifted = expected - m_windowSize;
+      uint32_t oldestReceived = std::count (history.received.begin (),
+                                            history.received.begin () + std::min<uint32_t> (shifted, history.received.size ()),
+                                            true);
+      received -= oldestReceived;
+      expected = m_windowSize;
+    }
+  return static_cast<double> (received) / expected;
+}
+
+uint32_t
+LinkEstimator::GetEtx (Ipv4Address neighbor) const
+{
+  double ratio = GetDeliveryRatio (neighbor);
+  if (ratio <= 0)
+    {
+      return MAX_ETX;
+    }
+  double etx = ETX_SCALE / (ratio * ratio);
+  return std::min (static_cast<uint32_t> (etx + 0.5), MAX_ETX);
+}
+
+void
+LinkEstimator::DeleteNeighbor (Ipv4Address neighbor)
+{
+  m_links.erase (neighbor);
+}
+
+}
+}
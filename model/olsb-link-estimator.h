@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#ifndef OLSB_LINK_ESTIMATOR_H
+#define OLSB_LINK_ESTIMATOR_H
+
+#include <deque>
+#include <map>
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+namespace olsb {
+/**
+ * \ingroup olsb
+ * \brief Per neighbor link quality estimator
+ *
+ * Every periodic update of a neighbor carries its own record with a sequence number that grows by
+ * two per update, so gaps in that sequence tell how many periodic updates were lost. The estimator
+ * keeps, for every neighbor, a sliding window over the last periodic updates that the neighbor
+ * sent and derives the delivery ratio d from it. Updates that are overdue also count as lost, so
+ * a neighbor that went silent degrades before its routes are purged.
+ *
+ * Links are assumed symmetric, so the expected transmission count is ETX = 1 / (d * d). ETX values
+ * are fixed point numbers scaled by ETX_SCALE, as carried in OLSB updates.
+ */
+class LinkEstimator
+{
+public:
+  /// Scale of the fixed point ETX values
+  static const uint32_t ETX_SCALE = 100;
+  /// Largest ETX, reported for neighbors without any received update in the window
+  static const uint32_t MAX_ETX = 100 * ETX_SCALE;
+
+  /// c-tor
+  LinkEstimator ();
+  /**
+   * Account a periodic update received from a neighbor
+   * \param neighbor the neighbor IPv4 address
+   * \param seqNo the sequence number of the neighbor's own record
+   */
+  void
+  NotifyUpdate (Ipv4Address neighbor, uint32_t seqNo);
+  /**
+   * Get the delivery ratio of the link from a neighbor
+   * \param neighbor the neighbor IPv4 address
+   * \returns the delivery ratio, 1 for unknown neighbors
+   */
+  double
+  GetDeliveryRatio (Ipv4Address neighbor) const;
+  /**
+   * Get the expected transmission count of the link to a neighbor
+   * \param neighbor the neighbor IPv4 address
+   * \returns the ETX scaled by ETX_SCALE, ETX_SCALE for unknown neighbors
+   */
+  uint32_t
+  GetEtx (Ipv4Address neighbor) const;
+  /**
+   * Forget a neighbor
+   * \param neighbor the neighbor IPv4 address
+   */
+  void
+  DeleteNeighbor (Ipv4Address neighbor);
+  /// Forget all neighbors
+  void
+  Clear ()
+  {
+    m_links.clear ();
+  }
+  /**
+   * Set the number of periodic updates in the sliding window
+   * \param window the window size
+   */
+  void
+  SetWindowSize (uint32_t window)
+  {
+    m_windowSize = window;
+  }
+  /**
+   * Get the number of periodic updates in the sliding window
+   * \returns the window size
+   */
+  uint32_t
+  GetWindowSize () const
+  {
+    return m_windowSize;
+  }
+  /**
+   * Set the interval at which neighbors send periodic updates
+   * \param interval the periodic update interval
+   */
+  void
+  SetUpdateInterval (Time interval)
+  {
+    m_updateInterval = interval;
+  }
+  /**
+   * Get the interval at which neighbors send periodic updates
+   * \returns the periodic update interval
+   */
+  Time
+  GetUpdateInterval () const
+  {
+    return m_updateInterval;
+  }
+
+private:
+  /// Reception history of one neighbor
+  struct LinkHistory
+  {
+    uint32_t lastSeqNo; ///< last sequence number received
+    Time lastReception; ///< time of the last reception
+    std::deque<bool> received; ///< reception of the last periodic updates, oldest first
+  };
+  /// reception history per neighbor
+  std::map<Ipv4Address, LinkHistory> m_links;
+  /// number of periodic updates in the sliding window
+  uint32_t m_windowSize;
+  /// interval at which neighbors send periodic updates
+  Time m_updateInterval;
+};
+
+}
+}
+
+#endif /* OLSB_LINK_ESTIMATOR_H */
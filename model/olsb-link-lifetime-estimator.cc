@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#include "olsb-link-lifetime-estimator.h"
+#include <cmath>
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OlsbLinkLifetimeEstimator");
+
+namespace olsb {
+
+LinkLifetimeEstimator::LinkLifetimeEstimator ()
+  : m_range (250)
+{
+}
+
+void
+LinkLifetimeEstimator::UpdateNeighbor (Ipv4Address neighbor, const Vector &position, const Vector &velocity)
+{
+  MobilityReport &report = m_neighbors[neighbor];
+  report.position = position;
+  report.velocity = velocity;
+  report.reception = Simulator::Now ();
+}
+
+Time
+LinkLifetimeEstimator::GetLinkLifetime (Ipv4Address neighbor, const Vector &position, const Vector &velocity) const
+{
+  std::map<Ipv4Address, MobilityReport>::const_iterator i = m_neighbors.find (neighbor);
+  if (i == m_neighbors.end ())
+    {
+      return Time::Max ();
+    }
+  const MobilityReport &report = i->second;
+  double age = (Simulator::Now () - report.reception).GetSeconds ();
+  double dx = report.position.x + report.velocity.x * age - position.x;
+  double dy = report.position.y + report.velocity.y * age - position.y;
+  double dz = report.position.z + report.velocity.z * age - position.z;
+  double dvx = report.velocity.x - velocity.x;
+  double dvy = report.velocity.y - velocity.y;
+  double dvz = report.velocity.z - velocity.z;
+  double a = dvx * dvx + dvy * dvy + dvz * dvz;
+  double b = dx * dvx + dy * dvy + dz * dvz;
+  double c = dx * dx + dy * dy + dz * dz - m_range * m_range;
+  if (c >= 0)
+    {
+      NS_LOG_LOGIC (neighbor << " is already out of range");
+      return Seconds (0);
+    }
+  if (a == 0)
+    {
+      return Time::Max ();
+    }
+  // c < 0, so the roots have opposite signs and the larger one is the time the link breaks
+  return Seconds ((-b + std::sqrt (b * b - a * c)) / a);
+}
+
+}
+}
@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#ifndef OLSB_LINK_LIFETIME_ESTIMATOR_H
+#define OLSB_LINK_LIFETIME_ESTIMATOR_H
+
+#include <map>
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+
+namespace ns3 {
+namespace olsb {
+/**
+ * \ingroup olsb
+ * \brief Per neighbor link lifetime prediction from reported positions and velocities
+ *
+ * Neighbors report their position and velocity with their updates. Assuming that both ends keep
+ * moving in a straight line at constant speed, the link lasts until the distance between them
+ * exceeds the transmission range, which is the positive root t of
+ * |d + dv * t| = range, where d and dv are the relative position and velocity of the neighbor.
+ * The neighbor's position is extrapolated from the time of its report.
+ */
+class LinkLifetimeEstimator
+{
+public:
+  /// c-tor
+  LinkLifetimeEstimator ();
+  /**
+   * Record the position and velocity reported by a neighbor
+   * \param neighbor the neighbor IPv4 address
+   * \param position the position of the neighbor in meters
+   * \param velocity the velocity of the neighbor in meters per second
+   */
+  void
+  UpdateNeighbor (Ipv4Address neighbor, const Vector &position, const Vector &velocity);
+  /**
+   * Get the expected remaining lifetime of the link to a neighbor
+   * \param neighbor the neighbor IPv4 address
+   * \param position the current position of this node
+   * \param velocity the current velocity of this node
+   * \returns the remaining lifetime, zero if the neighbor is already out of range and Time::Max ()
+   * if the neighbor is unknown or does not move away
+   */
+  Time
+  GetLinkLifetime (Ipv4Address neighbor, const Vector &position, const Vector &velocity) const;
+  /**
+   * Forget a neighbor
+   * \param neighbor the neighbor IPv4 address
+   */
+  void
+  DeleteNeighbor (Ipv4Address neighbor)
+  {
+    m_neighbors.erase (neighbor);
+  }
+  /// Forget all neighbors
+  void
+  Clear ()
+  {
+    m_neighbors.clear ();
+  }
+  /**
+   * Set the transmission range
+   * \param range the transmission range in meters
+   */
+  void
+  SetRange (double range)
+  {
+    m_range = range;
+  }
+  /**
+   * Get the transmission range
+   * \returns the transmission range in meters
+   */
+  double
+  GetRange () const
+  {
+    return m_range;
+  }
+
+private:
+  /// Last report of one neighbor
+  struct MobilityReport
+  {
+    Vector position; ///< reported position
+    Vector velocity; ///< reported velocity
+    Time reception; ///< time of the report
+  };
+  /// last report per neighbor
+  std::map<Ipv4Address, MobilityReport> m_neighbors;
+  /// transmission range in meters
+  double m_range;
+};
+
+}
+}
+
+#endif /* OLSB_LINK_LIFETIME_ESTIMATOR_H */
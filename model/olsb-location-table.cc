@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#include "olsb-location-table.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OlsbLocationTable");
+
+namespace olsb {
+
+LocationTable::LocationTable ()
+  : m_lifetime (Seconds (60))
+{
+}
+
+void
+LocationTable::Update (Ipv4Address node, const Vector &position, Time age)
+{
+  Time timestamp = Simulator::Now () - age;
+  std::map<Ipv4Address, Location>::iterator i = m_locations.find (node);
+  if (i != m_locations.end () && i->second.timestamp > timestamp)
+    {
+      return;
+    }
+  Location &location = m_locations[node];
+  location.position = position;
+  location.timestamp = timestamp;
+}
+
+bool
+LocationTable::Lookup (Ipv4Address node, Vector &position) const
+{
+  std::map<Ipv4Address, Location>::const_iterator i = m_locations.find (node);
+  if (i == m_locations.end () || Simulator::Now () - i->second.timestamp > m_lifetime)
+    {
+      return false;
+    }
+  position = i->second.position;
+  return true;
+}
+
+void
+LocationTable::GetLocations (std::map<Ipv4Address, Location> &locations) const
+{
+  for (std::map<Ipv4Address, Location>::const_iterator i = m_locations.begin (); i != m_locations.end (); ++i)
+    {
+      if (Simulator::Now () - i->second.timestamp <= m_lifetime)
+        {
+          locations.insert (*i);
+        }
+    }
+}
+
+bool
+LocationTable::GetClosestNeighbor (const Vector &position, const Vector &dstPosition,
+                                   const std::vector<Ipv4Address> &neighbors, Ipv4Address &nextHop) const
+{
+  // Only strictly closer neighbors make progress, so greedy forwarding cannot loop
+  double best = CalculateDistance (position,dstPosition);
+  bool found = false;
+  for (std::vector<Ipv4Address>::const_iterator n = neighbors.begin (); n != neighbors.end (); ++n)
+    {
+      Vector neighborPosition;
+      if (!Lookup (*n,neighborPosition))
+        {
+          continue;
+        }
+      double distance = CalculateDistance (neighborPosition,dstPosition);
+      if (distance < best)
+        {
+          best = distance;
+          nextHop = *n;
+          found = true;
+        }
+    }
+  return found;
+}
+
+void
+LocationTable::Purge ()
+{
+  for (std::map<Ipv4Address, Location>::iterator i = m_locations.begin (); i != m_locations.end (); )
+    {
+      if (Simulator::Now () - i->second.timestamp > m_lifetime)
+        {
+          NS_LOG_LOGIC ("Forgetting the position of " << i->first);
+          m_locations.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+}
+}
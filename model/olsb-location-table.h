@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#ifndef OLSB_LOCATION_TABLE_H
+#define OLSB_LOCATION_TABLE_H
+
+#include <map>
+#include <vector>
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+
+namespace ns3 {
+namespace olsb {
+/**
+ * \ingroup olsb
+ * \brief Last known positions of the nodes of the network
+ *
+ * Neighbors report their own position with their updates, together with the positions they know
+ * of other nodes and the age of each. The table keeps the most recent position of every node and
+ * forgets positions older than the lifetime. When no route is known, a packet can be forwarded
+ * greedily to the neighbor closest to the position of its destination.
+ */
+class LocationTable
+{
+public:
+  /// Position of a node and the time it was reported by the node itself
+  struct Location
+  {
+    Vector position; ///< position of the node
+    Time timestamp; ///< time at which the node was at that position
+  };
+
+  /// c-tor
+  LocationTable ();
+  /**
+   * Record the position of a node, unless a more recent one is known
+   * \param node the node IPv4 address
+   * \param position the position of the node
+   * \param age the time since the node was at that position
+   */
+  void
+  Update (Ipv4Address node, const Vector &position, Time age);
+  /**
+   * Lookup the position of a node
+   * \param node the node IPv4 address
+   * \param position the last known position of the node
+   * \returns false if the position is unknown or has expired
+   */
+  bool
+  Lookup (Ipv4Address node, Vector &position) const;
+  /**
+   * Get the positions that have not expired
+   * \param locations the position of every node
+   */
+  void
+  GetLocations (std::map<Ipv4Address, Location> &locations) const;
+  /**
+   * Choose the neighbor closest to a destination among those closer than this node
+   * \param position the position of this node
+   * \param dstPosition the position of the destination
+   * \param neighbors the neighbors to choose from
+   * \param nextHop the chosen neighbor
+   * \returns false if no neighbor with a known position is closer to the destination than this node
+   */
+  bool
+  GetClosestNeighbor (const Vector &position, const Vector &dstPosition, const std::vector<Ipv4Address> &neighbors,
+                      Ipv4Address &nextHop) const;
+  /// Forget the positions that have expired
+  void
+  Purge ();
+  /// Forget all positions
+  void
+  Clear ()
+  {
+    m_locations.clear ();
+  }
+  /**
+   * Set the time after which a position is forgotten
+   * \param lifetime the position lifetime
+   */
+  void
+  SetLifetime (Time lifetime)
+  {
+    m_lifetime = lifetime;
+  }
+  /**
+   * Get the time after which a position is forgotten
+   * \returns the position lifetime
+   */
+  Time
+  GetLifetime () const
+  {
+    return m_lifetime;
+  }
+
+private:
+  /// last known position per node
+  std::map<Ipv4Address, Location> m_locations;
+  /// time after which a position is forgotten
+  Time m_lifetime;
+};
+
+}
+}
+
+#endif /* OLSB_LOCATION_TABLE_H */
@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#include "olsb-metric-policy.h"
+#include "olsb-link-estimator.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OlsbMetricPolicy");
+
+namespace olsb {
+MetricPolicy::~MetricPolicy ()
+{
+}
+
+bool
+MetricPolicy::GetCost (const RouteMetric &metric, double &cost) const
+{
+  return false;
+}
+
+bool
+MetricPolicy::IsClearlyBetter (const RouteMetric &current, const RouteMetric &candidate, double absolute,
+                               double relative) const
+{
+  if (!IsBetter (current,candidate))
+    {
+      return false;
+    }
+  double currentCost, candidateCost;
+  if ((absolute == 0 && relative == 0) || !GetCost (current,currentCost) || !GetCost (candidate,candidateCost))
+    {
+      return true;
+    }
+  double gain = currentCost - candidateCost;
+  return gain > absolute && gain > relative * currentCost;
+}
+
+WeightedPolicy::WeightedPolicy (MetricWeights weights)
+  : m_weights (weights)
+{
+}
+
+bool
+WeightedPolicy::IsBetter (const RouteMetric &current, const RouteMetric &candidate) const
+{
+  // The terms are unsigned, so each one is widened before subtracting.
+  double shortestPathVal = static_cast<double> (current.hops) - candidate.hops;
+  double backpressureVal = static_cast<double> (current.queue) - candidate.queue;
+  double linkQualityVal = (static_cast<double> (current.etx) - candidate.etx) / LinkEstimator::ETX_SCALE;
+  // Airtime is compared in milliseconds
+  double airtimeVal = (static_cast<double> (current.airtime) - candidate.airtime) / 1000;
+  return shortestPathVal * m_weights.hops + backpressureVal * m_weights.queue
+         + linkQualityVal * m_weights.etx + airtimeVal * m_weights.airtime > 0;
+}
+
+bool
+WeightedPolicy::GetCost (const RouteMetric &metric, double &cost) const
+{
+  cost = metric.hops * m_weights.hops + metric.queue * m_weights.queue
+    + metric.etx * m_weights.etx / LinkEstimator::ETX_SCALE + metric.airtime * m_weights.airtime / 1000;
+  return true;
+}
+
+uint8_t
+WeightedPolicy::GetFields () const
+{
+  uint8_t fields = 0;
+  if (m_weights.queue != 0)
+    {
+      fields |= QUEUE;
+    }
+  if (m_weights.etx != 0)
+    {
+      fields |= ETX;
+    }
+  if (m_weights.airtime != 0)
+    {
+      fields |= AIRTIME;
+    }
+  return fields;
+}
+
+bool
+LexicographicPolicy::IsBetter (const RouteMetric &current, const RouteMetric &candidate) const
+{
+  if (candidate.hops != current.hops)
+    {
+      return candidate.hops < current.hops;
+    }
+  if (candidate.queue != current.queue)
+    {
+      return candidate.queue < current.queue;
+    }
+  if (candidate.etx != current.etx)
+    {
+      return candidate.etx < current.etx;
+    }
+  return candidate.airtime < current.airtime;
+}
+
+uint8_t
+LexicographicPolicy::GetFields () const
+{
+  return ALL;
+}
+
+CustomPolicy::CustomPolicy (CompareCallback compare, uint8_t fields)
+  : m_compare (compare),
+    m_fields (fields)
+{
+}
+
+bool
+CustomPolicy::IsBetter (const RouteMetric &current, const RouteMetric &candidate) const
+{
+  return m_compare (current, candidate);
+}
+
+uint8_t
+CustomPolicy::GetFields () const
+{
+  return m_fields;
+}
+
+Ptr<MetricPolicy>
+CreateMetricPolicy (MetricPolicyType type, MetricWeights weights, MetricPolicy::CompareCallback compare,
+                    uint8_t fields)
+{
+  switch (type)
+    {
+    case HOP_ONLY:
+      return Create<HopOnlyPolicy> ();
+    case QUEUE_ONLY:
+      return Create<QueueOnlyPolicy> ();
+    case LEXICOGRAPHIC:
+      return Create<LexicographicPolicy> ();
+    case CUSTOM:
+      NS_ABORT_MSG_IF (compare.IsNull (), "Custom metric policy selected without a comparison callback");
+      return Create<CustomPolicy> (compare, fields);
+    case WEIGHTED:
+    default:
+      break;
+    }
+  if (weights.etx == 0 && weights.airtime == 0)
+    {
+      if (weights.hops > 0 && weights.queue == 0)
+        {
+          NS_LOG_LOGIC ("Backpressure factor is 0, using the hop count policy");
+          return Create<HopOnlyPolicy> ();
+        }
+      if (weights.queue > 0 && weights.hops == 0)
+        {
+          NS_LOG_LOGIC ("Shortest path factor is 0, using the backlog policy");
+          return Create<QueueOnlyPolicy> ();
+        }
+    }
+  return Create<WeightedPolicy> (weights);
+}
+
+}
+}
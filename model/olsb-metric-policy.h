@@ -0,0 +1,246 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#ifndef OLSB_METRIC_POLICY_H
+#define OLSB_METRIC_POLICY_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/ptr.h"
+#include "ns3/callback.h"
+
+namespace ns3 {
+namespace olsb {
+/**
+ * \ingroup olsb
+ * \brief Cost of a route as carried in an OLSB record
+ */
+struct RouteMetric
+{
+  uint32_t hops; ///< hop count
+  uint32_t queue; ///< advertised backlog
+  uint32_t etx; ///< path ETX, scaled by LinkEstimator::ETX_SCALE
+  uint32_t airtime; ///< path airtime in microseconds
+};
+
+/**
+ * \ingroup olsb
+ * \brief Weights of the terms of the weighted OLSB cost
+ */
+struct MetricWeights
+{
+  double hops; ///< shortest path factor
+  double queue; ///< backpressure factor
+  double etx; ///< link quality factor, per unit of ETX
+  double airtime; ///< airtime factor, per millisecond
+};
+
+/**
+ * \ingroup olsb
+ * \brief Route metric policies selectable by attribute
+ */
+enum MetricPolicyType
+{
+  HOP_ONLY = 0,     // !< fewest hops
+  QUEUE_ONLY = 1,     // !< smallest advertised backlog
+  WEIGHTED = 2,     // !< weighted sum of the differences (OLSB)
+  LEXICOGRAPHIC = 3,     // !< hops, then backlog, then ETX, then airtime
+  CUSTOM = 4,     // !< user supplied comparison
+};
+
+/**
+ * \ingroup olsb
+ * \brief Decides whether an update with the same sequence number replaces the current route
+ *
+ * Besides the comparison, a policy tells which optional record fields it reads, so that nodes
+ * do not compute and advertise metrics that no one uses. The hop count is always advertised
+ * because the distance vector needs it.
+ */
+class MetricPolicy : public SimpleRefCount<MetricPolicy>
+{
+public:
+  /// Optional record fields
+  enum Field
+  {
+    QUEUE = 1,     // !< advertised backlog
+    ETX = 2,     // !< path ETX
+    AIRTIME = 4,     // !< path airtime
+    ALL = QUEUE | ETX | AIRTIME
+  };
+  /// Callback comparing the current route with a candidate, returns true to switch
+  typedef Callback<bool, const RouteMetric &, const RouteMetric &> CompareCallback;
+
+  virtual
+  ~MetricPolicy ();
+  /**
+   * Compare the current route with a candidate
+   * \param current the metric of the current route
+   * \param candidate the metric of the route through the sender of the update
+   * \returns true if the candidate is better
+   */
+  virtual bool
+  IsBetter (const RouteMetric &current, const RouteMetric &candidate) const = 0;
+  /**
+   * Get the optional record fields that the policy reads
+   * \returns a bitmask of Field values
+   */
+  virtual uint8_t
+  GetFields () const = 0;
+  /**
+   * Get the scalar cost of a route, for policies that have one
+   * \param metric the metric of the route
+   * \param cost the cost, lower is better
+   * \returns false if the policy does not reduce a route to a scalar cost
+   */
+  virtual bool
+  GetCost (const RouteMetric &metric, double &cost) const;
+  /**
+   * Compare the current route with a candidate, with hysteresis
+   *
+   * The candidate must be better and, for policies with a scalar cost, lower the cost by more
+   * than an absolute threshold and by more than a fraction of the current cost.
+   *
+   * \param current the metric of the current route
+   * \param candidate the metric of the route through the sender of the update
+   * \param absolute the absolute threshold, in units of the cost
+   * \param relative the relative threshold, as a fraction of the current cost
+   * \returns true if the candidate is clearly better
+   */
+  bool
+  IsClearlyBetter (const RouteMetric &current, const RouteMetric &candidate, double absolute, double relative) const;
+};
+
+/**
+ * \ingroup olsb
+ * \brief Policy reading a single integer field, picked when only one factor is used
+ *
+ * The comparison is a plain integer compare, so the hot path has no floating point work.
+ */
+template <uint32_t RouteMetric::*Member, uint8_t Fields>
+class SingleFieldPolicy : public MetricPolicy
+{
+public:
+  virtual bool
+  IsBetter (const RouteMetric &current, const RouteMetric &candidate) const
+  {
+    return candidate.*Member < current.*Member;
+  }
+  virtual uint8_t
+  GetFields () const
+  {
+    return Fields;
+  }
+  virtual bool
+  GetCost (const RouteMetric &metric, double &cost) const
+  {
+    cost = metric.*Member;
+    return true;
+  }
+};
+
+/// Fewest hops
+typedef SingleFieldPolicy<&RouteMetric::hops, 0> HopOnlyPolicy;
+/// Smallest advertised backlog
+typedef SingleFieldPolicy<&RouteMetric::queue, MetricPolicy::QUEUE> QueueOnlyPolicy;
+
+/**
+ * \ingroup olsb
+ * \brief Weighted sum of the metric differences, the original OLSB decision
+ */
+class WeightedPolicy : public MetricPolicy
+{
+public:
+  /**
+   * Constructor
+   * \param weights the weights of the terms
+   */
+  WeightedPolicy (MetricWeights weights);
+  virtual bool
+  IsBetter (const RouteMetric &current, const RouteMetric &candidate) const;
+  virtual uint8_t
+  GetFields () const;
+  virtual bool
+  GetCost (const RouteMetric &metric, double &cost) const;
+
+private:
+  MetricWeights m_weights; ///< weights of the terms
+};
+
+/**
+ * \ingroup olsb
+ * \brief Hops first, ties broken by backlog, then ETX, then airtime
+ */
+class LexicographicPolicy : public MetricPolicy
+{
+public:
+  virtual bool
+  IsBetter (const RouteMetric &current, const RouteMetric &candidate) const;
+  virtual uint8_t
+  GetFields () const;
+};
+
+/**
+ * \ingroup olsb
+ * \brief User supplied comparison
+ */
+class CustomPolicy : public MetricPolicy
+{
+public:
+  /**
+   * Constructor
+   * \param compare the comparison, returns true to switch to the candidate
+   * \param fields the optional record fields that the comparison reads
+   */
+  CustomPolicy (CompareCallback compare, uint8_t fields);
+  virtual bool
+  IsBetter (const RouteMetric &current, const RouteMetric &candidate) const;
+  virtual uint8_t
+  GetFields () const;
+
+private:
+  CompareCallback m_compare; ///< the comparison
+  uint8_t m_fields; ///< optional record fields read by the comparison
+};
+
+/**
+ * \ingroup olsb
+ * \brief Create a metric policy
+ *
+ * A weighted policy with a single positive factor is replaced by the equivalent single field
+ * policy.
+ *
+ * \param type the policy type
+ * \param weights the weights used by the weighted policy
+ * \param compare the comparison used by the custom policy
+ * \param fields the optional record fields read by the custom policy
+ * \returns the metric policy
+ */
+Ptr<MetricPolicy> CreateMetricPolicy (MetricPolicyType type, MetricWeights weights,
+                                      MetricPolicy::CompareCallback compare = MetricPolicy::CompareCallback (),
+                                      uint8_t fields = MetricPolicy::ALL);
+
+}
+}
+
+#endif /* OLSB_METRIC_POLICY_H */
@@ -0,0 +1,93 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#include "olsb-neighbor-table.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OlsbNeighborTable");
+
+namespace olsb {
+
+NeighborTable::NeighborTable ()
+  : m_helloInterval (Seconds (1)),
+    m_allowedHelloLoss (2)
+{
+}
+
+void
+NeighborTable::Update (Ipv4Address neighbor, bool bidirectional)
+{
+  Neighbor &entry = m_neighbors[neighbor];
+  entry.lastHeard = Simulator::Now ();
+  entry.bidirectional = bidirectional;
+}
+
+bool
+NeighborTable::IsNeighbor (Ipv4Address neighbor) const
+{
+  return m_neighbors.find (neighbor) != m_neighbors.end ();
+}
+
+bool
+NeighborTable::IsBidirectional (Ipv4Address neighbor) const
+{
+  std::map<Ipv4Address, Neighbor>::const_iterator i = m_neighbors.find (neighbor);
+  return i != m_neighbors.end () && i->second.bidirectional;
+}
+
+void
+NeighborTable::GetNeighbors (std::vector<Ipv4Address> &neighbors) const
+{
+  for (std::map<Ipv4Address, Neighbor>::const_iterator i = m_neighbors.begin (); i != m_neighbors.end (); ++i)
+    {
+      neighbors.push_back (i->first);
+    }
+}
+
+void
+NeighborTable::Purge (std::vector<Ipv4Address> &lost)
+{
+  // A neighbor is still heard until the beacon after the last one it may miss is late too
+  Time timeout = (m_allowedHelloLoss + 1) * m_helloInterval;
+  for (std::map<Ipv4Address, Neighbor>::iterator i = m_neighbors.begin (); i != m_neighbors.end (); )
+    {
+      if (Simulator::Now () - i->second.lastHeard > timeout)
+        {
+          NS_LOG_LOGIC ("Neighbor " << i->first << " missed more than " << m_allowedHelloLoss << " beacons");
+          lost.push_back (i->first);
+          m_neighbors.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#ifndef OLSB_NEIGHBOR_TABLE_H
+#define OLSB_NEIGHBOR_TABLE_H
+
+#include <map>
+#include <vector>
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+namespace olsb {
+/**
+ * \ingroup olsb
+ * \brief Neighbors heard through their HELLO beacons
+ *
+ * Every node beacons the neighbors it hears. A neighbor whose beacon lists this node hears it as
+ * well, so the link between them is bidirectional. A neighbor is lost once it has missed more
+ * beacons in a row than the loss tolerance allows, which detects broken links much sooner than
+ * the expiry of the routes learned through it.
+ */
+class NeighborTable
+{
+public:
+  /// c-tor
+  NeighborTable ();
+  /**
+   * Record a beacon of a neighbor
+   * \param neighbor the neighbor IPv4 address
+   * \param bidirectional whether the beacon lists this node
+   */
+  void
+  Update (Ipv4Address neighbor, bool bidirectional);
+  /**
+   * Check whether a neighbor is heard
+   * \param neighbor the neighbor IPv4 address
+   * \returns true if a beacon of the neighbor was received and the neighbor was not lost since
+   */
+  bool
+  IsNeighbor (Ipv4Address neighbor) const;
+  /**
+   * Check whether the link to a neighbor works both ways
+   * \param neighbor the neighbor IPv4 address
+   * \returns true if the last beacon of the neighbor listed this node
+   */
+  bool
+  IsBidirectional (Ipv4Address neighbor) const;
+  /**
+   * Get the neighbors heard
+   * \param neighbors the neighbors, in both directions or not
+   */
+  void
+  GetNeighbors (std::vector<Ipv4Address> &neighbors) const;
+  /**
+   * Forget the neighbors that missed too many beacons
+   * \param lost the neighbors forgotten
+   */
+  void
+  Purge (std::vector<Ipv4Address> &lost);
+  /// Forget all neighbors
+  void
+  Clear ()
+  {
+    m_neighbors.clear ();
+  }
+  /**
+   * Set the time between two beacons
+   * \param interval the beacon interval
+   */
+  void
+  SetHelloInterval (Time interval)
+  {
+    m_helloInterval = interval;
+  }
+  /**
+   * Get the time between two beacons
+   * \returns the beacon interval
+   */
+  Time
+  GetHelloInterval () const
+  {
+    return m_helloInterval;
+  }
+  /**
+   * Set the number of beacons a neighbor may miss in a row
+   * \param loss the loss tolerance
+   */
+  void
+  SetAllowedHelloLoss (uint32_t loss)
+  {
+    m_allowedHelloLoss = loss;
+  }
+  /**
+   * Get the number of beacons a neighbor may miss in a row
+   * \returns the loss tolerance
+   */
+  uint32_t
+  GetAllowedHelloLoss () const
+  {
+    return m_allowedHelloLoss;
+  }
+
+private:
+  /// State of a neighbor
+  struct Neighbor
+  {
+    Time lastHeard; ///< time of the last beacon
+    bool bidirectional; ///< whether the last beacon listed this node
+  };
+  /// neighbors heard
+  std::map<Ipv4Address, Neighbor> m_neighbors;
+  /// time between two beacons
+  Time m_helloInterval;
+  /// number of beacons a neighbor may miss in a row
+  uint32_t m_allowedHelloLoss;
+};
+
+}
+}
+
+#endif /* OLSB_NEIGHBOR_TABLE_H */
@@ -25,6 +25,7 @@
 #include "olsb-packet-queue.h"
 #include <algorithm>
 #include <functional>
+#include <iterator>
 #include "ns3/ipv4-route.h"
 #include "ns3/socket.h"
 #include "ns3/log.h"
@@ -38,7 +39,7 @@ uint32_t
 PacketQueue::GetSize ()
 {
   Purge ();
-  return m_queue.size ();
+  return m_size;
 }
 
 bool
@@ -46,30 +47,35 @@ PacketQueue::Enqueue (QueueEntry & entry)
 {
   NS_LOG_FUNCTION ("Enqueing packet destined for" << entry.GetIpv4Header ().GetDestination ());
   Purge ();
-  uint32_t numPacketswithdst;
-  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  Ipv4Address dst = entry.GetIpv4Header ().GetDestination ();
+  std::vector<QueueEntry> &bucket = m_queue[dst];
+  for (std::vector<QueueEntry>::const_iterator i = bucket.begin (); i
+       != bucket.end (); ++i)
     {
-      if ((i->GetPacket ()->GetUid () == entry.GetPacket ()->GetUid ())
-          && (i->GetIpv4Header ().GetDestination ()
-              == entry.GetIpv4Header ().GetDestination ()))
+      if (i->GetPacket ()->GetUid () == entry.GetPacket ()->GetUid ())
         {
           return false;
         }
     }
-  numPacketswithdst = GetCountForPacketsWithDst (entry.GetIpv4Header ().GetDestination ());
+  uint32_t numPacketswithdst = bucket.size ();
   NS_LOG_DEBUG ("Number of packets with this destination: " << numPacketswithdst);
   /** For Brock Paper comparison*/
-  if (numPacketswithdst >= m_maxLenPerDst || m_queue.size () >= m_maxLen)
+  if (numPacketswithdst >= m_maxLenPerDst || m_size >= m_maxLen)
     {
       NS_LOG_DEBUG ("Max packets reached for this destination. Not queuing any further packets");
+      m_drops++;
+      if (bucket.empty ())
+        {
+          m_queue.erase (dst);
+        }
       return false;
     }
   else
     {
       // NS_LOG_DEBUG("Packet size while enqueing "<<entry.GetPacket()->GetSize());
       entry.SetExpireTime (m_queueTimeout);
-      m_queue.push_back (entry);
+      bucket.push_back (entry);
+      m_size++;
       return true;
     }
 }
@@ -79,17 +85,18 @@ PacketQueue::DropPacketWithDst (Ipv4Address dst)
 {
   NS_LOG_FUNCTION ("Dropping packet to " << dst);
   Purge ();
-  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  std::map<Ipv4Address, std::vector<QueueEntry> >::iterator bucket = m_queue.find (dst);
+  if (bucket == m_queue.end ())
     {
-      if (i->GetIpv4Header ().GetDestination () == dst)
-        {
-          Drop (*i, "DropPacketWithDst ");
-        }
+      return;
+    }
+  for (std::vector<QueueEntry>::iterator i = bucket->second.begin (); i
+       != bucket->second.end (); ++i)
+    {
+      Drop (*i, "DropPacketWithDst ");
     }
-  auto new_end = std::remove_if (m_queue.begin (), m_queue.end (), [&](const QueueEntry& en)
-                                 { return en.GetIpv4Header ().GetDestination () == dst; });
-  m_queue.erase (new_end, m_queue.end ());
+  m_size -= bucket->second.size ();
+  m_queue.erase (bucket);
 }
 
 bool
@@ -97,29 +104,48 @@ PacketQueue::Dequeue (Ipv4Address dst, QueueEntry & entry)
 {
   NS_LOG_FUNCTION ("Dequeueing packet destined for" << dst);
   Purge ();
-  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+  std::map<Ipv4Address, std::vector<QueueEntry> >::iterator bucket = m_queue.find (dst);
+  if (bucket == m_queue.end ())
     {
-      if (i->GetIpv4Header ().GetDestination () == dst)
-        {
-          entry = *i;
-          m_queue.erase (i);
-          return true;
-        }
+      return false;
     }
-  return false;
+  entry = bucket->second.front ();
+  bucket->second.erase (bucket->second.begin ());
+  m_size--;
+  if (bucket->second.empty ())
+    {
+      m_queue.erase (bucket);
+    }
+  return true;
+}
+
+bool
+PacketQueue::DequeueLast (Ipv4Address dst, QueueEntry & entry)
+{
+  NS_LOG_FUNCTION ("Dequeueing latest packet destined for" << dst);
+  Purge ();
+  std::map<Ipv4Address, std::vector<QueueEntry> >::iterator bucket = m_queue.find (dst);
+  if (bucket == m_queue.end ())
+    {
+      return false;
+    }
+  entry = bucket->second.back ();
+  bucket->second.pop_back ();
+  m_size--;
+  if (bucket->second.empty ())
+    {
+      m_queue.erase (bucket);
+    }
+  return true;
 }
 
 bool
 PacketQueue::Find (Ipv4Address dst)
 {
-  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  if (m_queue.find (dst) != m_queue.end ())
     {
-      if (i->GetIpv4Header ().GetDestination () == dst)
-        {
-          NS_LOG_DEBUG ("Find");
-          return true;
-        }
+      NS_LOG_DEBUG ("Find");
+      return true;
     }
   return false;
 }
@@ -127,16 +153,24 @@ PacketQueue::Find (Ipv4Address dst)
 uint32_t
 PacketQueue::GetCountForPacketsWithDst (Ipv4Address dst)
 {
-  uint32_t count = 0;
-  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  std::map<Ipv4Address, std::vector<QueueEntry> >::const_iterator bucket = m_queue.find (dst);
+  if (bucket == m_queue.end ())
     {
-      if (i->GetIpv4Header ().GetDestination () == dst)
-        {
-          count++;
-        }
+      return 0;
+    }
+  return bucket->second.size ();
+}
+
+void
+PacketQueue::GetDestinations (std::vector<Ipv4Address> & dsts)
+{
+  Purge ();
+  dsts.clear ();
+  for (std::map<Ipv4Address, std::vector<QueueEntry> >::const_iterator bucket = m_queue.begin (); bucket
+       != m_queue.end (); ++bucket)
+    {
+      dsts.push_back (bucket->first);
     }
-  return count;
 }
 
 /**
@@ -162,23 +196,38 @@ PacketQueue::Purge ()
 {
   // NS_LOG_DEBUG("Purging Queue");
   IsExpired pred;
-  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  for (std::map<Ipv4Address, std::vector<QueueEntry> >::iterator bucket = m_queue.begin (); bucket
+       != m_queue.end (); )
     {
-      if (pred (*i))
+      std::vector<QueueEntry> &entries = bucket->second;
+      for (std::vector<QueueEntry>::iterator i = entries.begin (); i
+           != entries.end (); ++i)
+        {
+          if (pred (*i))
+            {
+              NS_LOG_DEBUG ("Dropping outdated Packets");
+              Drop (*i, "Drop outdated packet ");
+            }
+        }
+      std::vector<QueueEntry>::iterator newEnd = std::remove_if (entries.begin (), entries.end (), pred);
+      m_size -= std::distance (newEnd, entries.end ());
+      entries.erase (newEnd, entries.end ());
+      if (entries.empty ())
+        {
+          m_queue.erase (bucket++);
+        }
+      else
         {
-          NS_LOG_DEBUG ("Dropping outdated Packets");
-          Drop (*i, "Drop outdated packet ");
+          ++bucket;
         }
     }
-  m_queue.erase (std::remove_if (m_queue.begin (), m_queue.end (), pred),
-                 m_queue.end ());
 }
 
 void
 PacketQueue::Drop (QueueEntry en, std::string reason)
 {
   NS_LOG_LOGIC (reason << en.GetPacket ()->GetUid () << " " << en.GetIpv4Header ().GetDestination ());
+  m_drops++;
   // en.GetErrorCallback () (en.GetPacket (), en.GetIpv4Header (),
   //   Socket::ERROR_NOROUTETOHOST);
   return;
@@ -25,6 +25,7 @@
 #ifndef OLSB_PACKETQUEUE_H
 #define OLSB_PACKETQUEUE_H
 
+#include <map>
 #include <vector>
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/simulator.h"
@@ -172,12 +173,17 @@ private:
  * When a route is not available, the packets are queued. Every node can buffer up to 5 packets per
  * destination. We have implemented a "drop front on full" queue where the first queued packet will be dropped
  * to accommodate newer packets.
+ *
+ * Packets are kept in one bucket per destination, so that looking up or draining the packets of a
+ * destination whose route just became valid does not touch the packets of any other destination.
  */
 class PacketQueue
 {
 public:
   /// Default c-tor
   PacketQueue ()
+    : m_size (0),
+      m_drops (0)
   {
   }
   /**
@@ -194,6 +200,14 @@ public:
    * \returns true if successful
    */
   bool Dequeue (Ipv4Address dst, QueueEntry & entry);
+  /**
+   * Return last found (the latest) entry for given destination
+   *
+   * \param dst the destination IP address
+   * \param entry the queue entry
+   * \returns true if successful
+   */
+  bool DequeueLast (Ipv4Address dst, QueueEntry & entry);
   /**
    * Remove all packets with destination IP address dst
    * \param dst the destination IP address
@@ -212,11 +226,25 @@ public:
    */
   uint32_t
   GetCountForPacketsWithDst (Ipv4Address dst);
+  /**
+   * Get the destinations of the packets in the queue
+   * \param dsts the destinations, each listed once
+   */
+  void
+  GetDestinations (std::vector<Ipv4Address> & dsts);
   /**
    * Get the number of entries
    * \returns the number of entries
    */
   uint32_t GetSize ();
+  /**
+   * Get the number of packets dropped or refused since the queue was created
+   * \returns the drop count
+   */
+  uint32_t GetDropCount () const
+  {
+    return m_drops;
+  }
 
   // Fields
   /**
@@ -269,7 +297,12 @@ public:
   }
 
 private:
-  std::vector<QueueEntry> m_queue; ///< the queue
+  /// Per destination buckets, in arrival order. A bucket is erased as soon as it becomes empty.
+  std::map<Ipv4Address, std::vector<QueueEntry> > m_queue;
+  /// Total number of entries over all buckets
+  uint32_t m_size;
+  /// Number of packets dropped on timeout or refused because the queue was full
+  uint32_t m_drops;
   /// Remove all expired entries
   void Purge ();
   /**
@@ -24,6 +24,8 @@
  */
 
 #include "olsb-packet.h"
+#include <algorithm>
+#include <cmath>
 #include "ns3/address-utils.h"
 #include "ns3/packet.h"
 
@@ -32,11 +34,15 @@ namespace olsb {
 
 NS_OBJECT_ENSURE_REGISTERED (OlsbHeader);
 
-OlsbHeader::OlsbHeader (Ipv4Address dst, uint32_t hopCount, uint32_t dstSeqNo, uint32_t queueSize)
+OlsbHeader::OlsbHeader (Ipv4Address dst, uint32_t hopCount, uint32_t dstSeqNo, uint32_t queueSize, uint32_t etx,
+                        uint32_t airtime)
   : m_dst (dst),
     m_hopCount (hopCount),
     m_dstSeqNo (dstSeqNo),
-    m_queuesize (queueSize)
+    m_queuesize (queueSize),
+    m_etx (etx),
+    m_airtime (airtime),
+    m_fields (0)
 {
 }
 
@@ -60,10 +66,34 @@ OlsbHeader::GetInstanceTypeId () const
   return GetTypeId ();
 }
 
+uint32_t
+OlsbHeader::GetRecordSize (uint8_t fields)
+{
+  return 16 + ((fields & ETX) ? 4 : 0) + ((fields & AIRTIME) ? 4 : 0);
+}
+
+uint8_t
+OlsbHeader::GetNeededFields (const std::vector<OlsbHeader> &records)
+{
+  uint8_t fields = 0;
+  for (std::vector<OlsbHeader>::const_iterator r = records.begin (); r != records.end (); ++r)
+    {
+      if (r->GetEtx () != 0)
+        {
+          fields |= ETX;
+        }
+      if (r->GetAirtime () != 0)
+        {
+          fields |= AIRTIME;
+        }
+    }
+  return fields;
+}
+
 uint32_t
 OlsbHeader::GetSerializedSize () const
 {
-  return 16;
+  return GetRecordSize (m_fields);
 }
 
 void
@@ -73,6 +103,14 @@ OlsbHeader::Serialize (Buffer::Iterator i) const
   i.WriteHtonU32 (m_hopCount);
   i.WriteHtonU32 (m_dstSeqNo);
   i.WriteHtonU32 (m_queuesize);
+  if (m_fields & ETX)
+    {
+      i.WriteHtonU32 (m_etx);
+    }
+  if (m_fields & AIRTIME)
+    {
+      i.WriteHtonU32 (m_airtime);
+    }
 }
 
 uint32_t
@@ -84,19 +122,1270 @@ OlsbHeader::Deserialize (Buffer::Iterator start)
   m_hopCount = i.ReadNtohU32 ();
   m_dstSeqNo = i.ReadNtohU32 ();
   m_queuesize = i.ReadNtohU32 ();
+  m_etx = (m_fields & ETX) ? i.ReadNtohU32 () : 0;
+  m_airtime = (m_fields & AIRTIME) ? i.ReadNtohU32 () : 0;
 
   uint32_t dist = i.GetDistanceFrom (start);
   NS_ASSERT (dist == GetSerializedSize ());
   return dist;
 }
 
+bool
+OlsbHeader::DeserializeRecords (const uint8_t *data, uint32_t size, uint8_t fields, std::vector<OlsbHeader> &records)
+{
+  const uint32_t recordSize = GetRecordSize (fields);
+  if (size % recordSize != 0)
+    {
+      return false;
+    }
+  // Byte swap all fields in a single loop that compilers vectorise, then pick the records out of it
+  std::vector<uint32_t> words (size / 4);
+  for (uint32_t k = 0; k < words.size (); k++)
+    {
+      const uint8_t *b = data + 4 * k;
+      words[k] = ((uint32_t) b[0] << 24) | ((uint32_t) b[1] << 16) | ((uint32_t) b[2] << 8) | (uint32_t) b[3];
+    }
+  records.reserve (records.size () + size / recordSize);
+  for (uint32_t k = 0; k < words.size (); k += recordSize / 4)
+    {
+      uint32_t etx = (fields & ETX) ? words[k + 4] : 0;
+      uint32_t airtime = (fields & AIRTIME) ? words[k + recordSize / 4 - 1] : 0;
+      records.push_back (OlsbHeader (Ipv4Address (words[k]), words[k + 1], words[k + 2], words[k + 3], etx, airtime));
+    }
+  return true;
+}
+
 void
 OlsbHeader::Print (std::ostream &os) const
 {
   os << "DestinationIpv4: " << m_dst
      << " Hopcount: " << m_hopCount
      << " SequenceNumber: " << m_dstSeqNo
-     << " QueueSize: " << m_queuesize;
+     << " QueueSize: " << m_queuesize
+     << " Etx: " << m_etx
+     << " Airtime: " << m_airtime;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (TypeHeader);
+
+const uint8_t TypeHeader::MARKER;
+
+TypeHeader::TypeHeader (MessageType type)
+  : m_type (type),
+    m_valid (true)
+{
+}
+
+TypeId
+TypeHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::olsb::TypeHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Olsb")
+    .AddConstructor<TypeHeader> ();
+  return tid;
+}
+
+TypeId
+TypeHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+TypeHeader::GetSerializedSize () const
+{
+  return 2;
+}
+
+void
+TypeHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU8 (MARKER);
+  i.WriteU8 ((uint8_t) m_type);
+}
+
+uint32_t
+TypeHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  if (i.GetRemainingSize () < 2)
+    {
+      m_valid = false;
+      return 0;
+    }
+  uint8_t marker = i.ReadU8 ();
+  uint8_t type = i.ReadU8 ();
+  m_valid = (marker == MARKER);
+  switch (type)
+    {
+    case OLSB_BACKLOG:
+    case OLSB_POSITION:
+    case OLSB_LOCATION:
+    case OLSB_COMPACT_UPDATE:
+    case OLSB_FULL_REQUEST:
+    case OLSB_DIGEST:
+    case OLSB_PULL:
+    case OLSB_HELLO:
+    case OLSB_FULL_UPDATE:
+    case OLSB_RECORD_FIELDS:
+      {
+        m_type = (MessageType) type;
+        break;
+      }
+    default:
+      m_valid = false;
+    }
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+TypeHeader::Print (std::ostream &os) const
+{
+  switch (m_type)
+    {
+    case OLSB_BACKLOG:
+      {
+        os << "BACKLOG";
+        break;
+      }
+    case OLSB_POSITION:
+      {
+        os << "POSITION";
+        break;
+      }
+    case OLSB_LOCATION:
+      {
+        os << "LOCATION";
+        break;
+      }
+    case OLSB_COMPACT_UPDATE:
+      {
+        os << "COMPACT_UPDATE";
+        break;
+      }
+    case OLSB_FULL_REQUEST:
+      {
+        os << "FULL_REQUEST";
+        break;
+      }
+    case OLSB_DIGEST:
+      {
+        os << "DIGEST";
+        break;
+      }
+    case OLSB_PULL:
+      {
+        os << "PULL";
+        break;
+      }
+    case OLSB_HELLO:
+      {
+        os << "HELLO";
+        break;
+      }
+    case OLSB_FULL_UPDATE:
+      {
+        os << "FULL_UPDATE";
+        break;
+      }
+    case OLSB_RECORD_FIELDS:
+      {
+        os << "RECORD_FIELDS";
+        break;
+      }
+    default:
+      os << "UNKNOWN_TYPE";
+    }
+}
+
+NS_OBJECT_ENSURE_REGISTERED (BacklogHeader);
+
+BacklogHeader::BacklogHeader ()
+{
+}
+
+TypeId
+BacklogHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::olsb::BacklogHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Olsb")
+    .AddConstructor<BacklogHeader> ();
+  return tid;
+}
+
+TypeId
+BacklogHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+BacklogHeader::GetSerializedSize () const
+{
+  return 2 + 8 * m_backlogs.size ();
+}
+
+void
+BacklogHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteHtonU16 (m_backlogs.size ());
+  for (std::map<Ipv4Address, uint32_t>::const_iterator j = m_backlogs.begin (); j != m_backlogs.end (); ++j)
+    {
+      WriteTo (i, j->first);
+      i.WriteHtonU32 (j->second);
+    }
+}
+
+uint32_t
+BacklogHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_backlogs.clear ();
+  if (i.GetRemainingSize () < 2)
+    {
+      return 0;
+    }
+  uint16_t count = i.ReadNtohU16 ();
+  if (count * 8u > i.GetRemainingSize ())
+    {
+      // Truncated message
+      return 0;
+    }
+  for (uint16_t k = 0; k < count; ++k)
+    {
+      Ipv4Address dst;
+      ReadFrom (i, dst);
+      m_backlogs[dst] = i.ReadNtohU32 ();
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+BacklogHeader::Print (std::ostream &os) const
+{
+  os << "Backlogs:";
+  for (std::map<Ipv4Address, uint32_t>::const_iterator j = m_backlogs.begin (); j != m_backlogs.end (); ++j)
+    {
+      os << " " << j->first << ": " << j->second;
+    }
+}
+
+NS_OBJECT_ENSURE_REGISTERED (PositionHeader);
+
+PositionHeader::PositionHeader (const Vector &position, const Vector &velocity)
+  : m_position (position),
+    m_velocity (velocity)
+{
+}
+
+TypeId
+PositionHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::olsb::PositionHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Olsb")
+    .AddConstructor<PositionHeader> ();
+  return tid;
+}
+
+TypeId
+PositionHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+PositionHeader::GetSerializedSize () const
+{
+  return 24;
+}
+
+/**
+ * Write a length as signed centimeters
+ * \param i the buffer iterator
+ * \param value the length in meters
+ */
+static void
+WriteCentimeters (Buffer::Iterator &i, double value)
+{
+  i.WriteHtonU32 ((uint32_t) (int32_t) std::lround (value * 100));
+}
+
+/**
+ * Read a length written as signed centimeters
+ * \param i the buffer iterator
+ * \returns the length in meters
+ */
+static double
+ReadCentimeters (Buffer::Iterator &i)
+{
+  return (int32_t) i.ReadNtohU32 () / 100.0;
+}
+
+void
+PositionHeader::Serialize (Buffer::Iterator i) const
+{
+  WriteCentimeters (i, m_position.x);
+  WriteCentimeters (i, m_position.y);
+  WriteCentimeters (i, m_position.z);
+  WriteCentimeters (i, m_velocity.x);
+  WriteCentimeters (i, m_velocity.y);
+  WriteCentimeters (i, m_velocity.z);
+}
+
+uint32_t
+PositionHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  if (i.GetRemainingSize () < GetSerializedSize ())
+    {
+      // Truncated message
+      return 0;
+    }
+  m_position.x = ReadCentimeters (i);
+  m_position.y = ReadCentimeters (i);
+  m_position.z = ReadCentimeters (i);
+  m_velocity.x = ReadCentimeters (i);
+  m_velocity.y = ReadCentimeters (i);
+  m_velocity.z = ReadCentimeters (i);
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+PositionHeader::Print (std::ostream &os) const
+{
+  os << "Position: " << m_position << " Velocity: " << m_velocity;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (LocationHeader);
+
+LocationHeader::LocationHeader ()
+{
+}
+
+TypeId
+LocationHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::olsb::LocationHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Olsb")
+    .AddConstructor<LocationHeader> ();
+  return tid;
+}
+
+TypeId
+LocationHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+LocationHeader::GetSerializedSize () const
+{
+  return 2 + 20 * m_records.size ();
+}
+
+void
+LocationHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteHtonU16 (m_records.size ());
+  for (std::map<Ipv4Address, Record>::const_iterator j = m_records.begin (); j != m_records.end (); ++j)
+    {
+      WriteTo (i, j->first);
+      WriteCentimeters (i, j->second.position.x);
+      WriteCentimeters (i, j->second.position.y);
+      WriteCentimeters (i, j->second.position.z);
+      i.WriteHtonU32 (j->second.age.GetMilliSeconds ());
+    }
+}
+
+uint32_t
+LocationHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_records.clear ();
+  if (i.GetRemainingSize () < 2)
+    {
+      return 0;
+    }
+  uint16_t count = i.ReadNtohU16 ();
+  if (count * 20u > i.GetRemainingSize ())
+    {
+      // Truncated message
+      return 0;
+    }
+  for (uint16_t k = 0; k < count; ++k)
+    {
+      Ipv4Address node;
+      ReadFrom (i, node);
+      Record &record = m_records[node];
+      record.position.x = ReadCentimeters (i);
+      record.position.y = ReadCentimeters (i);
+      record.position.z = ReadCentimeters (i);
+      record.age = MilliSeconds (i.ReadNtohU32 ());
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+LocationHeader::Print (std::ostream &os) const
+{
+  os << "Locations:";
+  for (std::map<Ipv4Address, Record>::const_iterator j = m_records.begin (); j != m_records.end (); ++j)
+    {
+      os << " " << j->first << ": " << j->second.position << " (" << j->second.age.As (Time::S) << " old)";
+    }
+}
+
+/**
+ * Get the size of a varint
+ * \param value the value
+ * \returns the number of bytes of its encoding
+ */
+static uint32_t
+GetVarintSize (uint32_t value)
+{
+  uint32_t size = 1;
+  while (value >= 0x80)
+    {
+      value >>= 7;
+      size++;
+    }
+  return size;
+}
+
+/**
+ * Write a varint
+ * \param i the buffer iterator
+ * \param value the value
+ */
+static void
+WriteVarint (Buffer::Iterator &i, uint32_t value)
+{
+  while (value >= 0x80)
+    {
+      i.WriteU8 ((uint8_t) (value | 0x80));
+      value >>= 7;
+    }
+  i.WriteU8 ((uint8_t) value);
+}
+
+/**
+ * Read a varint
+ * \param i the buffer iterator
+ * \param value the value
+ * \returns false if the buffer ends before the last byte of the varint
+ */
+static bool
+ReadVarint (Buffer::Iterator &i, uint32_t &value)
+{
+  value = 0;
+  for (uint32_t shift = 0; shift < 35; shift += 7)
+    {
+      if (i.IsEnd ())
+        {
+          return false;
+        }
+      uint8_t byte = i.ReadU8 ();
+      value |= (uint32_t) (byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        {
+          break;
+        }
+    }
+  return true;
+}
+
+/**
+ * Map the difference of two sequence numbers to an unsigned value, small differences of either
+ * sign giving small values
+ * \param seqNo the sequence number
+ * \param previous the previous sequence number
+ * \returns the zigzag coded difference
+ */
+static uint32_t
+ZigZagDelta (uint32_t seqNo, uint32_t previous)
+{
+  int32_t delta = (int32_t) (seqNo - previous);
+  return ((uint32_t) delta << 1) ^ (uint32_t) (delta >> 31);
+}
+
+/**
+ * Undo ZigZagDelta
+ * \param value the zigzag coded difference
+ * \param previous the previous sequence number
+ * \returns the sequence number
+ */
+static uint32_t
+ZigZagUndo (uint32_t value, uint32_t previous)
+{
+  return previous + ((value >> 1) ^ (0u - (value & 1)));
+}
+
+/**
+ * Order records by destination address
+ * \param a a record
+ * \param b another record
+ * \returns true if a comes before b
+ */
+static bool
+IsBeforeInAddress (const OlsbHeader &a, const OlsbHeader &b)
+{
+  return a.GetDst () < b.GetDst ();
+}
+
+NS_OBJECT_ENSURE_REGISTERED (CompactUpdateHeader);
+
+const uint8_t CompactUpdateHeader::VERSION;
+
+CompactUpdateHeader::CompactUpdateHeader ()
+  : m_valid (true)
+{
+}
+
+TypeId
+CompactUpdateHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::olsb::CompactUpdateHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Olsb")
+    .AddConstructor<CompactUpdateHeader> ();
+  return tid;
+}
+
+TypeId
+CompactUpdateHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+void
+CompactUpdateHeader::AddRecord (const OlsbHeader &record)
+{
+  m_records.push_back (record);
+}
+
+uint8_t
+CompactUpdateHeader::GetFlags () const
+{
+  uint8_t flags = 0;
+  for (std::vector<OlsbHeader>::const_iterator r = m_records.begin (); r != m_records.end (); ++r)
+    {
+      if (r->GetQueueSize () != m_records.front ().GetQueueSize ())
+        {
+          flags |= QUEUE;
+        }
+      if (r->GetEtx () != 0)
+        {
+          flags |= ETX;
+        }
+      if (r->GetAirtime () != 0)
+        {
+          flags |= AIRTIME;
+        }
+    }
+  return flags;
+}
+
+uint32_t
+CompactUpdateHeader::GetCommonQueueSize () const
+{
+  if (m_records.empty () || (GetFlags () & QUEUE))
+    {
+      return 0;
+    }
+  return m_records.front ().GetQueueSize ();
+}
+
+std::vector<OlsbHeader>
+CompactUpdateHeader::GetSortedRecords () const
+{
+  std::vector<OlsbHeader> records (m_records);
+  std::stable_sort (records.begin (), records.end (), IsBeforeInAddress);
+  return records;
+}
+
+uint32_t
+CompactUpdateHeader::GetSerializedSize () const
+{
+  uint8_t flags = GetFlags ();
+  uint32_t size = 2 + GetVarintSize (m_records.size ()) + GetVarintSize (GetCommonQueueSize ()) + 4;
+  std::vector<OlsbHeader> records = GetSortedRecords ();
+  uint32_t address = records.empty () ? 0 : records.front ().GetDst ().Get ();
+  uint32_t seqNo = 0;
+  for (std::vector<OlsbHeader>::const_iterator r = records.begin (); r != records.end (); ++r)
+    {
+      size += GetVarintSize (r->GetDst ().Get () - address) + 1 + GetVarintSize (ZigZagDelta (r->GetDstSeqno (), seqNo));
+      size += (flags & QUEUE) ? GetVarintSize (r->GetQueueSize ()) : 0;
+      size += (flags & ETX) ? GetVarintSize (r->GetEtx ()) : 0;
+      size += (flags & AIRTIME) ? GetVarintSize (r->GetAirtime ()) : 0;
+      address = r->GetDst ().Get ();
+      seqNo = r->GetDstSeqno ();
+    }
+  return size;
+}
+
+void
+CompactUpdateHeader::Serialize (Buffer::Iterator i) const
+{
+  uint8_t flags = GetFlags ();
+  std::vector<OlsbHeader> records = GetSortedRecords ();
+  i.WriteU8 (VERSION);
+  i.WriteU8 (flags);
+  WriteVarint (i, records.size ());
+  WriteVarint (i, GetCommonQueueSize ());
+  uint32_t address = records.empty () ? 0 : records.front ().GetDst ().Get ();
+  i.WriteHtonU32 (address);
+  uint32_t seqNo = 0;
+  for (std::vector<OlsbHeader>::const_iterator r = records.begin (); r != records.end (); ++r)
+    {
+      WriteVarint (i, r->GetDst ().Get () - address);
+      i.WriteU8 ((uint8_t) std::min (r->GetHopCount (), 255u));
+      WriteVarint (i, ZigZagDelta (r->GetDstSeqno (), seqNo));
+      if (flags & QUEUE)
+        {
+          WriteVarint (i, r->GetQueueSize ());
+        }
+      if (flags & ETX)
+        {
+          WriteVarint (i, r->GetEtx ());
+        }
+      if (flags & AIRTIME)
+        {
+          WriteVarint (i, r->GetAirtime ());
+        }
+      address = r->GetDst ().Get ();
+      seqNo = r->GetDstSeqno ();
+    }
+}
+
+uint32_t
+CompactUpdateHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_records.clear ();
+  if (i.GetRemainingSize () < 2)
+    {
+      return 0;
+    }
+  m_valid = (i.ReadU8 () == VERSION);
+  if (!m_valid)
+    {
+      return i.GetDistanceFrom (start);
+    }
+  uint8_t flags = i.ReadU8 ();
+  uint32_t count, queueSize;
+  // Every record takes at least three bytes, so a count beyond the remaining size is a truncated message
+  if (!ReadVarint (i, count) || !ReadVarint (i, queueSize) || i.GetRemainingSize () < 4
+      || count > (i.GetRemainingSize () - 4) / 3)
+    {
+      return 0;
+    }
+  uint32_t address = i.ReadNtohU32 ();
+  uint32_t seqNo = 0;
+  for (uint32_t k = 0; k < count; ++k)
+    {
+      uint32_t delta, seqNoDelta;
+      uint32_t queue = queueSize, etx = 0, airtime = 0;
+      uint8_t hopCount = 0;
+      bool complete = ReadVarint (i, delta) && !i.IsEnd ();
+      if (complete)
+        {
+          hopCount = i.ReadU8 ();
+        }
+      complete = complete && ReadVarint (i, seqNoDelta)
+        && (!(flags & QUEUE) || ReadVarint (i, queue))
+        && (!(flags & ETX) || ReadVarint (i, etx))
+        && (!(flags & AIRTIME) || ReadVarint (i, airtime));
+      if (!complete)
+        {
+          m_records.clear ();
+          return 0;
+        }
+      OlsbHeader record;
+      address += delta;
+      record.SetDst (Ipv4Address (address));
+      record.SetHopCount (hopCount);
+      seqNo = ZigZagUndo (seqNoDelta, seqNo);
+      record.SetDstSeqno (seqNo);
+      record.SetQueueSize (queue);
+      record.SetEtx (etx);
+      record.SetAirtime (airtime);
+      m_records.push_back (record);
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+CompactUpdateHeader::Print (std::ostream &os) const
+{
+  os << "Records: " << m_records.size ();
+  for (std::vector<OlsbHeader>::const_iterator r = m_records.begin (); r != m_records.end (); ++r)
+    {
+      os << " [" << *r << "]";
+    }
+}
+
+CompactUpdateSizer::CompactUpdateSizer ()
+  : m_deltaBytes (0),
+    m_firstQueueSize (0),
+    m_queueDiffers (false),
+    m_queueBytes (0),
+    m_etxBytes (0),
+    m_airtimeBytes (0)
+{
+}
+
+int32_t
+CompactUpdateSizer::GetDeltaBytesWith (const OlsbHeader &record) const
+{
+  // Records of the same address keep the order they were added in, as in GetSortedRecords
+  uint32_t address = record.GetDst ().Get ();
+  Records::const_iterator next = m_records.upper_bound (address);
+  int32_t bytes = 0;
+  if (next == m_records.begin ())
+    {
+      // The record becomes the base address
+      bytes += GetVarintSize (0) + GetVarintSize (ZigZagDelta (record.GetDstSeqno (), 0));
+      if (next != m_records.end ())
+        {
+          bytes += GetVarintSize (next->first - address) + GetVarintSize (ZigZagDelta (next->second, record.GetDstSeqno ()));
+          bytes -= GetVarintSize (0) + GetVarintSize (ZigZagDelta (next->second, 0));
+        }
+      return bytes;
+    }
+  Records::const_iterator previous = next;
+  --previous;
+  bytes += GetVarintSize (address - previous->first) + GetVarintSize (ZigZagDelta (record.GetDstSeqno (), previous->second));
+  if (next != m_records.end ())
+    {
+      bytes += GetVarintSize (next->first - address) + GetVarintSize (ZigZagDelta (next->second, record.GetDstSeqno ()));
+      bytes -= GetVarintSize (next->first - previous->first) + GetVarintSize (ZigZagDelta (next->second, previous->second));
+    }
+  return bytes;
+}
+
+uint32_t
+CompactUpdateSizer::GetSize (uint32_t count, uint32_t deltaBytes, uint32_t commonQueueSize, uint32_t queueBytes,
+                             uint32_t etxBytes, uint32_t airtimeBytes) const
+{
+  return 2 + GetVarintSize (count) + GetVarintSize (commonQueueSize) + 4 + deltaBytes + count + queueBytes + etxBytes
+         + airtimeBytes;
+}
+
+uint32_t
+CompactUpdateSizer::GetSize () const
+{
+  if (m_queueDiffers)
+    {
+      return GetSize (m_records.size (), m_deltaBytes, 0, m_queueBytes, m_etxBytes, m_airtimeBytes);
+    }
+  return GetSize (m_records.size (), m_deltaBytes, m_firstQueueSize, 0, m_etxBytes, m_airtimeBytes);
+}
+
+uint32_t
+CompactUpdateSizer::GetSizeWith (const OlsbHeader &record) const
+{
+  uint32_t etxBytes = m_etxBytes;
+  if (record.GetEtx () != 0 || etxBytes != 0)
+    {
+      // The first nonzero ETX makes every record carry one
+      etxBytes = (etxBytes == 0 ? m_records.size () : etxBytes) + GetVarintSize (record.GetEtx ());
+    }
+  uint32_t airtimeBytes = m_airtimeBytes;
+  if (record.GetAirtime () != 0 || airtimeBytes != 0)
+    {
+      airtimeBytes = (airtimeBytes == 0 ? m_records.size () : airtimeBytes) + GetVarintSize (record.GetAirtime ());
+    }
+  uint32_t count = m_records.size () + 1;
+  uint32_t deltaBytes = m_deltaBytes + GetDeltaBytesWith (record);
+  if (m_records.empty ())
+    {
+      return GetSize (count, deltaBytes, record.GetQueueSize (), 0, etxBytes, airtimeBytes);
+    }
+  if (m_queueDiffers || record.GetQueueSize () != m_firstQueueSize)
+    {
+      return GetSize (count, deltaBytes, 0, m_queueBytes + GetVarintSize (record.GetQueueSize ()), etxBytes,
+                      airtimeBytes);
+    }
+  return GetSize (count, deltaBytes, m_firstQueueSize, 0, etxBytes, airtimeBytes);
+}
+
+void
+CompactUpdateSizer::AddRecord (const OlsbHeader &record)
+{
+  m_deltaBytes += GetDeltaBytesWith (record);
+  if (m_records.empty ())
+    {
+      m_firstQueueSize = record.GetQueueSize ();
+    }
+  m_queueDiffers = m_queueDiffers || record.GetQueueSize () != m_firstQueueSize;
+  m_queueBytes += GetVarintSize (record.GetQueueSize ());
+  if (record.GetEtx () != 0 || m_etxBytes != 0)
+    {
+      m_etxBytes = (m_etxBytes == 0 ? m_records.size () : m_etxBytes) + GetVarintSize (record.GetEtx ());
+    }
+  if (record.GetAirtime () != 0 || m_airtimeBytes != 0)
+    {
+      m_airtimeBytes = (m_airtimeBytes == 0 ? m_records.size () : m_airtimeBytes) + GetVarintSize (record.GetAirtime ());
+    }
+  m_records.insert (std::make_pair (record.GetDst ().Get (),record.GetDstSeqno ()));
+}
+
+NS_OBJECT_ENSURE_REGISTERED (DigestHeader);
+
+DigestHeader::DigestHeader ()
+{
+}
+
+TypeId
+DigestHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::olsb::DigestHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Olsb")
+    .AddConstructor<DigestHeader> ();
+  return tid;
+}
+
+TypeId
+DigestHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+DigestHeader::GetSerializedSize () const
+{
+  return 2 + 8 * m_ranges.size ();
+}
+
+void
+DigestHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteHtonU16 (m_ranges.size ());
+  for (std::vector<std::pair<Ipv4Address, uint32_t> >::const_iterator r = m_ranges.begin (); r != m_ranges.end (); ++r)
+    {
+      WriteTo (i, r->first);
+      i.WriteHtonU32 (r->second);
+    }
+}
+
+uint32_t
+DigestHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_ranges.clear ();
+  if (i.GetRemainingSize () < 2)
+    {
+      return 0;
+    }
+  uint16_t count = i.ReadNtohU16 ();
+  if (count * 8u > i.GetRemainingSize ())
+    {
+      // Truncated message
+      return 0;
+    }
+  for (uint16_t k = 0; k < count; ++k)
+    {
+      Ipv4Address first;
+      ReadFrom (i, first);
+      m_ranges.push_back (std::make_pair (first, i.ReadNtohU32 ()));
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+DigestHeader::Print (std::ostream &os) const
+{
+  os << "Ranges:";
+  for (std::vector<std::pair<Ipv4Address, uint32_t> >::const_iterator r = m_ranges.begin (); r != m_ranges.end (); ++r)
+    {
+      os << " " << r->first << ": " << r->second;
+    }
+}
+
+uint32_t
+DigestHeader::Hash (Ipv4Address dst, uint32_t seqno)
+{
+  // Mix the bits of both values so that the sums of different sets of routes rarely match
+  uint32_t h = dst.Get () * 0x9e3779b1u ^ seqno * 0x85ebca6bu;
+  h ^= h >> 16;
+  h *= 0x7feb352du;
+  h ^= h >> 15;
+  h *= 0x846ca68bu;
+  h ^= h >> 16;
+  return h;
+}
+
+void
+DigestHeader::SetRoutes (const std::map<Ipv4Address, uint32_t> &seqnos, uint32_t maxRanges)
+{
+  m_ranges.clear ();
+  uint32_t ranges = std::max<uint32_t> (1, std::min<uint32_t> (maxRanges, seqnos.size ()));
+  uint32_t perRange = (seqnos.size () + ranges - 1) / ranges;
+  m_ranges.push_back (std::make_pair (Ipv4Address ((uint32_t) 0), 0));
+  uint32_t count = 0;
+  for (std::map<Ipv4Address, uint32_t>::const_iterator i = seqnos.begin (); i != seqnos.end (); ++i)
+    {
+      if (count == perRange)
+        {
+          m_ranges.push_back (std::make_pair (i->first, 0));
+          count = 0;
+        }
+      m_ranges.back ().second += Hash (i->first, i->second);
+      count++;
+    }
+}
+
+std::vector<AddressRange>
+DigestHeader::GetRanges () const
+{
+  std::vector<AddressRange> ranges;
+  for (uint32_t k = 0; k < m_ranges.size (); k++)
+    {
+      Ipv4Address last = k + 1 < m_ranges.size () ? Ipv4Address (m_ranges[k + 1].first.Get () - 1)
+        : Ipv4Address (0xffffffff);
+      ranges.push_back (std::make_pair (m_ranges[k].first, last));
+    }
+  return ranges;
+}
+
+void
+DigestHeader::GetDifferingRanges (const std::map<Ipv4Address, uint32_t> &seqnos, std::vector<AddressRange> &ranges) const
+{
+  std::vector<AddressRange> all = GetRanges ();
+  if (all.empty ())
+    {
+      return;
+    }
+  std::vector<uint32_t> hashes (all.size (), 0);
+  uint32_t k = 0;
+  for (std::map<Ipv4Address, uint32_t>::const_iterator i = seqnos.begin (); i != seqnos.end (); ++i)
+    {
+      while (k + 1 < all.size () && all[k].second < i->first)
+        {
+          k++;
+        }
+      hashes[k] += Hash (i->first, i->second);
+    }
+  for (k = 0; k < all.size (); k++)
+    {
+      if (hashes[k] != m_ranges[k].second)
+        {
+          ranges.push_back (all[k]);
+        }
+    }
+}
+
+NS_OBJECT_ENSURE_REGISTERED (PullHeader);
+
+PullHeader::PullHeader ()
+{
+}
+
+TypeId
+PullHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::olsb::PullHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Olsb")
+    .AddConstructor<PullHeader> ();
+  return tid;
+}
+
+TypeId
+PullHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+PullHeader::GetSerializedSize () const
+{
+  return 2 + 8 * m_ranges.size ();
+}
+
+void
+PullHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteHtonU16 (m_ranges.size ());
+  for (std::vector<AddressRange>::const_iterator r = m_ranges.begin (); r != m_ranges.end (); ++r)
+    {
+      WriteTo (i, r->first);
+      WriteTo (i, r->second);
+    }
+}
+
+uint32_t
+PullHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_ranges.clear ();
+  if (i.GetRemainingSize () < 2)
+    {
+      return 0;
+    }
+  uint16_t count = i.ReadNtohU16 ();
+  if (count * 8u > i.GetRemainingSize ())
+    {
+      // Truncated message
+      return 0;
+    }
+  for (uint16_t k = 0; k < count; ++k)
+    {
+      Ipv4Address first, last;
+      ReadFrom (i, first);
+      ReadFrom (i, last);
+      m_ranges.push_back (std::make_pair (first, last));
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+PullHeader::Print (std::ostream &os) const
+{
+  os << "Ranges:";
+  for (std::vector<AddressRange>::const_iterator r = m_ranges.begin (); r != m_ranges.end (); ++r)
+    {
+      os << " " << r->first << "-" << r->second;
+    }
+}
+
+bool
+PullHeader::Contains (Ipv4Address address) const
+{
+  for (std::vector<AddressRange>::const_iterator r = m_ranges.begin (); r != m_ranges.end (); ++r)
+    {
+      if (!(address < r->first) && !(r->second < address))
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (HelloHeader);
+
+HelloHeader::HelloHeader ()
+{
+}
+
+TypeId
+HelloHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::olsb::HelloHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Olsb")
+    .AddConstructor<HelloHeader> ();
+  return tid;
+}
+
+TypeId
+HelloHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+HelloHeader::GetSerializedSize () const
+{
+  return 2 + 4 * m_neighbors.size ();
+}
+
+void
+HelloHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteHtonU16 (m_neighbors.size ());
+  for (std::vector<Ipv4Address>::const_iterator n = m_neighbors.begin (); n != m_neighbors.end (); ++n)
+    {
+      WriteTo (i, *n);
+    }
+}
+
+uint32_t
+HelloHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_neighbors.clear ();
+  if (i.GetRemainingSize () < 2)
+    {
+      return 0;
+    }
+  uint16_t count = i.ReadNtohU16 ();
+  if (count * 4u > i.GetRemainingSize ())
+    {
+      // Truncated message
+      return 0;
+    }
+  for (uint16_t k = 0; k < count; ++k)
+    {
+      Ipv4Address neighbor;
+      ReadFrom (i, neighbor);
+      m_neighbors.push_back (neighbor);
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+HelloHeader::Print (std::ostream &os) const
+{
+  os << "Neighbors:";
+  for (std::vector<Ipv4Address>::const_iterator n = m_neighbors.begin (); n != m_neighbors.end (); ++n)
+    {
+      os << " " << *n;
+    }
+}
+
+NS_OBJECT_ENSURE_REGISTERED (FullUpdateHeader);
+
+FullUpdateHeader::FullUpdateHeader (uint16_t updateId, uint8_t fragment, uint8_t fragmentCount)
+  : m_updateId (updateId),
+    m_fragment (fragment),
+    m_fragmentCount (fragmentCount)
+{
+}
+
+TypeId
+FullUpdateHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::olsb::FullUpdateHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Olsb")
+    .AddConstructor<FullUpdateHeader> ();
+  return tid;
+}
+
+TypeId
+FullUpdateHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+FullUpdateHeader::GetSerializedSize () const
+{
+  return 4;
+}
+
+void
+FullUpdateHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteHtonU16 (m_updateId);
+  i.WriteU8 (m_fragment);
+  i.WriteU8 (m_fragmentCount);
+}
+
+uint32_t
+FullUpdateHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  if (i.GetRemainingSize () < GetSerializedSize ())
+    {
+      // Truncated message
+      return 0;
+    }
+  m_updateId = i.ReadNtohU16 ();
+  m_fragment = i.ReadU8 ();
+  m_fragmentCount = i.ReadU8 ();
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+FullUpdateHeader::Print (std::ostream &os) const
+{
+  os << "Update: " << m_updateId << " Fragment: " << (uint32_t) m_fragment << "/" << (uint32_t) m_fragmentCount;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (RecordFieldsHeader);
+
+RecordFieldsHeader::RecordFieldsHeader (uint8_t fields)
+  : m_fields (fields)
+{
+}
+
+TypeId
+RecordFieldsHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::olsb::RecordFieldsHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Olsb")
+    .AddConstructor<RecordFieldsHeader> ();
+  return tid;
+}
+
+TypeId
+RecordFieldsHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+RecordFieldsHeader::GetSerializedSize () const
+{
+  return 1;
+}
+
+void
+RecordFieldsHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU8 (m_fields);
+}
+
+uint32_t
+RecordFieldsHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  if (i.GetRemainingSize () < GetSerializedSize ())
+    {
+      // Truncated message
+      return 0;
+    }
+  m_fields = i.ReadU8 ();
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+bool
+RecordFieldsHeader::IsValid () const
+{
+  return (m_fields & ~(OlsbHeader::ETX | OlsbHeader::AIRTIME)) == 0;
+}
+
+void
+RecordFieldsHeader::Print (std::ostream &os) const
+{
+  os << "Fields: " << (uint32_t) m_fields;
 }
 }
 }
@@ -27,9 +27,12 @@
 #define OLSB_PACKET_H
 
 #include <iostream>
+#include <map>
+#include <vector>
 #include "ns3/header.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/nstime.h"
+#include "ns3/vector.h"
 
 namespace ns3 {
 namespace olsb {
@@ -48,12 +51,27 @@ namespace olsb {
  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  |                          queue size                           |
  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                    Path ETX (optional)                        |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                  Path Airtime (optional)                      |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  * \endverbatim
+ *
+ * The path ETX is the expected transmission count from the sender to the destination, scaled by
+ * LinkEstimator::ETX_SCALE. The path airtime is the expected transmission time (ETT) of a reference
+ * packet from the sender to the destination, in microseconds. Each is only carried when a
+ * RecordFieldsHeader leading the records sets its OlsbHeader::Fields flag, otherwise it is 0.
  */
 
 class OlsbHeader : public Header
 {
 public:
+  /// Optional record fields
+  enum Fields
+  {
+    ETX = 1, //!< The record carries its path ETX
+    AIRTIME = 2, //!< The record carries its path airtime
+  };
   /**
    * Constructor
    *
@@ -61,8 +79,11 @@ public:
    * \param hopcount hop count
    * \param dstSeqNo destination sequence number
    * \param queueSize local queue size
+   * \param etx path ETX
+   * \param airtime path airtime in microseconds
    */
-  OlsbHeader (Ipv4Address dst = Ipv4Address (), uint32_t hopcount = 0, uint32_t dstSeqNo = 0, uint32_t queueSize = 0);
+  OlsbHeader (Ipv4Address dst = Ipv4Address (), uint32_t hopcount = 0, uint32_t dstSeqNo = 0, uint32_t queueSize = 0,
+              uint32_t etx = 0, uint32_t airtime = 0);
   virtual ~OlsbHeader ();
   /**
    * \brief Get the type ID.
@@ -74,6 +95,46 @@ public:
   virtual void Serialize (Buffer::Iterator start) const;
   virtual uint32_t Deserialize (Buffer::Iterator start);
   virtual void Print (std::ostream &os) const;
+  /**
+   * Decode a run of records in one pass
+   * \param data the serialized records
+   * \param size the size of data in bytes
+   * \param fields the optional fields of the records
+   * \param records the decoded records are appended to it
+   * \returns false, leaving records untouched, if size is not a whole number of records
+   */
+  static bool DeserializeRecords (const uint8_t *data, uint32_t size, uint8_t fields, std::vector<OlsbHeader> &records);
+  /**
+   * Get the size of a record
+   * \param fields the optional fields of the record
+   * \returns the serialized size of a record with these fields
+   */
+  static uint32_t GetRecordSize (uint8_t fields);
+  /**
+   * Get the optional fields that a run of records needs
+   * \param records the route update records
+   * \returns the fields with a nonzero value in some record
+   */
+  static uint8_t GetNeededFields (const std::vector<OlsbHeader> &records);
+
+  /**
+   * Set the optional fields that the record is serialized with
+   * \param fields the optional fields
+   */
+  void
+  SetFields (uint8_t fields)
+  {
+    m_fields = fields;
+  }
+  /**
+   * Get the optional fields that the record is serialized with
+   * \returns the optional fields
+   */
+  uint8_t
+  GetFields () const
+  {
+    return m_fields;
+  }
 
   /**
    * Set destination address
@@ -147,17 +208,892 @@ public:
   {
     return m_queuesize;
   }
+  /**
+   * Set path ETX
+   * \param etx The path ETX
+   */
+  void
+  SetEtx (uint32_t etx)
+  {
+    m_etx = etx;
+  }
+  /**
+   * Get path ETX
+   * \returns the path ETX
+   */
+  uint32_t
+  GetEtx () const
+  {
+    return m_etx;
+  }
+  /**
+   * Set path airtime
+   * \param airtime The path airtime in microseconds
+   */
+  void
+  SetAirtime (uint32_t airtime)
+  {
+    m_airtime = airtime;
+  }
+  /**
+   * Get path airtime
+   * \returns the path airtime in microseconds
+   */
+  uint32_t
+  GetAirtime () const
+  {
+    return m_airtime;
+  }
 private:
   Ipv4Address m_dst; ///< Destination IP Address
   uint32_t m_hopCount; ///< Number of Hops
   uint32_t m_dstSeqNo; ///< Destination Sequence Number
   uint32_t m_queuesize; ///< size of queue of routing unit 
+  uint32_t m_etx; ///< Path ETX
+  uint32_t m_airtime; ///< Path airtime in microseconds
+  uint8_t m_fields; ///< Optional fields serialized with the record
 };
 static inline std::ostream & operator<< (std::ostream& os, const OlsbHeader & packet)
 {
   packet.Print (os);
   return os;
 }
+
+/**
+ * \ingroup olsb
+ * \brief Types of the OLSB messages other than route updates
+ */
+enum MessageType
+{
+  OLSB_BACKLOG = 1, //!< Per-commodity backlogs of the sender
+  OLSB_POSITION = 2, //!< Position and velocity of the sender, followed by its route update records
+  OLSB_LOCATION = 3, //!< Positions of other nodes known to the sender, followed by its route update records
+  OLSB_COMPACT_UPDATE = 4, //!< Route update records in the compact encoding
+  OLSB_FULL_REQUEST = 5, //!< Request for a full update, without a body
+  OLSB_DIGEST = 6, //!< Hashes of the routes of the sender over address ranges
+  OLSB_PULL = 7, //!< Request for the routes of the receiver in some address ranges
+  OLSB_HELLO = 8, //!< Beacon listing the neighbors the sender hears
+  OLSB_FULL_UPDATE = 9, //!< Position of the packet in a full update, followed by its route update records
+  OLSB_RECORD_FIELDS = 10, //!< Optional fields of the fixed format records that follow
+};
+
+/**
+ * \ingroup olsb
+ * \brief OLSB Message Type Header
+ * \verbatim
+ |      0        |      1        |
+  0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |     Marker    |      Type     |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * \endverbatim
+ *
+ * Route updates start directly with the destination address of their first record. The marker is
+ * the first byte of a reserved (class E) address, which no record carries, so typed messages share
+ * the OLSB port with updates.
+ */
+class TypeHeader : public Header
+{
+public:
+  /// First byte of every typed message
+  static const uint8_t MARKER = 0xf5;
+  /**
+   * Constructor
+   * \param type the message type
+   */
+  TypeHeader (MessageType type = OLSB_BACKLOG);
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * Get the message type
+   * \returns the message type
+   */
+  MessageType
+  Get () const
+  {
+    return m_type;
+  }
+  /**
+   * Check that the marker and the type are known
+   * \returns true if the header is valid
+   */
+  bool
+  IsValid () const
+  {
+    return m_valid;
+  }
+private:
+  MessageType m_type; ///< Message type
+  bool m_valid; ///< Whether the marker and the type were recognised
+};
+static inline std::ostream & operator<< (std::ostream& os, const TypeHeader & header)
+{
+  header.Print (os);
+  return os;
+}
+
+/**
+ * \ingroup olsb
+ * \brief OLSB Backlog Message Format
+ * \verbatim
+ |      0        |      1        |      2        |       3       |
+  0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |          Record Count         |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                      Destination Address                      |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                            Backlog                            |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                              ...                              |
+ * \endverbatim
+ *
+ * The backlog is the number of packets that the sender holds for the destination in its commodity
+ * queue. The message carries the sender's whole state: destinations left out have an empty queue.
+ * A message shorter than its record count announces is not deserialized, Deserialize returns 0.
+ */
+class BacklogHeader : public Header
+{
+public:
+  /// c-tor
+  BacklogHeader ();
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * Set the backlog of a destination
+   * \param dst the destination IPv4 address
+   * \param backlog the number of packets held for dst
+   */
+  void
+  SetBacklog (Ipv4Address dst, uint32_t backlog)
+  {
+    m_backlogs[dst] = backlog;
+  }
+  /**
+   * Get the backlogs
+   * \returns the backlog of every destination carried by the message
+   */
+  const std::map<Ipv4Address, uint32_t> &
+  GetBacklogs () const
+  {
+    return m_backlogs;
+  }
+private:
+  std::map<Ipv4Address, uint32_t> m_backlogs; ///< Backlog per destination
+};
+static inline std::ostream & operator<< (std::ostream& os, const BacklogHeader & header)
+{
+  header.Print (os);
+  return os;
+}
+
+/**
+ * \ingroup olsb
+ * \brief OLSB Position Message Format
+ * \verbatim
+ |      0        |      1        |      2        |       3       |
+  0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                          Position X                           |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                          Position Y                           |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                          Position Z                           |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                          Velocity X                           |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                          Velocity Y                           |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                          Velocity Z                           |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * \endverbatim
+ *
+ * Coordinates are signed centimeters and velocities signed centimeters per second. The message
+ * leads a route update, so the records of the sender follow it in the same packet. A truncated
+ * message is not deserialized, Deserialize returns 0.
+ */
+class PositionHeader : public Header
+{
+public:
+  /**
+   * Constructor
+   * \param position the position of the sender in meters
+   * \param velocity the velocity of the sender in meters per second
+   */
+  PositionHeader (const Vector &position = Vector (), const Vector &velocity = Vector ());
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * Get the position of the sender
+   * \returns the position in meters
+   */
+  const Vector &
+  GetPosition () const
+  {
+    return m_position;
+  }
+  /**
+   * Get the velocity of the sender
+   * \returns the velocity in meters per second
+   */
+  const Vector &
+  GetVelocity () const
+  {
+    return m_velocity;
+  }
+private:
+  Vector m_position; ///< Position of the sender
+  Vector m_velocity; ///< Velocity of the sender
+};
+static inline std::ostream & operator<< (std::ostream& os, const PositionHeader & header)
+{
+  header.Print (os);
+  return os;
+}
+
+/**
+ * \ingroup olsb
+ * \brief OLSB Location Message Format
+ * \verbatim
+ |      0        |      1        |      2        |       3       |
+  0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |          Record Count         |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                         Node Address                          |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                          Position X                           |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                          Position Y                           |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                          Position Z                           |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                              Age                              |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                              ...                              |
+ * \endverbatim
+ *
+ * Coordinates are signed centimeters, as in the position message. The age is the time in
+ * milliseconds since the node was at that position, so receivers can keep the most recent one.
+ * A message shorter than its record count announces is not deserialized, Deserialize returns 0.
+ */
+class LocationHeader : public Header
+{
+public:
+  /// Position of one node
+  struct Record
+  {
+    Vector position; ///< position of the node
+    Time age; ///< time since the node was at that position
+  };
+
+  /// c-tor
+  LocationHeader ();
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * Set the position of a node
+   * \param node the node IPv4 address
+   * \param position the position of the node
+   * \param age the time since the node was at that position
+   */
+  void
+  SetLocation (Ipv4Address node, const Vector &position, Time age)
+  {
+    Record &record = m_records[node];
+    record.position = position;
+    record.age = age;
+  }
+  /**
+   * Get the positions
+   * \returns the position of every node carried by the message
+   */
+  const std::map<Ipv4Address, Record> &
+  GetLocations () const
+  {
+    return m_records;
+  }
+private:
+  std::map<Ipv4Address, Record> m_records; ///< Position per node
+};
+static inline std::ostream & operator<< (std::ostream& os, const LocationHeader & header)
+{
+  header.Print (os);
+  return os;
+}
+
+/**
+ * \ingroup olsb
+ * \brief Encoding of the route update records
+ */
+enum UpdateFormat
+{
+  FIXED_FORMAT, //!< One OlsbHeader per record, 16 bytes unless the records need optional fields
+  COMPACT_FORMAT, //!< One CompactUpdateHeader holding variable length records
+};
+
+/**
+ * \ingroup olsb
+ * \brief OLSB Compact Update Message Format
+ * \verbatim
+ |      0        |      1        |      2        |       3       |
+  0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |    Version    |     Flags     | Record Count (varint) ...
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ | Queue Size (varint) ...
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                         Base Address                          |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ followed by one record per destination:
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ | Address Delta (varint) ...    |   HopCount    |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ | Sequence Number Delta (zigzag varint) ...
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ | Queue Size (varint, if QUEUE) | Path ETX (varint, if ETX) | Path Airtime (varint, if AIRTIME)
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * \endverbatim
+ *
+ * Varints carry 7 bits per byte, least significant group first, with the top bit set on every byte
+ * but the last. Records are sorted by destination address: the first address is the base address
+ * and every record carries the difference to the previous one, which is small within a subnet.
+ * Sequence numbers are coded as the zigzag difference to the previous record, since all nodes
+ * start from zero and advance at the same pace. The queue size of the header applies to every
+ * record unless the QUEUE flag is set; path ETX and airtime are zero unless their flag is set.
+ * Hop counts saturate at 255. A message that ends before its last record is not deserialized,
+ * Deserialize returns 0.
+ */
+class CompactUpdateHeader : public Header
+{
+public:
+  /// Version of the encoding
+  static const uint8_t VERSION = 1;
+  /// Optional record fields
+  enum Flags
+  {
+    QUEUE = 1, //!< Every record carries its queue size
+    ETX = 2, //!< Every record carries its path ETX
+    AIRTIME = 4, //!< Every record carries its path airtime
+  };
+
+  /// c-tor
+  CompactUpdateHeader ();
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * Add a record
+   * \param record the route update record
+   */
+  void
+  AddRecord (const OlsbHeader &record);
+  /**
+   * Get the records
+   * \returns the records, sorted by destination address once deserialized
+   */
+  const std::vector<OlsbHeader> &
+  GetRecords () const
+  {
+    return m_records;
+  }
+  /**
+   * Check that the version is known
+   * \returns true if the header is valid
+   */
+  bool
+  IsValid () const
+  {
+    return m_valid;
+  }
+private:
+  /**
+   * Get the optional fields that the records need
+   * \returns the flags
+   */
+  uint8_t
+  GetFlags () const;
+  /**
+   * Get the queue size shared by all records
+   * \returns the queue size of the records, 0 if they differ
+   */
+  uint32_t
+  GetCommonQueueSize () const;
+  /**
+   * Get the records sorted by destination address
+   * \returns the sorted records
+   */
+  std::vector<OlsbHeader>
+  GetSortedRecords () const;
+
+  std::vector<OlsbHeader> m_records; ///< Route update records
+  bool m_valid; ///< Whether the version was recognised
+};
+static inline std::ostream & operator<< (std::ostream& os, const CompactUpdateHeader & header)
+{
+  header.Print (os);
+  return os;
+}
+
+/**
+ * \ingroup olsb
+ * \brief Serialized size of a compact update message, kept as its records are added
+ *
+ * A record only changes the encoding of the record that follows it in address order and the
+ * optional fields of the message, so adding one takes a logarithmic time. Splitting a large
+ * update record by record this way does not serialize every packet again for each record.
+ */
+class CompactUpdateSizer
+{
+public:
+  /// c-tor
+  CompactUpdateSizer ();
+  /**
+   * Add a record
+   * \param record the route update record
+   */
+  void
+  AddRecord (const OlsbHeader &record);
+  /**
+   * Get the serialized size of the message
+   * \returns the size of a CompactUpdateHeader carrying the records added
+   */
+  uint32_t
+  GetSize () const;
+  /**
+   * Get the serialized size the message would have with one more record
+   * \param record the route update record
+   * \returns the size of a CompactUpdateHeader carrying the records added and this one
+   */
+  uint32_t
+  GetSizeWith (const OlsbHeader &record) const;
+private:
+  /// Sequence numbers of the records, in the order the message carries them
+  typedef std::multimap<uint32_t, uint32_t> Records;
+  /**
+   * Get the bytes a record adds to the address and sequence number deltas
+   * \param record the route update record
+   * \returns the change of the delta bytes
+   */
+  int32_t
+  GetDeltaBytesWith (const OlsbHeader &record) const;
+  /**
+   * Get the size of the message from its parts
+   * \param count the number of records
+   * \param deltaBytes the bytes of the address and sequence number deltas
+   * \param commonQueueSize the queue size shared by all records, 0 if they differ
+   * \param queueBytes the bytes of the queue sizes of the records, 0 if they are all the same
+   * \param etxBytes the bytes of the path ETX of the records, 0 if they are all zero
+   * \param airtimeBytes the bytes of the path airtime of the records, 0 if they are all zero
+   * \returns the serialized size
+   */
+  uint32_t
+  GetSize (uint32_t count, uint32_t deltaBytes, uint32_t commonQueueSize, uint32_t queueBytes, uint32_t etxBytes,
+           uint32_t airtimeBytes) const;
+
+  Records m_records; ///< Records added, by destination address
+  uint32_t m_deltaBytes; ///< Bytes of the address and sequence number deltas
+  uint32_t m_firstQueueSize; ///< Queue size of the first record added
+  bool m_queueDiffers; ///< Whether the queue sizes of the records differ
+  uint32_t m_queueBytes; ///< Bytes of the queue sizes
+  uint32_t m_etxBytes; ///< Bytes of the path ETX, 0 while all of them are zero
+  uint32_t m_airtimeBytes; ///< Bytes of the path airtime, 0 while all of them are zero
+};
+
+/// Addresses from the first to the last, both included
+typedef std::pair<Ipv4Address, Ipv4Address> AddressRange;
+
+/**
+ * \ingroup olsb
+ * \brief OLSB Digest Message Format
+ * \verbatim
+ |      0        |      1        |      2        |       3       |
+  0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |          Range Count          |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                     First Address of Range                    |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                          Range Hash                           |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                              ...                              |
+ * \endverbatim
+ *
+ * The ranges are sorted and cover the whole address space: the first one starts at 0.0.0.0 and
+ * every range ends where the next one starts. The hash of a range is the sum of the hashes of the
+ * (destination, sequence number) pairs of the routes of the sender in that range, so a neighbor
+ * holding the same routes computes the same hash and only ranges that differ need to be pulled.
+ * The sender picks the ranges so that they hold about as many routes each. A message shorter than
+ * its range count announces is not deserialized, Deserialize returns 0.
+ */
+class DigestHeader : public Header
+{
+public:
+  /// c-tor
+  DigestHeader ();
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * Hash a route
+   * \param dst the destination of the route
+   * \param seqno the sequence number of the route
+   * \returns the hash of the pair
+   */
+  static uint32_t
+  Hash (Ipv4Address dst, uint32_t seqno);
+  /**
+   * Split routes into ranges holding about as many routes each and hash every range
+   * \param seqnos the sequence number of every route
+   * \param maxRanges the largest number of ranges
+   */
+  void
+  SetRoutes (const std::map<Ipv4Address, uint32_t> &seqnos, uint32_t maxRanges);
+  /**
+   * Find the ranges whose routes differ from other routes
+   * \param seqnos the sequence number of every route to compare with
+   * \param ranges the ranges whose hash differs
+   */
+  void
+  GetDifferingRanges (const std::map<Ipv4Address, uint32_t> &seqnos, std::vector<AddressRange> &ranges) const;
+  /**
+   * Get the number of ranges
+   * \returns the number of ranges
+   */
+  uint32_t
+  GetRangeCount () const
+  {
+    return m_ranges.size ();
+  }
+private:
+  /**
+   * Get the ranges with their last address
+   * \returns every range
+   */
+  std::vector<AddressRange>
+  GetRanges () const;
+
+  std::vector<std::pair<Ipv4Address, uint32_t> > m_ranges; ///< First address and hash of every range
+};
+static inline std::ostream & operator<< (std::ostream& os, const DigestHeader & header)
+{
+  header.Print (os);
+  return os;
+}
+
+/**
+ * \ingroup olsb
+ * \brief OLSB Pull Message Format
+ * \verbatim
+ |      0        |      1        |      2        |       3       |
+  0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |          Range Count          |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                     First Address of Range                    |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                      Last Address of Range                    |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                              ...                              |
+ * \endverbatim
+ *
+ * Sent to the neighbor whose digest differs, which answers with a route update holding its routes
+ * in those ranges. A message shorter than its range count announces is not deserialized,
+ * Deserialize returns 0.
+ */
+class PullHeader : public Header
+{
+public:
+  /// c-tor
+  PullHeader ();
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * Add a range
+   * \param range the first and the last address of the range
+   */
+  void
+  AddRange (const AddressRange &range)
+  {
+    m_ranges.push_back (range);
+  }
+  /**
+   * Get the ranges
+   * \returns the ranges
+   */
+  const std::vector<AddressRange> &
+  GetRanges () const
+  {
+    return m_ranges;
+  }
+  /**
+   * Check whether an address is in one of the ranges
+   * \param address the address
+   * \returns true if a range holds the address
+   */
+  bool
+  Contains (Ipv4Address address) const;
+private:
+  std::vector<AddressRange> m_ranges; ///< Requested ranges
+};
+static inline std::ostream & operator<< (std::ostream& os, const PullHeader & header)
+{
+  header.Print (os);
+  return os;
+}
+
+/**
+ * \ingroup olsb
+ * \brief OLSB Hello Message Format
+ * \verbatim
+ |      0        |      1        |      2        |       3       |
+  0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |        Neighbor Count         |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                       Neighbor Address                        |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                              ...                              |
+ * \endverbatim
+ *
+ * A receiver listed by the beacon knows that the sender hears it, so the link works both ways.
+ * A message shorter than its neighbor count announces is not deserialized, Deserialize returns 0.
+ */
+class HelloHeader : public Header
+{
+public:
+  /// c-tor
+  HelloHeader ();
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * Add a neighbor the sender hears
+   * \param neighbor the neighbor IPv4 address
+   */
+  void
+  AddNeighbor (Ipv4Address neighbor)
+  {
+    m_neighbors.push_back (neighbor);
+  }
+  /**
+   * Get the neighbors the sender hears
+   * \returns the neighbors
+   */
+  const std::vector<Ipv4Address> &
+  GetNeighbors () const
+  {
+    return m_neighbors;
+  }
+private:
+  std::vector<Ipv4Address> m_neighbors; ///< Neighbors heard by the sender
+};
+static inline std::ostream & operator<< (std::ostream& os, const HelloHeader & header)
+{
+  header.Print (os);
+  return os;
+}
+
+/**
+ * \ingroup olsb
+ * \brief OLSB Full Update Message Format
+ * \verbatim
+ |      0        |      1        |      2        |       3       |
+  0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |           Update Id           |   Fragment    |Fragment Count |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * \endverbatim
+ *
+ * A full update lists every route of the sender, so a receiver that got all of its packets
+ * withdraws the routes through the sender the update left out. The message leads each packet of
+ * the update. A truncated message is not deserialized, Deserialize returns 0.
+ */
+class FullUpdateHeader : public Header
+{
+public:
+  /**
+   * Constructor
+   * \param updateId the identifier of the update
+   * \param fragment the index of the packet in the update
+   * \param fragmentCount the number of packets of the update
+   */
+  FullUpdateHeader (uint16_t updateId = 0, uint8_t fragment = 0, uint8_t fragmentCount = 1);
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * Get the identifier of the update
+   * \returns the update identifier
+   */
+  uint16_t
+  GetUpdateId () const
+  {
+    return m_updateId;
+  }
+  /**
+   * Get the index of the packet in the update
+   * \returns the fragment index
+   */
+  uint8_t
+  GetFragment () const
+  {
+    return m_fragment;
+  }
+  /**
+   * Get the number of packets of the update
+   * \returns the fragment count
+   */
+  uint8_t
+  GetFragmentCount () const
+  {
+    return m_fragmentCount;
+  }
+private:
+  uint16_t m_updateId; ///< Identifier of the update
+  uint8_t m_fragment; ///< Index of the packet in the update
+  uint8_t m_fragmentCount; ///< Number of packets of the update
+};
+static inline std::ostream & operator<< (std::ostream& os, const FullUpdateHeader & header)
+{
+  header.Print (os);
+  return os;
+}
+
+/**
+ * \ingroup olsb
+ * \brief OLSB Record Fields Message Format
+ * \verbatim
+ |      0        |
+  0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+
+ |    Fields     |
+ +-+-+-+-+-+-+-+-+
+ * \endverbatim
+ *
+ * Leads fixed format records that carry optional fields, see OlsbHeader::Fields. Records without
+ * optional fields are sent without it, in the 16 byte format that every OLSB node decodes. A
+ * truncated message is not deserialized, Deserialize returns 0.
+ */
+class RecordFieldsHeader : public Header
+{
+public:
+  /**
+   * Constructor
+   * \param fields the optional fields of the records
+   */
+  RecordFieldsHeader (uint8_t fields = 0);
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * Get the optional fields of the records
+   * \returns the fields
+   */
+  uint8_t
+  GetFields () const
+  {
+    return m_fields;
+  }
+  /**
+   * Check that every field is known
+   * \returns true if the header is valid
+   */
+  bool
+  IsValid () const;
+private:
+  uint8_t m_fields; ///< Optional fields of the records
+};
+static inline std::ostream & operator<< (std::ostream& os, const RecordFieldsHeader & header)
+{
+  header.Print (os);
+  return os;
+}
 }
 }
 
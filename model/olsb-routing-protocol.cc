@@ -24,6 +24,9 @@
  */
 
 #include "olsb-routing-protocol.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include "ns3/log.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/trace-source-accessor.h"
@@ -31,6 +34,8 @@
 #include "ns3/boolean.h"
 #include "ns3/double.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/mobility-model.h"
 
 namespace ns3 {
 
@@ -106,6 +111,116 @@ struct DeferredRouteOutputTag : public Tag
   }
 };
 
+/// Tag counting the greedy geographic hops of a packet
+struct GreedyHopTag : public Tag
+{
+  /// Number of hops the packet was forwarded greedily
+  uint32_t hops;
+
+  /**
+   * Constructor
+   *
+   * \param h number of greedy hops
+   */
+  GreedyHopTag (uint32_t h = 0)
+    : Tag (),
+      hops (h)
+  {
+  }
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId
+  GetTypeId ()
+  {
+    static TypeId tid = TypeId ("ns3::olsb::GreedyHopTag")
+      .SetParent<Tag> ()
+      .SetGroupName ("Olsb")
+      .AddConstructor<GreedyHopTag> ()
+    ;
+    return tid;
+  }
+
+  TypeId
+  GetInstanceTypeId () const
+  {
+    return GetTypeId ();
+  }
+
+  uint32_t
+  GetSerializedSize () const
+  {
+    return sizeof(uint32_t);
+  }
+
+  void
+  Serialize (TagBuffer i) const
+  {
+    i.WriteU32 (hops);
+  }
+
+  void
+  Deserialize (TagBuffer i)
+  {
+    hops = i.ReadU32 ();
+  }
+
+  void
+  Print (std::ostream &os) const
+  {
+    os << "GreedyHopTag: hops = " << hops;
+  }
+};
+
+/// Tag marking the control packets this node sends, which are not commodity traffic
+struct ControlPacketTag : public Tag
+{
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId
+  GetTypeId ()
+  {
+    static TypeId tid = TypeId ("ns3::olsb::ControlPacketTag")
+      .SetParent<Tag> ()
+      .SetGroupName ("Olsb")
+      .AddConstructor<ControlPacketTag> ()
+    ;
+    return tid;
+  }
+
+  TypeId
+  GetInstanceTypeId () const
+  {
+    return GetTypeId ();
+  }
+
+  uint32_t
+  GetSerializedSize () const
+  {
+    return 0;
+  }
+
+  void
+  Serialize (TagBuffer i) const
+  {
+  }
+
+  void
+  Deserialize (TagBuffer i)
+  {
+  }
+
+  void
+  Print (std::ostream &os) const
+  {
+    os << "ControlPacketTag";
+  }
+};
+
 TypeId
 RoutingProtocol::GetTypeId (void)
 {
@@ -139,6 +254,89 @@ RoutingProtocol::GetTypeId (void)
                    MakeBooleanAccessor (&RoutingProtocol::SetEnableBufferFlag,
                                         &RoutingProtocol::GetEnableBufferFlag),
                    MakeBooleanChecker ())
+    .AddAttribute ("EnableCustodyBuffering","Enables store-carry-forward buffering of transit packets at intermediate hops "
+                   "if no route to destination is available",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::SetEnableCustodyBufferFlag,
+                                        &RoutingProtocol::GetEnableCustodyBufferFlag),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxCustodyQueueLen", "Maximum number of transit packets that a relay holds in custody.",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxCustodyQueueLen),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxCustodyPacketsPerDst", "Maximum number of transit packets per destination that a relay holds in custody.",
+                   UintegerValue (5),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxCustodyPacketsPerDst),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxCustodyQueueTime","Maximum time transit packets can be held in custody (in seconds)",
+                   TimeValue (Seconds (30)),
+                   MakeTimeAccessor (&RoutingProtocol::m_maxCustodyQueueTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("ForwardingMode","How packets are forwarded. Routed sends every packet to the next hop installed "
+                   "by the route updates; Backpressure holds packets in per-destination queues and, at every "
+                   "transmit opportunity, serves the destination and neighbor with the largest backlog "
+                   "differential, biased towards short paths by ShortestPathFactor.",
+                   EnumValue (ROUTED),
+                   MakeEnumAccessor (&RoutingProtocol::m_forwardingMode),
+                   MakeEnumChecker (ROUTED, "Routed",
+                                    BACKPRESSURE, "Backpressure"))
+    .AddAttribute ("MaxCommodityQueueLen", "Maximum number of packets held in the commodity queues in backpressure mode.",
+                   UintegerValue (500),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxCommodityQueueLen),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxCommodityPacketsPerDst", "Maximum number of packets per destination held in the commodity "
+                   "queues in backpressure mode.",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxCommodityPacketsPerDst),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxCommodityQueueTime","Maximum time packets can be held in the commodity queues (in seconds)",
+                   TimeValue (Seconds (30)),
+                   MakeTimeAccessor (&RoutingProtocol::m_maxCommodityQueueTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("BackpressureLifo","Serve the latest packet of a commodity first in backpressure mode, which "
+                   "shortens the delay of the packets that are delivered",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::EnableBackpressureLifo),
+                   MakeBooleanChecker ())
+    .AddAttribute ("BacklogExchangeInterval","Time between two advertisements of the commodity backlogs "
+                   "in backpressure mode",
+                   TimeValue (MilliSeconds (200)),
+                   MakeTimeAccessor (&RoutingProtocol::m_backlogExchangeInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("BackpressureServiceInterval","Time between two checks for a transmit opportunity while "
+                   "packets wait in the commodity queues",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&RoutingProtocol::m_backpressureServiceInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxEgressBacklog","Packets in the egress queue of an interface below which the backpressure "
+                   "engine hands it another packet",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxEgressBacklog),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("AdmissionControl","Throttle locally originated packets with a drift-plus-penalty admission "
+                   "control that keeps the backlog towards every destination bounded while maximising the sum "
+                   "of the log utilities of the local flows",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::EnableAdmissionControl),
+                   MakeBooleanChecker ())
+    .AddAttribute ("AdmissionInterval","Time between two updates of the admission control",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&RoutingProtocol::m_admissionInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("AdmissionUtilityWeight","Utility weight V of the admission control, in packets. The backlog "
+                   "towards a destination, held here and at the next hop, stays around V packets; larger values "
+                   "admit more traffic at the cost of longer queues. A next hop advertising a drain time is "
+                   "counted in packets of the size of the local backlog, or of AirtimeReferenceSize.",
+                   DoubleValue (100),
+                   MakeDoubleAccessor (&RoutingProtocol::m_admissionUtilityWeight),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MaxSourceRate","Largest rate admitted per local flow, in packets per second",
+                   DoubleValue (100),
+                   MakeDoubleAccessor (&RoutingProtocol::m_maxSourceRate),
+                   MakeDoubleChecker<double> (0))
+    .AddTraceSource ("AdmittedRate","Rate admitted per local flow after every update of the admission control",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_admittedRateTrace),
+                     "ns3::olsb::RoutingProtocol::AdmittedRateTracedCallback")
     .AddAttribute ("EnableWST","Enables Weighted Settling Time for the updates before advertising",
                    BooleanValue (true),
                    MakeBooleanAccessor (&RoutingProtocol::SetWSTFlag,
@@ -159,16 +357,251 @@ RoutingProtocol::GetTypeId (void)
                    MakeBooleanChecker ())
     .AddAttribute ("ShortestPathFactor","Shortest Path Factor in out algorithm",
                    DoubleValue (0.5),
-                   MakeDoubleAccessor (&RoutingProtocol::m_shortestPathFactor),
+                   MakeDoubleAccessor (&RoutingProtocol::SetShortestPathFactor,
+                                       &RoutingProtocol::GetShortestPathFactor),
                    MakeDoubleChecker<double> ())
     .AddAttribute ("BackpressureFactor","Backpressure Factor in out algorithm",
                    DoubleValue (0.5),
-                   MakeDoubleAccessor (&RoutingProtocol::m_backpressureFactor),
+                   MakeDoubleAccessor (&RoutingProtocol::SetBackpressureFactor,
+                                       &RoutingProtocol::GetBackpressureFactor),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("LinkQualityFactor","Link quality (ETX) Factor in out algorithm",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&RoutingProtocol::SetLinkQualityFactor,
+                                       &RoutingProtocol::GetLinkQualityFactor),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("LinkQualityWindow","Number of periodic update intervals over which the delivery ratio "
+                   "of a neighbor is estimated",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&RoutingProtocol::m_linkQualityWindow),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("AirtimeFactor","Airtime (ETT, in milliseconds) Factor in out algorithm",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&RoutingProtocol::SetAirtimeFactor,
+                                       &RoutingProtocol::GetAirtimeFactor),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("AirtimeReferenceSize","Size in bytes of the reference packet whose expected transmission time "
+                   "is the airtime cost of a link",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&RoutingProtocol::m_airtimeReferenceSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("AdaptiveFactors","Adapt the shortest path and backpressure factors at run time to the "
+                   "local backlog trend, drops and route changes",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::EnableAdaptiveFactors),
+                   MakeBooleanChecker ())
+    .AddAttribute ("FactorAdaptationInterval","Time between two adaptations of the factors",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&RoutingProtocol::m_factorAdaptationInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("FactorAdaptationStep","Largest change of the backpressure share of the factors per adaptation",
+                   DoubleValue (0.05),
+                   MakeDoubleAccessor (&RoutingProtocol::m_factorAdaptationStep),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("MinBackpressureShare","Smallest backpressure share of the factors reached by adaptation",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&RoutingProtocol::m_minBackpressureShare),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("MaxBackpressureShare","Largest backpressure share of the factors reached by adaptation",
+                   DoubleValue (0.9),
+                   MakeDoubleAccessor (&RoutingProtocol::m_maxBackpressureShare),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("MaxRouteChangeRate","Route changes per second above which adaptation moves the factors "
+                   "towards shortest path",
+                   DoubleValue (1),
+                   MakeDoubleAccessor (&RoutingProtocol::m_maxRouteChangeRate),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("BacklogTrendDeadband","Change of the local backlog, in time to drain, over one adaptation "
+                   "interval below which adaptation keeps the factors",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&RoutingProtocol::m_backlogTrendDeadband),
+                   MakeTimeChecker (Seconds (0)))
+    .AddTraceSource ("FactorTrajectory","Shortest path and backpressure factors after every adaptation",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_factorTrace),
+                     "ns3::olsb::RoutingProtocol::FactorTracedCallback")
+    .AddAttribute ("SwitchThreshold","Cost reduction, in units of the metric policy cost, that an update from "
+                   "another neighbor must bring to take over the route",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&RoutingProtocol::m_switchThreshold),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("RelativeSwitchThreshold","Cost reduction, as a fraction of the current cost, that an update from "
+                   "another neighbor must bring to take over the route",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&RoutingProtocol::m_relativeSwitchThreshold),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MinDwellTime","Minimum time a destination keeps its next hop before the metric policy "
+                   "may switch it again",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&RoutingProtocol::m_minDwellTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("ForwardTimeSelection","Choose the next hop of every forwarded packet among the neighbors that "
+                   "advertised a route to its destination, using the metrics they advertised last",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::EnableForwardTimeSelection),
+                   MakeBooleanChecker ())
+    .AddAttribute ("TrafficClasses","Give packets of the latency class a next hop of their own, chosen among the "
+                   "neighbors' routes with LatencyShortestPathFactor and LatencyBackpressureFactor; other packets "
+                   "follow the installed route",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::EnableTrafficClasses),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LatencyDscpThreshold","DSCP from which packets belong to the latency class. The default puts "
+                   "CS5, EF, CS6 and CS7 in it.",
+                   UintegerValue (40),
+                   MakeUintegerAccessor (&RoutingProtocol::m_latencyDscpThreshold),
+                   MakeUintegerChecker<uint8_t> (0, 63))
+    .AddAttribute ("LatencyShortestPathFactor","Shortest Path Factor of the latency class",
+                   DoubleValue (1),
+                   MakeDoubleAccessor (&RoutingProtocol::m_latencyShortestPathFactor),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("LatencyBackpressureFactor","Backpressure Factor of the latency class",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&RoutingProtocol::m_latencyBackpressureFactor),
                    MakeDoubleChecker<double> ())
-    .AddAttribute ("RouteAggregationTime","Time to aggregate updates before sending them out (in seconds)",
+    .AddAttribute ("MobilityPrediction","Advertise the position and velocity of the node with its updates, and "
+                   "move routes away from neighbors whose link is predicted to break within MinLinkLifetime",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::EnableMobilityPrediction),
+                   MakeBooleanChecker ())
+    .AddAttribute ("TransmissionRange","Distance in meters beyond which a neighbor is predicted to be out of reach",
+                   DoubleValue (250),
+                   MakeDoubleAccessor (&RoutingProtocol::m_transmissionRange),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MinLinkLifetime","Predicted remaining lifetime below which the link to a neighbor is avoided",
+                   TimeValue (Seconds (2)),
+                   MakeTimeAccessor (&RoutingProtocol::m_minLinkLifetime),
+                   MakeTimeChecker ())
+    .AddAttribute ("GeographicFallback","Advertise the positions of the known nodes with the updates, and forward "
+                   "packets without a route to the neighbor closest to their destination",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::EnableGeographicFallback),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxGreedyHops","Maximum number of hops a packet is forwarded greedily towards the position of "
+                   "its destination",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxGreedyHops),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("LocationLifetime","Time after which the position of a node is forgotten",
+                   TimeValue (Seconds (60)),
+                   MakeTimeAccessor (&RoutingProtocol::m_locationLifetime),
+                   MakeTimeChecker ())
+    .AddAttribute ("UpdateFormat","Encoding of the route update records. Fixed sends the original 16 byte record "
+                   "per route, that nodes without the OLSB extensions decode, and only adds the path ETX and "
+                   "airtime, behind a record fields message, when LinkQualityFactor or AirtimeFactor is set; "
+                   "Compact sends variable length records with delta coded addresses and sequence numbers, "
+                   "which nodes understand whatever their own setting.",
+                   EnumValue (FIXED_FORMAT),
+                   MakeEnumAccessor (&RoutingProtocol::m_updateFormat),
+                   MakeEnumChecker (FIXED_FORMAT, "Fixed",
+                                    COMPACT_FORMAT, "Compact"))
+    .AddAttribute ("DeltaPeriodicUpdates","Leave the routes advertised unchanged out of the periodic updates, "
+                   "except in every FullUpdateInterval-th one and after a neighbor asked for a full update. "
+                   "Updates from a next hop then keep all routes through it alive, and a full update withdraws "
+                   "the routes through its sender it leaves out, so enable it on all nodes.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::EnableDeltaUpdates),
+                   MakeBooleanChecker ())
+    .AddAttribute ("FullUpdateInterval","Number of periodic updates between two full updates with DeltaPeriodicUpdates",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&RoutingProtocol::m_fullUpdateInterval),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxFragmentJitter","Largest delay between two packets of an update split to fit the MTU",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&RoutingProtocol::m_maxFragmentJitter),
+                   MakeTimeChecker ())
+    .AddAttribute ("MetricPolicy","Policy that decides whether an update with the same sequence number replaces "
+                   "the current route. Weighted is the OLSB weighted sum of the metric differences; Custom "
+                   "requires a comparison set with SetMetricPolicyCallback.",
+                   EnumValue (WEIGHTED),
+                   MakeEnumAccessor (&RoutingProtocol::m_metricPolicyType),
+                   MakeEnumChecker (HOP_ONLY, "HopOnly",
+                                    QUEUE_ONLY, "QueueOnly",
+                                    WEIGHTED, "Weighted",
+                                    LEXICOGRAPHIC, "Lexicographic",
+                                    CUSTOM, "Custom"))
+    .AddAttribute ("QueueMetricSource","Queues whose backlog is advertised as the OLSB queue metric. RouteBuffer advertises "
+                   "the number of packets waiting for a route, the other sources advertise the time needed to drain "
+                   "the egress backlog of the interface at its data rate.",
+                   EnumValue (EGRESS),
+                   MakeEnumAccessor (&RoutingProtocol::m_queueMetricSource),
+                   MakeEnumChecker (ROUTE_BUFFER, "RouteBuffer",
+                                    QUEUE_DISC, "QueueDisc",
+                                    MAC_QUEUE, "MacQueue",
+                                    EGRESS, "Egress"))
+    .AddAttribute ("PerDestinationBacklog","Advertise in every record the backlog towards that record's destination "
+                   "instead of the backlog of the whole interface",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&RoutingProtocol::EnablePerDestinationBacklog),
+                   MakeBooleanChecker ())
+    .AddAttribute ("QueueMetricResolution","Time to drain that counts as one unit of the advertised queue metric",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&RoutingProtocol::m_queueMetricResolution),
+                   MakeTimeChecker ())
+    .AddAttribute ("QueueMetricTimeConstant","Time constant of the moving average of the egress backlog",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&RoutingProtocol::m_queueMetricTimeConstant),
+                   MakeTimeChecker ())
+    .AddAttribute ("AdvertiseSmoothedQueue","Advertise the moving average of the egress backlog instead of "
+                   "its instantaneous value",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&RoutingProtocol::AdvertiseSmoothedQueue),
+                   MakeBooleanChecker ())
+    .AddAttribute ("EgressDataRate","Data rate used to compute the time to drain when the rate of an interface "
+                   "cannot be detected",
+                   DataRateValue (DataRate ("11Mbps")),
+                   MakeDataRateAccessor (&RoutingProtocol::m_egressDataRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("RouteAggregationTime","Longest time to aggregate updates before sending them out (in seconds)",
                    TimeValue (Seconds (1)),
                    MakeTimeAccessor (&RoutingProtocol::m_routeAggregationTime),
-                   MakeTimeChecker ());
+                   MakeTimeChecker ())
+    .AddAttribute ("MinTriggeredUpdateDelay","Shortest time to aggregate updates before sending them out. The "
+                   "aggregation window grows up to RouteAggregationTime while updates keep arriving, if "
+                   "EnableRouteAggregation is set. A window that starts at zero could never grow, so it is "
+                   "at least one microsecond",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&RoutingProtocol::m_minTriggeredUpdateDelay),
+                   MakeTimeChecker (MicroSeconds (1)))
+    .AddAttribute ("ControlDataRate","Rate of control bytes a node may send, 0 for no bound. Triggered updates "
+                   "beyond it are deferred, least urgent records first",
+                   DataRateValue (DataRate ("0bps")),
+                   MakeDataRateAccessor (&RoutingProtocol::m_controlDataRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("ControlBurstSize","Control bytes that can be sent at once above ControlDataRate",
+                   UintegerValue (8192),
+                   MakeUintegerAccessor (&RoutingProtocol::m_controlBurstSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("LargeMetricChange","Relative change of the queue size, path ETX or airtime above which a "
+                   "changed route is sent before the other changes when the control budget is tight",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&RoutingProtocol::m_largeMetricChange),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("AntiEntropy","Exchange digests of the routing table with the neighbors and pull the routes "
+                   "that differ, so that lost updates are repaired before the next full update",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::EnableAntiEntropy),
+                   MakeBooleanChecker ())
+    .AddAttribute ("DigestInterval","Time between two digests of the routing table",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&RoutingProtocol::m_digestInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("DigestRanges","Largest number of address ranges a digest is split into",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&RoutingProtocol::m_digestRanges),
+                   MakeUintegerChecker<uint32_t> (1,65535))
+    .AddAttribute ("HelloBeacons","Beacon the neighbors heard, so that a neighbor that stops beaconing or no "
+                   "longer hears this node loses its routes without waiting for them to expire",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::EnableHello),
+                   MakeBooleanChecker ())
+    .AddAttribute ("HelloInterval","Time between two beacons",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&RoutingProtocol::m_helloInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("AllowedHelloLoss","Number of beacons in a row a neighbor may miss before it is lost",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&RoutingProtocol::m_allowedHelloLoss),
+                   MakeUintegerChecker<uint32_t> ());
   return tid;
 }
 
@@ -183,6 +616,16 @@ RoutingProtocol::GetEnableBufferFlag () const
   return EnableBuffering;
 }
 void
+RoutingProtocol::SetEnableCustodyBufferFlag (bool f)
+{
+  EnableCustodyBuffering = f;
+}
+bool
+RoutingProtocol::GetEnableCustodyBufferFlag () const
+{
+  return EnableCustodyBuffering;
+}
+void
 RoutingProtocol::SetWSTFlag (bool f)
 {
   EnableWST = f;
@@ -206,6 +649,7 @@ void
 RoutingProtocol::SetShortestPathFactor (double factor)
 {
   m_shortestPathFactor = factor;
+  m_metricPolicy = 0;
 }
 double
 RoutingProtocol::GetShortestPathFactor () const
@@ -216,12 +660,60 @@ void
 RoutingProtocol::SetBackpressureFactor (double factor)
 {
   m_backpressureFactor = factor;
+  m_metricPolicy = 0;
 }
 double
 RoutingProtocol::GetBackpressureFactor () const
 {
   return m_backpressureFactor;
 }
+void
+RoutingProtocol::SetLinkQualityFactor (double factor)
+{
+  m_linkQualityFactor = factor;
+  m_metricPolicy = 0;
+  m_latencyPolicy = 0;
+}
+double
+RoutingProtocol::GetLinkQualityFactor () const
+{
+  return m_linkQualityFactor;
+}
+void
+RoutingProtocol::SetAirtimeFactor (double factor)
+{
+  m_airtimeFactor = factor;
+  m_metricPolicy = 0;
+  m_latencyPolicy = 0;
+}
+double
+RoutingProtocol::GetAirtimeFactor () const
+{
+  return m_airtimeFactor;
+}
+void
+RoutingProtocol::SetMetricPolicyCallback (MetricPolicy::CompareCallback compare, uint8_t fields)
+{
+  m_metricPolicyType = CUSTOM;
+  m_metricPolicyCallback = compare;
+  m_metricPolicyFields = fields;
+  m_metricPolicy = 0;
+}
+uint64_t
+RoutingProtocol::GetControlBytesSent () const
+{
+  return m_controlBudget.GetSentBytes ();
+}
+uint32_t
+RoutingProtocol::GetDeferredRecords (uint32_t priority) const
+{
+  return m_controlBudget.GetDeferred (priority);
+}
+uint32_t
+RoutingProtocol::GetRouteChanges () const
+{
+  return m_routeChanges;
+}
 
 int64_t
 RoutingProtocol::AssignStreams (int64_t stream)
@@ -235,9 +727,19 @@ RoutingProtocol::RoutingProtocol ()
   : m_routingTable (),
     m_advRoutingTable (),
     m_queue (),
-    m_periodicUpdateTimer (Timer::CANCEL_ON_DESTROY)
+    m_custodyQueue (),
+    m_commodityQueue (),
+    m_periodicUpdateTimer (Timer::CANCEL_ON_DESTROY),
+    m_factorAdaptationTimer (Timer::CANCEL_ON_DESTROY),
+    m_backlogExchangeTimer (Timer::CANCEL_ON_DESTROY),
+    m_backpressureServiceTimer (Timer::CANCEL_ON_DESTROY),
+    m_admissionTimer (Timer::CANCEL_ON_DESTROY),
+    m_digestTimer (Timer::CANCEL_ON_DESTROY),
+    m_helloTimer (Timer::CANCEL_ON_DESTROY)
 {
   m_uniformRandomVariable = CreateObject<UniformRandomVariable> ();
+  m_metricPolicyFields = MetricPolicy::ALL;
+  m_routeChanges = 0;
 }
 
 RoutingProtocol::~RoutingProtocol ()
@@ -254,6 +756,24 @@ RoutingProtocol::DoDispose ()
       iter->first->Close ();
     }
   m_socketAddresses.clear ();
+  for (std::map<Ipv4Address, EventId>::iterator i = m_linkBreakEvents.begin (); i != m_linkBreakEvents.end (); ++i)
+    {
+      i->second.Cancel ();
+    }
+  m_linkBreakEvents.clear ();
+  m_triggeredUpdateEvent.Cancel ();
+  for (std::list<EventId>::iterator e = m_fragmentEvents.begin (); e != m_fragmentEvents.end (); ++e)
+    {
+      e->Cancel ();
+    }
+  m_fragmentEvents.clear ();
+  m_lastSwitch.clear ();
+  m_fullUpdates.clear ();
+  m_deferredDsts.clear ();
+  m_updateCache.Clear ();
+  m_neighborTable.Clear ();
+  m_backlogMonitor.Dispose ();
+  m_airtimeEstimator.Dispose ();
   Ipv4RoutingProtocol::DoDispose ();
 }
 
@@ -275,12 +795,78 @@ RoutingProtocol::Start ()
   m_queue.SetMaxPacketsPerDst (m_maxQueuedPacketsPerDst);
   m_queue.SetMaxQueueLen (m_maxQueueLen);
   m_queue.SetQueueTimeout (m_maxQueueTime);
+  m_custodyQueue.SetMaxPacketsPerDst (m_maxCustodyPacketsPerDst);
+  m_custodyQueue.SetMaxQueueLen (m_maxCustodyQueueLen);
+  m_custodyQueue.SetQueueTimeout (m_maxCustodyQueueTime);
+  m_commodityQueue.SetMaxPacketsPerDst (m_maxCommodityPacketsPerDst);
+  m_commodityQueue.SetMaxQueueLen (m_maxCommodityQueueLen);
+  m_commodityQueue.SetQueueTimeout (m_maxCommodityQueueTime);
+  m_backlogMonitor.SetSource (m_queueMetricSource);
+  m_backlogMonitor.SetDefaultDataRate (m_egressDataRate);
+  m_backlogMonitor.SetTimeConstant (m_queueMetricTimeConstant);
+  m_linkEstimator.SetWindowSize (m_linkQualityWindow);
+  m_linkEstimator.SetUpdateInterval (m_periodicUpdateInterval);
+  m_airtimeEstimator.SetReferenceSize (m_airtimeReferenceSize);
+  m_linkLifetimeEstimator.SetRange (m_transmissionRange);
+  m_locationTable.SetLifetime (m_locationLifetime);
+  m_controlBudget.SetRate (m_controlDataRate.GetBitRate () / 8.0);
+  m_controlBudget.SetBurst (m_controlBurstSize);
+  m_controlBudget.Reset ();
+  m_periodicUpdateCount = 0;
+  m_fullUpdatePending = false;
+  m_triggeredUpdateWindow = m_minTriggeredUpdateDelay;
+  m_coalescedTriggers = 0;
+  m_lastAdvertised.clear ();
+  m_metricPolicy = 0;
+  m_latencyPolicy = 0;
   m_routingTable.Setholddowntime (Time (Holdtimes * m_periodicUpdateInterval));
   m_advRoutingTable.Setholddowntime (Time (Holdtimes * m_periodicUpdateInterval));
   m_scb = MakeCallback (&RoutingProtocol::Send,this);
   m_ecb = MakeCallback (&RoutingProtocol::Drop,this);
   m_periodicUpdateTimer.SetFunction (&RoutingProtocol::SendPeriodicUpdate,this);
   m_periodicUpdateTimer.Schedule (MicroSeconds (m_uniformRandomVariable->GetInteger (0,1000)));
+  if (EnableAntiEntropy)
+    {
+      m_digestTimer.SetFunction (&RoutingProtocol::SendDigest,this);
+      m_digestTimer.Schedule (m_digestInterval + MicroSeconds (25 * m_uniformRandomVariable->GetInteger (0,1000)));
+    }
+  if (EnableHello)
+    {
+      m_neighborTable.SetHelloInterval (m_helloInterval);
+      m_neighborTable.SetAllowedHelloLoss (m_allowedHelloLoss);
+      m_helloTimer.SetFunction (&RoutingProtocol::SendHello,this);
+      m_helloTimer.Schedule (MicroSeconds (m_uniformRandomVariable->GetInteger (0,1000)));
+    }
+  if (m_forwardingMode == BACKPRESSURE)
+    {
+      m_backpressureScheduler.SetBacklogLifetime (Holdtimes * m_backlogExchangeInterval);
+      m_backpressureServiceTimer.SetFunction (&RoutingProtocol::ServeCommodities,this);
+      m_backlogAdvertised = false;
+      m_backlogExchangeTimer.SetFunction (&RoutingProtocol::SendBacklog,this);
+      m_backlogExchangeTimer.Schedule (MicroSeconds (m_uniformRandomVariable->GetInteger (0,1000)));
+    }
+  if (EnableAdmissionControl)
+    {
+      m_admissionController.SetUtilityWeight (m_admissionUtilityWeight);
+      m_admissionController.SetMaxRate (m_maxSourceRate);
+      m_admissionController.SetInterval (m_admissionInterval);
+      m_admissionController.Clear ();
+      m_admissionTimer.SetFunction (&RoutingProtocol::UpdateAdmission,this);
+      m_admissionTimer.Schedule (m_admissionInterval);
+    }
+  if (EnableAdaptiveFactors)
+    {
+      m_factorController.SetStep (m_factorAdaptationStep);
+      m_factorController.SetShareBounds (m_minBackpressureShare,m_maxBackpressureShare);
+      m_factorController.SetMaxRouteChangeRate (m_maxRouteChangeRate);
+      m_factorController.SetDeadband (m_backlogTrendDeadband.GetSeconds ());
+      m_factorController.Reset (m_shortestPathFactor,m_backpressureFactor);
+      m_lastBacklog = 0;
+      m_lastDrops = m_queue.GetDropCount () + m_custodyQueue.GetDropCount () + m_commodityQueue.GetDropCount ();
+      m_routeChanges = 0;
+      m_factorAdaptationTimer.SetFunction (&RoutingProtocol::AdaptFactors,this);
+      m_factorAdaptationTimer.Schedule (m_factorAdaptationInterval);
+    }
 }
 
 Ptr<Ipv4Route>
@@ -308,6 +894,15 @@ RoutingProtocol::RouteOutput (Ptr<Packet> p,
   Ipv4Address dst = header.GetDestination ();
   NS_LOG_DEBUG ("Packet Size: " << p->GetSize ()
                                 << ", Packet id: " << p->GetUid () << ", Destination address in Packet: " << dst);
+  // Unicast control packets, like pulls and their answers, bypass admission control and the commodity queues
+  ControlPacketTag controlTag;
+  bool commodity = !p->PeekPacketTag (controlTag) && IsCommodity (dst);
+  if (EnableAdmissionControl && commodity && !m_admissionController.Admit (dst))
+    {
+      NS_LOG_LOGIC ("Admission control holds back packet " << p->GetUid () << " to " << dst);
+      sockerr = Socket::ERROR_AGAIN;
+      return route;
+    }
   RoutingTableEntry rt;
   m_routingTable.Purge (removedAddresses);
   for (std::map<Ipv4Address, RoutingTableEntry>::iterator rmItr = removedAddresses.begin ();
@@ -316,17 +911,24 @@ RoutingProtocol::RouteOutput (Ptr<Packet> p,
       rmItr->second.SetEntriesChanged (true);
       rmItr->second.SetSeqNo (rmItr->second.GetSeqNo () + 1);
       m_advRoutingTable.AddRoute (rmItr->second);
+      ForgetRoute (rmItr->first);
     }
   if (!removedAddresses.empty ())
     {
-      Simulator::Schedule (MicroSeconds (m_uniformRandomVariable->GetInteger (0,1000)),&RoutingProtocol::SendTriggeredUpdate,this);
+      ScheduleTriggeredUpdate ();
     }
-  if (m_routingTable.LookupRoute (dst,rt))
+  if (m_forwardingMode == BACKPRESSURE && commodity)
     {
-      if (EnableBuffering)
+      // Own packets join the commodity queues through the loopback, like packets waiting for a route
+      DeferredRouteOutputTag tag (oif ? m_ipv4->GetInterfaceForDevice (oif) : -1);
+      if (!p->PeekPacketTag (tag))
         {
-          LookForQueuedPackets ();
+          p->AddPacketTag (tag);
         }
+      return LoopbackRoute (header,oif);
+    }
+  if (m_routingTable.LookupRoute (dst,rt))
+    {
       if (rt.GetHop () == 1)
         {
           route = rt.GetRoute ();
@@ -344,14 +946,22 @@ RoutingProtocol::RouteOutput (Ptr<Packet> p,
         }
       else
         {
+          // Sockets pass their type of service in a tag, the IPv4 header only gets it after routing
+          uint8_t tos = header.GetTos ();
+          SocketIpTosTag tosTag;
+          if (p->PeekPacketTag (tosTag))
+            {
+              tos = tosTag.GetTos ();
+            }
           RoutingTableEntry newrt;
-          if (m_routingTable.LookupRoute (rt.GetNextHop (),newrt))
+          Ipv4Address nextHop = SelectNextHop (rt,tos);
+          if (m_routingTable.LookupRoute (nextHop,newrt))
             {
               route = newrt.GetRoute ();
               NS_ASSERT (route != 0);
               NS_LOG_DEBUG ("A route exists from " << route->GetSource ()
                                                    << " to destination " << dst << " via "
-                                                   << rt.GetNextHop ());
+                                                   << nextHop);
               if (oif != 0 && route->GetOutputDevice () != oif)
                 {
                   NS_LOG_DEBUG ("Output device doesn't match. Dropped.");
@@ -362,6 +972,15 @@ RoutingProtocol::RouteOutput (Ptr<Packet> p,
             }
         }
     }
+  Ipv4Address greedyHop;
+  RoutingTableEntry toNeighbor;
+  if (SelectGreedyNeighbor (dst,greedyHop) && m_routingTable.LookupRoute (greedyHop,toNeighbor)
+      && (oif == 0 || toNeighbor.GetOutputDevice () == oif))
+    {
+      NS_LOG_DEBUG ("No route to " << dst << ", forwarding greedily via " << greedyHop);
+      p->ReplacePacketTag (GreedyHopTag (1));
+      return toNeighbor.GetRoute ();
+    }
 
   if (EnableBuffering)
     {
@@ -388,6 +1007,8 @@ RoutingProtocol::DeferredRouteOutput (Ptr<const Packet> p,
   if (result)
     {
       NS_LOG_DEBUG ("Added packet " << p->GetUid () << " to queue.");
+      // The route may have been installed while the packet was looped back
+      LookForQueuedPackets (header.GetDestination ());
     }
 }
 
@@ -423,6 +1044,16 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p,
       return false;
     }
 
+  if (m_forwardingMode == BACKPRESSURE && idev == m_lo)
+    {
+      DeferredRouteOutputTag tag;
+      if (p->PeekPacketTag (tag))
+        {
+          QueueEntry newEntry (p,header,ucb,ecb);
+          EnqueueCommodity (newEntry);
+          return true;
+        }
+    }
   // Deferred route request
   if (EnableBuffering == true && idev == m_lo)
     {
@@ -505,21 +1136,53 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p,
       return true;
     }
 
+  if (m_forwardingMode == BACKPRESSURE)
+    {
+      QueueEntry newEntry (p,header,ucb,ecb);
+      return EnqueueCommodity (newEntry);
+    }
+
   RoutingTableEntry toDst;
   if (m_routingTable.LookupRoute (dst,toDst))
     {
       RoutingTableEntry ne;
-      if (m_routingTable.LookupRoute (toDst.GetNextHop (),ne))
+      Ipv4Address nextHop = SelectNextHop (toDst,header.GetTos ());
+      if (m_routingTable.LookupRoute (nextHop,ne))
         {
           Ptr<Ipv4Route> route = ne.GetRoute ();
           NS_LOG_LOGIC (m_mainAddress << " is forwarding packet " << p->GetUid ()
                                       << " to " << dst
                                       << " from " << header.GetSource ()
-                                      << " via nexthop neighbor " << toDst.GetNextHop ());
+                                      << " via nexthop neighbor " << nextHop);
           ucb (route,p,header);
           return true;
         }
     }
+  GreedyHopTag greedyTag;
+  p->PeekPacketTag (greedyTag);
+  Ipv4Address greedyHop;
+  RoutingTableEntry toNeighbor;
+  if (greedyTag.hops < m_maxGreedyHops && SelectGreedyNeighbor (dst,greedyHop)
+      && m_routingTable.LookupRoute (greedyHop,toNeighbor))
+    {
+      NS_LOG_LOGIC (m_mainAddress << " has no route to " << dst << ", forwarding packet " << p->GetUid ()
+                                  << " greedily via " << greedyHop);
+      Ptr<Packet> packet = p->Copy ();
+      greedyTag.hops++;
+      packet->ReplacePacketTag (greedyTag);
+      ucb (toNeighbor.GetRoute (),packet,header);
+      return true;
+    }
+  if (EnableCustodyBuffering)
+    {
+      QueueEntry newEntry (p,header,ucb,ecb);
+      if (m_custodyQueue.Enqueue (newEntry))
+        {
+          NS_LOG_LOGIC (m_mainAddress << " holds packet " << p->GetUid ()
+                                      << " to " << dst << " in custody until a route is found");
+          return true;
+        }
+    }
   NS_LOG_LOGIC ("Drop packet " << p->GetUid ()
                                << " as there is no route to forward it.");
   return false;
@@ -588,12 +1251,176 @@ RoutingProtocol::RecvOlsb (Ptr<Socket> socket)
   uint32_t packetSize = packet->GetSize ();
   NS_LOG_FUNCTION (m_mainAddress << " received olsb packet of size: " << packetSize
                                  << " and packet id: " << packet->GetUid ());
+  // Typed messages either come alone or lead the route update records of the sender
+  std::vector<OlsbHeader> records;
+  FullUpdateHeader fullUpdateHeader;
+  bool fullUpdate = false;
+  uint8_t recordFields = 0;
+  uint8_t marker = 0;
+  while (packetSize > 0 && packet->CopyData (&marker,1) == 1 && marker == TypeHeader::MARKER)
+    {
+      TypeHeader typeHeader;
+      packet->RemoveHeader (typeHeader);
+      // A truncated type header is left invalid
+      if (!typeHeader.IsValid ())
+        {
+          NS_LOG_DEBUG ("OLSB message " << packet->GetUid () << " with unknown type received from " << sender << ". Drop");
+          return;
+        }
+      switch (typeHeader.Get ())
+        {
+        case OLSB_BACKLOG:
+          {
+            RecvBacklog (packet,sender);
+            return;
+          }
+        case OLSB_POSITION:
+          {
+            PositionHeader positionHeader;
+            if (packet->RemoveHeader (positionHeader) == 0)
+              {
+                NS_LOG_DEBUG ("Truncated position message " << packet->GetUid () << " from " << sender << ". Drop");
+                return;
+              }
+            RecvPosition (positionHeader,sender);
+            break;
+          }
+        case OLSB_LOCATION:
+          {
+            LocationHeader locationHeader;
+            if (packet->RemoveHeader (locationHeader) == 0)
+              {
+                NS_LOG_DEBUG ("Truncated location message " << packet->GetUid () << " from " << sender << ". Drop");
+                return;
+              }
+            RecvLocation (locationHeader);
+            break;
+          }
+        case OLSB_FULL_UPDATE:
+          {
+            if (packet->RemoveHeader (fullUpdateHeader) == 0)
+              {
+                NS_LOG_DEBUG ("Truncated full update " << packet->GetUid () << " from " << sender << ". Drop");
+                return;
+              }
+            fullUpdate = true;
+            break;
+          }
+        case OLSB_RECORD_FIELDS:
+          {
+            RecordFieldsHeader fieldsHeader;
+            if (packet->RemoveHeader (fieldsHeader) == 0)
+              {
+                NS_LOG_DEBUG ("Truncated record fields " << packet->GetUid () << " from " << sender << ". Drop");
+                return;
+              }
+            if (!fieldsHeader.IsValid ())
+              {
+                NS_LOG_DEBUG ("OLSB update " << packet->GetUid () << " with unknown record fields received from "
+                                             << sender << ". Drop");
+                return;
+              }
+            recordFields = fieldsHeader.GetFields ();
+            break;
+          }
+        case OLSB_FULL_REQUEST:
+          {
+            RecvFullRequest (sender);
+            return;
+          }
+        case OLSB_DIGEST:
+          {
+            DigestHeader digestHeader;
+            if (packet->RemoveHeader (digestHeader) == 0)
+              {
+                NS_LOG_DEBUG ("Truncated digest " << packet->GetUid () << " from " << sender << ". Drop");
+                return;
+              }
+            RecvDigest (socket,digestHeader,sender);
+            return;
+          }
+        case OLSB_PULL:
+          {
+            PullHeader pullHeader;
+            if (packet->RemoveHeader (pullHeader) == 0)
+              {
+                NS_LOG_DEBUG ("Truncated pull " << packet->GetUid () << " from " << sender << ". Drop");
+                return;
+              }
+            RecvPull (socket,pullHeader,sender);
+            return;
+          }
+        case OLSB_HELLO:
+          {
+            HelloHeader helloHeader;
+            if (packet->RemoveHeader (helloHeader) == 0)
+              {
+                NS_LOG_DEBUG ("Truncated hello " << packet->GetUid () << " from " << sender << ". Drop");
+                return;
+              }
+            RecvHello (socket,helloHeader,sender);
+            return;
+          }
+        case OLSB_COMPACT_UPDATE:
+          {
+            CompactUpdateHeader compactHeader;
+            if (packet->RemoveHeader (compactHeader) == 0)
+              {
+                NS_LOG_DEBUG ("Truncated compact update " << packet->GetUid () << " from " << sender << ". Drop");
+                return;
+              }
+            if (!compactHeader.IsValid ())
+              {
+                NS_LOG_DEBUG ("Compact update " << packet->GetUid () << " with unknown version received from "
+                                                << sender << ". Drop");
+                return;
+              }
+            records = compactHeader.GetRecords ();
+            break;
+          }
+        }
+      packetSize = packet->GetSize ();
+    }
+  if (packetSize > 0)
+    {
+      std::vector<uint8_t> payload (packetSize);
+      packet->CopyData (&payload[0],packetSize);
+      if (!OlsbHeader::DeserializeRecords (&payload[0],packetSize,recordFields,records))
+        {
+          NS_LOG_DEBUG ("OLSB update " << packet->GetUid () << " from " << sender << " has " << packetSize
+                                       << " bytes of records, not a whole number of them. Drop");
+          return;
+        }
+    }
+  if (EnableHello && m_neighborTable.IsNeighbor (sender) && !m_neighborTable.IsBidirectional (sender))
+    {
+      NS_LOG_DEBUG ("OLSB update " << packet->GetUid () << " from " << sender
+                                   << " which does not hear this node. Ignore its routes");
+      return;
+    }
+  if (EnableDeltaUpdates && !records.empty ())
+    {
+      // Unchanged routes are left out of delta updates, so any update of a next hop vouches for its routes
+      std::map<Ipv4Address, RoutingTableEntry> dstsWithNextHop;
+      m_routingTable.GetListOfDestinationWithNextHop (sender,dstsWithNextHop);
+      for (std::map<Ipv4Address, RoutingTableEntry>::iterator i = dstsWithNextHop.begin (); i != dstsWithNextHop.end (); ++i)
+        {
+          if (i->second.GetFlag () == VALID && i->second.GetSeqNo () % 2 == 0)
+            {
+              i->second.SetLifeTime (Simulator::Now ());
+              m_routingTable.Update (i->second);
+            }
+        }
+    }
+  if (fullUpdate)
+    {
+      RecvFullUpdate (fullUpdateHeader,records,sender);
+    }
   uint32_t count = 0;
-  for (; packetSize > 0; packetSize = packetSize - 16)
+  for (std::vector<OlsbHeader>::const_iterator record = records.begin (); record != records.end (); ++record)
     {
       count = 0;
-      OlsbHeader olsbHeader;
-      packet->RemoveHeader (olsbHeader);
+      const OlsbHeader &olsbHeader = *record;
       NS_LOG_DEBUG ("Processing new update for " << olsbHeader.GetDst ());
       /*Verifying if the packets sent by me were returned back to me. If yes, discarding them!*/
       for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
@@ -622,18 +1449,62 @@ RoutingProtocol::RecvOlsb (Ptr<Socket> socket)
         }
       NS_LOG_DEBUG ("Received a OLSB packet from "
                     << sender << " to " << receiver << ". Details are: Destination: " << olsbHeader.GetDst () << ", Seq No: "
-                    << olsbHeader.GetDstSeqno () << ", HopCount: " << olsbHeader.GetHopCount () << ", QueueSize: " << olsbHeader.GetQueueSize ());
-      RoutingTableEntry fwdTableEntry, advTableEntry;
-      EventId event;
-      bool permanentTableVerifier = m_routingTable.LookupRoute (olsbHeader.GetDst (),fwdTableEntry);
-      if (permanentTableVerifier == false)
+                    << olsbHeader.GetDstSeqno () << ", HopCount: " << olsbHeader.GetHopCount () << ", QueueSize: " << olsbHeader.GetQueueSize ()
+                    << ", Etx: " << olsbHeader.GetEtx () << ", Airtime: " << olsbHeader.GetAirtime ());
+      // The sender's own record arrives once per periodic update, so its seqno gaps are lost updates
+      if (olsbHeader.GetDst () == sender && olsbHeader.GetDstSeqno () % 2 == 0)
         {
-          if (olsbHeader.GetDstSeqno () % 2 != 1)
-            {
-              NS_LOG_DEBUG ("Received New Route!");
-              RoutingTableEntry newEntry (
-                /*device=*/ dev, /*dst=*/
-                olsbHeader.GetDst (), /*seqno=*/
+          m_linkEstimator.NotifyUpdate (sender,olsbHeader.GetDstSeqno ());
+        }
+      // Only the metrics that the policy reads are accumulated along the path
+      uint8_t fields = GetMetricFields ();
+      uint32_t pathEtx = 0;
+      if (fields & MetricPolicy::ETX)
+        {
+          pathEtx = olsbHeader.GetEtx () + m_linkEstimator.GetEtx (sender);
+        }
+      uint32_t pathAirtime = 0;
+      if (fields & MetricPolicy::AIRTIME)
+        {
+          pathAirtime = olsbHeader.GetAirtime ()
+            + m_airtimeEstimator.GetEtt (dev,sender,m_backlogMonitor.GetDataRate (dev)).GetMicroSeconds ();
+        }
+      // Forward time selection, the backpressure engine, the traffic classes and mobility prediction choose
+      // among the neighbors' routes
+      if (EnableForwardTimeSelection || m_forwardingMode == BACKPRESSURE || EnableTrafficClasses
+          || EnableMobilityPrediction)
+        {
+          if (olsbHeader.GetDstSeqno () % 2 == 0)
+            {
+              RoutingTableEntry candidate (
+                /*device=*/ dev, /*dst=*/ olsbHeader.GetDst (), /*seqno=*/ olsbHeader.GetDstSeqno (),
+                /*iface=*/ m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (receiver), 0),
+                /*hops=*/ olsbHeader.GetHopCount (), /*queuesize=*/ olsbHeader.GetQueueSize (),
+                /*next hop=*/ sender, /*lifetime=*/ Simulator::Now ());
+              candidate.SetEtx (pathEtx);
+              candidate.SetAirtime (pathAirtime);
+              m_routingTable.UpdateCandidate (candidate);
+            }
+          else
+            {
+              m_routingTable.DeleteCandidate (olsbHeader.GetDst (),sender);
+            }
+          if (EnableTrafficClasses)
+            {
+              UpdateClassNextHop (olsbHeader.GetDst ());
+            }
+        }
+      RoutingTableEntry fwdTableEntry, advTableEntry;
+      EventId event;
+      bool permanentTableVerifier = m_routingTable.LookupRoute (olsbHeader.GetDst (),fwdTableEntry);
+      if (permanentTableVerifier == false)
+        {
+          if (olsbHeader.GetDstSeqno () % 2 != 1)
+            {
+              NS_LOG_DEBUG ("Received New Route!");
+              RoutingTableEntry newEntry (
+                /*device=*/ dev, /*dst=*/
+                olsbHeader.GetDst (), /*seqno=*/
                 olsbHeader.GetDstSeqno (),
                 /*iface=*/ m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (receiver), 0),
                 /*hops=*/ olsbHeader.GetHopCount (), /*next hop=*/
@@ -643,9 +1514,31 @@ RoutingProtocol::RecvOlsb (Ptr<Socket> socket)
                 m_settlingTime, /*entries changed*/
                 true);
               newEntry.SetFlag (VALID);
+              newEntry.SetEtx (pathEtx);
+              newEntry.SetAirtime (pathAirtime);
               m_routingTable.AddRoute (newEntry);
               NS_LOG_DEBUG ("New Route added to both tables");
+              if (EnableDeltaUpdates && newEntry.GetHop () == 1)
+                {
+                  // A new neighbor has only heard the changes so far
+                  SendFullRequest (sender);
+                }
               m_advRoutingTable.AddRoute (newEntry);
+              if (newEntry.GetHop () == 1)
+                {
+                  // A new neighbor also unblocks the destinations already routed through it
+                  std::map<Ipv4Address, RoutingTableEntry> dstsWithNextHop;
+                  m_routingTable.GetListOfDestinationWithNextHop (olsbHeader.GetDst (),dstsWithNextHop);
+                  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = dstsWithNextHop.begin ();
+                       i != dstsWithNextHop.end (); ++i)
+                    {
+                      LookForQueuedPackets (i->first);
+                    }
+                }
+              else
+                {
+                  LookForQueuedPackets (olsbHeader.GetDst ());
+                }
             }
           else
             {
@@ -671,45 +1564,99 @@ RoutingProtocol::RecvOlsb (Ptr<Socket> socket)
             }
           if (olsbHeader.GetDstSeqno () % 2 != 1)
             {
-              if (olsbHeader.GetDstSeqno () > advTableEntry.GetSeqNo ())
+              // A newer route through a neighbor about to leave is only taken if no neighbor in reach offers one
+              Ipv4Address nextHop = sender;
+              uint32_t seqNo = olsbHeader.GetDstSeqno ();
+              RouteMetric offered = { olsbHeader.GetHopCount (), olsbHeader.GetQueueSize (), pathEtx, pathAirtime };
+              bool keepCurrent = false;
+              if (olsbHeader.GetDstSeqno () > advTableEntry.GetSeqNo () && sender != advTableEntry.GetNextHop ()
+                  && IsLinkExpiring (sender))
+                {
+                  RoutingTableEntry stable;
+                  // No neighbor has heard this node advertise the newer sequence number yet, so any route
+                  // with it is feasible
+                  if (LookupStableCandidate (olsbHeader.GetDst (),olsbHeader.GetDstSeqno (),
+                                             std::numeric_limits<uint32_t>::max (),sender,stable))
+                    {
+                      NS_LOG_DEBUG ("Taking the newer route to " << olsbHeader.GetDst () << " via " << stable.GetNextHop ()
+                                                                 << " rather than via " << sender
+                                                                 << " whose link is about to break");
+                      nextHop = stable.GetNextHop ();
+                      seqNo = stable.GetSeqNo ();
+                      offered.hops = stable.GetHop ();
+                      offered.queue = stable.GetQueueSize ();
+                      offered.etx = stable.GetEtx ();
+                      offered.airtime = stable.GetAirtime ();
+                      advTableEntry.SetOutputDevice (stable.GetOutputDevice ());
+                      advTableEntry.SetInterface (stable.GetInterface ());
+                    }
+                  else
+                    {
+                      keepCurrent = advTableEntry.GetSeqNo () % 2 == 0 && !IsLinkExpiring (advTableEntry.GetNextHop ());
+                    }
+                }
+              if (keepCurrent)
+                {
+                  NS_LOG_DEBUG ("Keeping the route to " << olsbHeader.GetDst () << " via " << advTableEntry.GetNextHop ()
+                                                        << " rather than the newer one via " << sender
+                                                        << " whose link is about to break");
+                  if (!m_advRoutingTable.AnyRunningEvent (olsbHeader.GetDst ()))
+                    {
+                      m_advRoutingTable.DeleteRoute (olsbHeader.GetDst ());
+                    }
+                }
+              else if (olsbHeader.GetDstSeqno () > advTableEntry.GetSeqNo ())
                 {
                   // Received update with better seq number. Clear any old events that are running
                   if (m_advRoutingTable.ForceDeleteIpv4Event (olsbHeader.GetDst ()))
                     {
                       NS_LOG_DEBUG ("Canceling the timer to update route with better seq number");
                     }
+                  // A refreshed sequence number may come through another neighbor first, which the factor
+                  // adaptation sees as an oscillation too
+                  if (advTableEntry.GetNextHop () != nextHop)
+                    {
+                      m_routeChanges++;
+                    }
                   // if its a changed metric *nomatter* where the update came from, wait  for WST
-                  if (olsbHeader.GetHopCount () != advTableEntry.GetHop ())
+                  if (offered.hops != advTableEntry.GetHop ())
                     {
-                      advTableEntry.SetSeqNo (olsbHeader.GetDstSeqno ());
+                      advTableEntry.SetSeqNo (seqNo);
                       advTableEntry.SetLifeTime (Simulator::Now ());
                       advTableEntry.SetFlag (VALID);
                       advTableEntry.SetEntriesChanged (true);
-                      advTableEntry.SetNextHop (sender);
-                      advTableEntry.SetHop (olsbHeader.GetHopCount ());
-                      advTableEntry.SetQueueSize (olsbHeader.GetQueueSize ());
+                      advTableEntry.SetNextHop (nextHop);
+                      advTableEntry.SetHop (offered.hops);
+                      advTableEntry.SetQueueSize (offered.queue);
+                      advTableEntry.SetEtx (offered.etx);
+                      advTableEntry.SetAirtime (offered.airtime);
                       NS_LOG_DEBUG ("Received update with better sequence number and changed metric.Waiting for WST");
                       Time tempSettlingtime = GetSettlingTime (olsbHeader.GetDst ());
                       advTableEntry.SetSettlingTime (tempSettlingtime);
                       NS_LOG_DEBUG ("Added Settling Time:" << tempSettlingtime.As (Time::S)
                                                            << " as there is no event running for this route");
-                      event = Simulator::Schedule (tempSettlingtime,&RoutingProtocol::SendTriggeredUpdate,this);
+                      event = Simulator::Schedule (tempSettlingtime,&RoutingProtocol::ScheduleTriggeredUpdate,this);
                       m_advRoutingTable.AddIpv4Event (olsbHeader.GetDst (),event);
                       NS_LOG_DEBUG ("EventCreated EventUID: " << event.GetUid ());
                       // if received changed metric, use it but adv it only after wst
-                      m_routingTable.Update (advTableEntry);
+                      if (m_routingTable.Update (advTableEntry))
+                        {
+                          LookForQueuedPackets (olsbHeader.GetDst ());
+                        }
                       m_advRoutingTable.Update (advTableEntry);
                     }
                   else
                     {
                       // Received update with better seq number and same metric.
-                      advTableEntry.SetSeqNo (olsbHeader.GetDstSeqno ());
+                      advTableEntry.SetSeqNo (seqNo);
                       advTableEntry.SetLifeTime (Simulator::Now ());
                       advTableEntry.SetFlag (VALID);
                       advTableEntry.SetEntriesChanged (true);
-                      advTableEntry.SetNextHop (sender);
-                      advTableEntry.SetHop (olsbHeader.GetHopCount ());
-                      advTableEntry.SetQueueSize (olsbHeader.GetQueueSize ());
+                      advTableEntry.SetNextHop (nextHop);
+                      advTableEntry.SetHop (offered.hops);
+                      advTableEntry.SetQueueSize (offered.queue);
+                      advTableEntry.SetEtx (offered.etx);
+                      advTableEntry.SetAirtime (offered.airtime);
                       m_advRoutingTable.Update (advTableEntry);
                       NS_LOG_DEBUG ("Route with better sequence number and same metric received. Advertised without WST");
                     }
@@ -717,12 +1664,36 @@ RoutingProtocol::RecvOlsb (Ptr<Socket> socket)
               else if (olsbHeader.GetDstSeqno () == advTableEntry.GetSeqNo ())
                 {
                   // Here we doing the OLSB algorithm!
+                  // The metric policy decides; by default it is the weighted sum of the differences.
                   // if m_shortestPathFactor=0, then we will use backpressure only.
                   // if m_backpressureFactor=0, then we will use shortestpath only.
-                  double shortestPathVal = advTableEntry.GetHop () - olsbHeader.GetHopCount ();
-                  double backpressureVal = advTableEntry.GetQueueSize () - olsbHeader.GetQueueSize ();
-                  // if (olsbHeader.GetHopCount () < advTableEntry.GetHop ())
-                  if (shortestPathVal*m_shortestPathFactor + backpressureVal*m_backpressureFactor > 0)
+                  // Queue sizes are the backlogs towards this destination advertised by the current next hop
+                  // and by the sender, so their difference is the per-commodity backpressure differential
+                  // (our own backlog towards the destination appears on both sides and cancels out).
+                  RouteMetric current = { advTableEntry.GetHop (), advTableEntry.GetQueueSize (),
+                                          advTableEntry.GetEtx (), advTableEntry.GetAirtime () };
+                  RouteMetric candidate = { olsbHeader.GetHopCount (), olsbHeader.GetQueueSize (), pathEtx, pathAirtime };
+                  bool accepted;
+                  if (advTableEntry.GetNextHop () == sender)
+                    {
+                      accepted = GetMetricPolicy ()->IsBetter (current,candidate);
+                    }
+                  else if (IsLinkExpiring (sender))
+                    {
+                      accepted = false;
+                    }
+                  else
+                    {
+                      // Leave a next hop whose link is about to break for a neighbor that stays in reach, as
+                      // long as its route is no worse: a longer route of the same sequence number may lead
+                      // back through this node
+                      accepted = (IsLinkExpiring (advTableEntry.GetNextHop ())
+                                  && advTableEntry.GetNextHop () != olsbHeader.GetDst ()
+                                  && candidate.hops <= current.hops
+                                  && !GetMetricPolicy ()->IsBetter (candidate,current))
+                        || IsSwitchAllowed (olsbHeader.GetDst (),current,candidate);
+                    }
+                  if (accepted)
                     {
                       /*Received update with same seq number and better hop count.
                        * As the metric is changed, we will have to wait for WST before sending out this update.
@@ -730,6 +1701,11 @@ RoutingProtocol::RecvOlsb (Ptr<Socket> socket)
                       NS_LOG_DEBUG ("Canceling any existing timer to update route with same sequence number "
                                     "and better hop count");
                       m_advRoutingTable.ForceDeleteIpv4Event (olsbHeader.GetDst ());
+                      if (advTableEntry.GetNextHop () != sender)
+                        {
+                          m_routeChanges++;
+                          m_lastSwitch[olsbHeader.GetDst ()] = Simulator::Now ();
+                        }
                       advTableEntry.SetSeqNo (olsbHeader.GetDstSeqno ());
                       advTableEntry.SetLifeTime (Simulator::Now ());
                       advTableEntry.SetFlag (VALID);
@@ -737,15 +1713,20 @@ RoutingProtocol::RecvOlsb (Ptr<Socket> socket)
                       advTableEntry.SetNextHop (sender);
                       advTableEntry.SetHop (olsbHeader.GetHopCount ());
                       advTableEntry.SetQueueSize (olsbHeader.GetQueueSize ());
+                      advTableEntry.SetEtx (pathEtx);
+                      advTableEntry.SetAirtime (pathAirtime);
                       Time tempSettlingtime = GetSettlingTime (olsbHeader.GetDst ());
                       advTableEntry.SetSettlingTime (tempSettlingtime);
                       NS_LOG_DEBUG ("Added Settling Time," << tempSettlingtime.As (Time::S)
                                                            << " as there is no current event running for this route");
-                      event = Simulator::Schedule (tempSettlingtime,&RoutingProtocol::SendTriggeredUpdate,this);
+                      event = Simulator::Schedule (tempSettlingtime,&RoutingProtocol::ScheduleTriggeredUpdate,this);
                       m_advRoutingTable.AddIpv4Event (olsbHeader.GetDst (),event);
                       NS_LOG_DEBUG ("EventCreated EventUID: " << event.GetUid ());
                       // if received changed metric, use it but adv it only after wst
-                      m_routingTable.Update (advTableEntry);
+                      if (m_routingTable.Update (advTableEntry))
+                        {
+                          LookForQueuedPackets (olsbHeader.GetDst ());
+                        }
                       m_advRoutingTable.Update (advTableEntry);
                     }
                   else
@@ -791,6 +1772,7 @@ RoutingProtocol::RecvOlsb (Ptr<Socket> socket)
                   std::map<Ipv4Address, RoutingTableEntry> dstsWithNextHopSrc;
                   m_routingTable.GetListOfDestinationWithNextHop (olsbHeader.GetDst (),dstsWithNextHopSrc);
                   m_routingTable.DeleteRoute (olsbHeader.GetDst ());
+                  ForgetRoute (olsbHeader.GetDst ());
                   advTableEntry.SetSeqNo (olsbHeader.GetDstSeqno ());
                   advTableEntry.SetEntriesChanged (true);
                   m_advRoutingTable.Update (advTableEntry);
@@ -801,6 +1783,7 @@ RoutingProtocol::RecvOlsb (Ptr<Socket> socket)
                       i->second.SetEntriesChanged (true);
                       m_advRoutingTable.AddRoute (i->second);
                       m_routingTable.DeleteRoute (i->second.GetDestination ());
+                      ForgetRoute (i->second.GetDestination ());
                     }
                 }
               else
@@ -816,16 +1799,33 @@ RoutingProtocol::RecvOlsb (Ptr<Socket> socket)
             }
         }
     }
-  std::map<Ipv4Address, RoutingTableEntry> allRoutes;
-  m_advRoutingTable.GetListOfAllRoutes (allRoutes);
-  if (EnableRouteAggregation && allRoutes.size () > 0)
+  ScheduleTriggeredUpdate ();
+}
+
+void
+RoutingProtocol::ScheduleTriggeredUpdate ()
+{
+  if (m_triggeredUpdateEvent.IsRunning ())
+    {
+      // The pending update will carry this change as well
+      m_coalescedTriggers++;
+      return;
+    }
+  // Widen the window while updates arrive faster than it, narrow it back once they calm down
+  Time maxWindow = EnableRouteAggregation ? std::max (m_routeAggregationTime,m_minTriggeredUpdateDelay)
+    : m_minTriggeredUpdateDelay;
+  if (m_coalescedTriggers > 0)
     {
-      Simulator::Schedule (m_routeAggregationTime,&RoutingProtocol::SendTriggeredUpdate,this);
+      m_triggeredUpdateWindow = std::min (m_triggeredUpdateWindow * 2,maxWindow);
     }
   else
     {
-      Simulator::Schedule (MicroSeconds (m_uniformRandomVariable->GetInteger (0,1000)),&RoutingProtocol::SendTriggeredUpdate,this);
+      m_triggeredUpdateWindow = std::max (m_triggeredUpdateWindow / 2,m_minTriggeredUpdateDelay);
     }
+  m_coalescedTriggers = 0;
+  Time delay = MicroSeconds (m_uniformRandomVariable->GetInteger (0,m_triggeredUpdateWindow.GetMicroSeconds ()));
+  NS_LOG_DEBUG ("Triggered update in " << delay.As (Time::S) << ", window " << m_triggeredUpdateWindow.As (Time::S));
+  m_triggeredUpdateEvent = Simulator::Schedule (delay,&RoutingProtocol::SendTriggeredUpdate,this);
 }
 
 
@@ -835,74 +1835,86 @@ RoutingProtocol::SendTriggeredUpdate ()
   NS_LOG_FUNCTION (m_mainAddress << " is sending a triggered update");
   std::map<Ipv4Address, RoutingTableEntry> allRoutes;
   m_advRoutingTable.GetListOfAllRoutes (allRoutes);
+  // The route records are the same on every interface, only the record of this node differs
+  std::vector<OlsbHeader> routeRecords;
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+    {
+      NS_LOG_LOGIC ("Destination: " << i->second.GetDestination ()
+                                    << " SeqNo:" << i->second.GetSeqNo () << " HopCount:"
+                                    << i->second.GetHop () + 1);
+      if ((i->second.GetEntriesChanged () == true) && (!m_advRoutingTable.AnyRunningEvent (i->first)))
+        {
+          OlsbHeader olsbHeader;
+          olsbHeader.SetDst (i->second.GetDestination ());
+          olsbHeader.SetDstSeqno (i->second.GetSeqNo ());
+          olsbHeader.SetHopCount (i->second.GetHop () + 1);
+          SetAdvertisedMetric (olsbHeader,i->second.GetOutputDevice (),i->second.GetEtx (),i->second.GetAirtime ());
+          routeRecords.push_back (olsbHeader);
+        }
+      else
+        {
+          EventId event = m_advRoutingTable.GetEventId (i->first);
+          NS_ASSERT (event.GetUid () != 0);
+          NS_LOG_DEBUG ("EventID " << event.GetUid () << " associated with "
+                                   << i->first << " has not expired, waiting in adv table");
+        }
+    }
+  // Deferred records stay in the advertised table until the budget allows them
+  SelectWithinControlBudget (routeRecords);
+  for (std::vector<OlsbHeader>::const_iterator r = routeRecords.begin (); r != routeRecords.end (); ++r)
+    {
+      RoutingTableEntry temp = allRoutes[r->GetDst ()];
+      temp.SetFlag (VALID);
+      temp.SetEntriesChanged (false);
+      m_advRoutingTable.DeleteIpv4Event (temp.GetDestination ());
+      if (!(temp.GetSeqNo () % 2) && m_routingTable.Update (temp))
+        {
+          LookForQueuedPackets (temp.GetDestination ());
+        }
+      m_advRoutingTable.DeleteRoute (temp.GetDestination ());
+      NS_LOG_DEBUG ("Deleted this route from the advertised table");
+    }
+  // The packets are built once for the interfaces of the same MTU that advertise this node alike
+  std::vector<Ptr<Packet> > packets;
+  OlsbHeader builtHeader;
+  uint32_t builtRoom = 0;
   for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
        != m_socketAddresses.end (); ++j)
     {
       OlsbHeader olsbHeader;
       Ptr<Socket> socket = j->first;
       Ipv4InterfaceAddress iface = j->second;
-      Ptr<Packet> packet = Create<Packet> ();
-      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
-        {
-          NS_LOG_LOGIC ("Destination: " << i->second.GetDestination ()
-                                        << " SeqNo:" << i->second.GetSeqNo () << " HopCount:"
-                                        << i->second.GetHop () + 1);
-          RoutingTableEntry temp = i->second;
-          if ((i->second.GetEntriesChanged () == true) && (!m_advRoutingTable.AnyRunningEvent (temp.GetDestination ())))
-            {
-              olsbHeader.SetDst (i->second.GetDestination ());
-              olsbHeader.SetDstSeqno (i->second.GetSeqNo ());
-              olsbHeader.SetHopCount (i->second.GetHop () + 1);
-              olsbHeader.SetQueueSize (m_queue.GetSize ());
-              temp.SetFlag (VALID);
-              temp.SetEntriesChanged (false);
-              m_advRoutingTable.DeleteIpv4Event (temp.GetDestination ());
-              if (!(temp.GetSeqNo () % 2))
-                {
-                  m_routingTable.Update (temp);
-                }
-              packet->AddHeader (olsbHeader);
-              m_advRoutingTable.DeleteRoute (temp.GetDestination ());
-              NS_LOG_DEBUG ("Deleted this route from the advertised table");
-            }
-          else
-            {
-              EventId event = m_advRoutingTable.GetEventId (temp.GetDestination ());
-              NS_ASSERT (event.GetUid () != 0);
-              NS_LOG_DEBUG ("EventID " << event.GetUid () << " associated with "
-                                       << temp.GetDestination () << " has not expired, waiting in adv table");
-            }
-        }
-      if (packet->GetSize () >= 16)
+      std::vector<OlsbHeader> records (routeRecords);
+      if (!records.empty ())
         {
           RoutingTableEntry temp2;
           m_routingTable.LookupRoute (m_ipv4->GetAddress (1, 0).GetBroadcast (), temp2);
           olsbHeader.SetDst (m_ipv4->GetAddress (1, 0).GetLocal ());
           olsbHeader.SetDstSeqno (temp2.GetSeqNo ());
           olsbHeader.SetHopCount (temp2.GetHop () + 1);
-          olsbHeader.SetQueueSize (m_queue.GetSize () );
+          SetAdvertisedMetric (olsbHeader,m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (iface.GetLocal ())),0,0);
           NS_LOG_DEBUG ("Adding my update as well to the packet");
-          packet->AddHeader (olsbHeader);
-          // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
-          Ipv4Address destination;
-          if (iface.GetMask () == Ipv4Mask::GetOnes ())
-            {
-              destination = Ipv4Address ("255.255.255.255");
-            }
-          else
+          records.push_back (olsbHeader);
+          NS_LOG_FUNCTION ("Sending Triggered Update from " << olsbHeader.GetDst () << " with " << records.size ()
+                                                            << " records");
+          uint32_t room = GetUpdateRoom (iface);
+          if (packets.empty () || room != builtRoom || olsbHeader.GetHopCount () != builtHeader.GetHopCount ()
+              || olsbHeader.GetQueueSize () != builtHeader.GetQueueSize ()
+              || olsbHeader.GetEtx () != builtHeader.GetEtx () || olsbHeader.GetAirtime () != builtHeader.GetAirtime ())
             {
-              destination = iface.GetBroadcast ();
+              packets.clear ();
+              BuildUpdatePackets (records,room,false,packets);
+              builtHeader = olsbHeader;
+              builtRoom = room;
             }
-          socket->SendTo (packet, 0, InetSocketAddress (destination, OLSB_PORT));
-          NS_LOG_FUNCTION ("Sent Triggered Update from "
-                           << olsbHeader.GetDst ()
-                           << " with packet id : " << packet->GetUid () << " and packet Size: " << packet->GetSize ());
+          SendUpdatePackets (socket,packets,GetBroadcastDestination (iface));
         }
       else
         {
           NS_LOG_FUNCTION ("Update not sent as there are no updates to be triggered");
         }
     }
+  RememberAdvertised (routeRecords);
 }
 
 void
@@ -910,6 +1922,7 @@ RoutingProtocol::SendPeriodicUpdate ()
 {
   std::map<Ipv4Address, RoutingTableEntry> removedAddresses, allRoutes;
   m_routingTable.Purge (removedAddresses);
+  m_locationTable.Purge ();
   MergeTriggerPeriodicUpdates ();
   m_routingTable.GetListOfAllRoutes (allRoutes);
   if (allRoutes.empty ())
@@ -917,70 +1930,77 @@ RoutingProtocol::SendPeriodicUpdate ()
       return;
     }
   NS_LOG_FUNCTION (m_mainAddress << " is sending out its periodic update");
-  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
-       != m_socketAddresses.end (); ++j)
+  // Delta updates leave out the routes advertised unchanged, except in every FullUpdateInterval-th update
+  bool fullUpdate = !EnableDeltaUpdates || m_fullUpdatePending || m_periodicUpdateCount % m_fullUpdateInterval == 0;
+  m_periodicUpdateCount++;
+  m_fullUpdatePending = false;
+  // The records are the same on every interface, so they are built and serialized once
+  std::vector<OlsbHeader> records;
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
     {
-      Ptr<Socket> socket = j->first;
-      Ipv4InterfaceAddress iface = j->second;
-      Ptr<Packet> packet = Create<Packet> ();
-      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+      OlsbHeader olsbHeader;
+      if (i->second.GetHop () == 0)
         {
-          OlsbHeader olsbHeader;
-          if (i->second.GetHop () == 0)
-            {
-              RoutingTableEntry ownEntry;
-              olsbHeader.SetDst (m_ipv4->GetAddress (1,0).GetLocal ());
-              olsbHeader.SetDstSeqno (i->second.GetSeqNo () + 2);
-              olsbHeader.SetHopCount (i->second.GetHop () + 1);
-              olsbHeader.SetQueueSize (m_queue.GetSize ());
-              m_routingTable.LookupRoute (m_ipv4->GetAddress (1,0).GetBroadcast (),ownEntry);
-              ownEntry.SetSeqNo (olsbHeader.GetDstSeqno ());
-              m_routingTable.Update (ownEntry);
-              packet->AddHeader (olsbHeader);
-            }
-          else
+          RoutingTableEntry ownEntry;
+          olsbHeader.SetDst (m_ipv4->GetAddress (1,0).GetLocal ());
+          olsbHeader.SetDstSeqno (i->second.GetSeqNo () + 2);
+          olsbHeader.SetHopCount (i->second.GetHop () + 1);
+          SetAdvertisedMetric (olsbHeader,i->second.GetOutputDevice (),0,0);
+          m_routingTable.LookupRoute (m_ipv4->GetAddress (1,0).GetBroadcast (),ownEntry);
+          ownEntry.SetSeqNo (olsbHeader.GetDstSeqno ());
+          m_routingTable.Update (ownEntry);
+          records.push_back (olsbHeader);
+        }
+      else
+        {
+          olsbHeader.SetDst (i->second.GetDestination ());
+          olsbHeader.SetDstSeqno ((i->second.GetSeqNo ()));
+          olsbHeader.SetHopCount (i->second.GetHop () + 1);
+          SetAdvertisedMetric (olsbHeader,i->second.GetOutputDevice (),i->second.GetEtx (),i->second.GetAirtime ());
+          if (!fullUpdate && !IsAdvertisedChange (olsbHeader))
             {
-              olsbHeader.SetDst (i->second.GetDestination ());
-              olsbHeader.SetDstSeqno ((i->second.GetSeqNo ()));
-              olsbHeader.SetHopCount (i->second.GetHop () + 1);
-              olsbHeader.SetQueueSize (m_queue.GetSize ());
-              packet->AddHeader (olsbHeader);
+              continue;
             }
-          NS_LOG_DEBUG ("Forwarding the update for " << i->first);
-          NS_LOG_DEBUG ("Forwarding details are, Destination: " << olsbHeader.GetDst ()
-                                                                << ", SeqNo:" << olsbHeader.GetDstSeqno ()
-                                                                << ", HopCount:" << olsbHeader.GetHopCount ()
-                                                                << ", QueueSize:" << olsbHeader.GetQueueSize ()
-                                                                << ", LifeTime: " << i->second.GetLifeTime ().As (Time::S));
-        }
-      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator rmItr = removedAddresses.begin (); rmItr
-           != removedAddresses.end (); ++rmItr)
-        {
-          OlsbHeader removedHeader;
-          removedHeader.SetDst (rmItr->second.GetDestination ());
-          removedHeader.SetDstSeqno (rmItr->second.GetSeqNo () + 1);
-          removedHeader.SetHopCount (rmItr->second.GetHop () + 1);
-          removedHeader.SetQueueSize (m_queue.GetSize ());
-          packet->AddHeader (removedHeader);
-          NS_LOG_DEBUG ("Update for removed record is: Destination: " << removedHeader.GetDst ()
-                                                                      << " SeqNo:" << removedHeader.GetDstSeqno ()
-                                                                      << " HopCount:" << removedHeader.GetHopCount ()
-                                                                      << " QueueSize:" << removedHeader.GetQueueSize ());
-        }
-      socket->Send (packet);
-      // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
-      Ipv4Address destination;
-      if (iface.GetMask () == Ipv4Mask::GetOnes ())
-        {
-          destination = Ipv4Address ("255.255.255.255");
+          records.push_back (olsbHeader);
         }
-      else
+      NS_LOG_DEBUG ("Forwarding the update for " << i->first);
+      NS_LOG_DEBUG ("Forwarding details are, Destination: " << olsbHeader.GetDst ()
+                                                            << ", SeqNo:" << olsbHeader.GetDstSeqno ()
+                                                            << ", HopCount:" << olsbHeader.GetHopCount ()
+                                                            << ", QueueSize:" << olsbHeader.GetQueueSize ()
+                                                            << ", LifeTime: " << i->second.GetLifeTime ().As (Time::S));
+    }
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator rmItr = removedAddresses.begin (); rmItr
+       != removedAddresses.end (); ++rmItr)
+    {
+      ForgetRoute (rmItr->first);
+      OlsbHeader removedHeader;
+      removedHeader.SetDst (rmItr->second.GetDestination ());
+      removedHeader.SetDstSeqno (rmItr->second.GetSeqNo () + 1);
+      removedHeader.SetHopCount (rmItr->second.GetHop () + 1);
+      SetAdvertisedMetric (removedHeader,rmItr->second.GetOutputDevice (),rmItr->second.GetEtx (),
+                           rmItr->second.GetAirtime ());
+      records.push_back (removedHeader);
+      NS_LOG_DEBUG ("Update for removed record is: Destination: " << removedHeader.GetDst ()
+                                                                  << " SeqNo:" << removedHeader.GetDstSeqno ()
+                                                                  << " HopCount:" << removedHeader.GetHopCount ()
+                                                                  << " QueueSize:" << removedHeader.GetQueueSize ());
+    }
+  // The packets are the same on every interface of the same MTU, so they are built once
+  std::map<uint32_t, std::vector<Ptr<Packet> > > packetsByRoom;
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
+       != m_socketAddresses.end (); ++j)
+    {
+      NS_LOG_FUNCTION ("Sending PeriodicUpdate with " << records.size () << " records");
+      uint32_t room = GetUpdateRoom (j->second);
+      std::vector<Ptr<Packet> > &packets = packetsByRoom[room];
+      if (packets.empty ())
         {
-          destination = iface.GetBroadcast ();
+          BuildUpdatePackets (records,room,EnableDeltaUpdates && fullUpdate,packets);
         }
-      socket->SendTo (packet, 0, InetSocketAddress (destination, OLSB_PORT));
-      NS_LOG_FUNCTION ("PeriodicUpdate Packet UID is : " << packet->GetUid ());
+      SendUpdatePackets (j->first,packets,GetBroadcastDestination (j->second));
     }
+  RememberAdvertised (records);
   m_periodicUpdateTimer.Schedule (m_periodicUpdateInterval + MicroSeconds (25 * m_uniformRandomVariable->GetInteger (0,1000)));
 }
 
@@ -1032,6 +2052,8 @@ RoutingProtocol::NotifyInterfaceUp (uint32_t i)
   m_socketAddresses.insert (std::make_pair (socket,iface));
   // Add local broadcast record to the routing table
   Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (iface.GetLocal ()));
+  m_backlogMonitor.AddDevice (dev);
+  m_airtimeEstimator.AddDevice (dev);
   RoutingTableEntry rt (/*device=*/ dev, 
                         /*dst=*/ iface.GetBroadcast (), 
                         /*seqno=*/ 0, 
@@ -1057,10 +2079,15 @@ RoutingProtocol::NotifyInterfaceDown (uint32_t i)
   NS_ASSERT (socket);
   socket->Close ();
   m_socketAddresses.erase (socket);
+  m_backlogMonitor.RemoveDevice (dev);
+  m_airtimeEstimator.RemoveDevice (dev);
   if (m_socketAddresses.empty ())
     {
       NS_LOG_LOGIC ("No olsb interfaces");
       m_routingTable.Clear ();
+      m_backpressureScheduler.Clear ();
+      m_lastSwitch.clear ();
+      m_fullUpdates.clear ();
       return;
     }
   m_routingTable.DeleteAllRoutesFromInterface (m_ipv4->GetAddress (i,0));
@@ -1094,6 +2121,8 @@ RoutingProtocol::NotifyAddAddress (uint32_t i,
       socket->SetAllowBroadcast (true);
       m_socketAddresses.insert (std::make_pair (socket,iface));
       Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (iface.GetLocal ()));
+      m_backlogMonitor.AddDevice (dev);
+      m_airtimeEstimator.AddDevice (dev);
       RoutingTableEntry rt (/*device=*/ dev, 
                             /*dst=*/ iface.GetBroadcast (),
                             /*seqno=*/ 0, 
@@ -1168,38 +2197,49 @@ RoutingProtocol::Drop (Ptr<const Packet> packet,
 }
 
 void
-RoutingProtocol::LookForQueuedPackets ()
+RoutingProtocol::LookForQueuedPackets (Ipv4Address dst)
 {
-  NS_LOG_FUNCTION (this);
+  NS_LOG_FUNCTION (this << dst);
+  bool queued = EnableBuffering && m_queue.Find (dst);
+  bool inCustody = EnableCustodyBuffering && m_custodyQueue.Find (dst);
+  if (!queued && !inCustody)
+    {
+      return;
+    }
+  RoutingTableEntry rt;
+  if (!m_routingTable.LookupRoute (dst,rt) || rt.GetFlag () != VALID)
+    {
+      return;
+    }
   Ptr<Ipv4Route> route;
-  std::map<Ipv4Address, RoutingTableEntry> allRoutes;
-  m_routingTable.GetListOfAllRoutes (allRoutes);
-  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+  if (rt.GetHop () == 1)
     {
-      RoutingTableEntry rt;
-      rt = i->second;
-      if (m_queue.Find (rt.GetDestination ()))
+      route = rt.GetRoute ();
+      NS_LOG_LOGIC ("A route exists from " << route->GetSource ()
+                                           << " to neighboring destination "
+                                           << route->GetDestination ());
+    }
+  else
+    {
+      RoutingTableEntry newrt;
+      if (!m_routingTable.LookupRoute (rt.GetNextHop (),newrt))
         {
-          if (rt.GetHop () == 1)
-            {
-              route = rt.GetRoute ();
-              NS_LOG_LOGIC ("A route exists from " << route->GetSource ()
-                                                   << " to neighboring destination "
-                                                   << route->GetDestination ());
-              NS_ASSERT (route != 0);
-            }
-          else
-            {
-              RoutingTableEntry newrt;
-              m_routingTable.LookupRoute (rt.GetNextHop (),newrt);
-              route = newrt.GetRoute ();
-              NS_LOG_LOGIC ("A route exists from " << route->GetSource ()
-                                                   << " to destination " << route->GetDestination () << " via "
-                                                   << rt.GetNextHop ());
-              NS_ASSERT (route != 0);
-            }
-          SendPacketFromQueue (rt.GetDestination (),route);
+          NS_LOG_LOGIC ("Next hop " << rt.GetNextHop () << " towards " << dst << " is not known yet");
+          return;
         }
+      route = newrt.GetRoute ();
+      NS_LOG_LOGIC ("A route exists from " << route->GetSource ()
+                                           << " to destination " << dst << " via "
+                                           << rt.GetNextHop ());
+    }
+  NS_ASSERT (route != 0);
+  if (queued)
+    {
+      SendPacketFromQueue (dst,route);
+    }
+  if (inCustody)
+    {
+      SendPacketFromCustodyQueue (dst,route);
     }
 }
 
@@ -1234,50 +2274,1290 @@ RoutingProtocol::SendPacketFromQueue (Ipv4Address dst,
     }
 }
 
-Time
-RoutingProtocol::GetSettlingTime (Ipv4Address address)
+void
+RoutingProtocol::SendPacketFromCustodyQueue (Ipv4Address dst,
+                                             Ptr<Ipv4Route> route)
 {
-  NS_LOG_FUNCTION ("Calculating the settling time for " << address);
-  RoutingTableEntry mainrt;
-  Time weightedTime;
-  m_routingTable.LookupRoute (address,mainrt);
-  if (EnableWST)
+  NS_LOG_DEBUG (m_mainAddress << " is forwarding a packet held in custody to destination " << dst);
+  QueueEntry queueEntry;
+  if (m_custodyQueue.Dequeue (dst,queueEntry))
     {
-      if (mainrt.GetSettlingTime () == Seconds (0))
+      // Transit packets never went through the loopback, so header and TTL are forwarded as received
+      UnicastForwardCallback ucb = queueEntry.GetUnicastForwardCallback ();
+      ucb (route,queueEntry.GetPacket (),queueEntry.GetIpv4Header ());
+      if (m_custodyQueue.GetSize () != 0 && m_custodyQueue.Find (dst))
         {
-          return Seconds (0);
+          Simulator::Schedule (MilliSeconds (m_uniformRandomVariable->GetInteger (0,100)),
+                               &RoutingProtocol::SendPacketFromCustodyQueue,this,dst,route);
         }
-      else
+    }
+}
+
+bool
+RoutingProtocol::IsCommodity (Ipv4Address dst) const
+{
+  if (dst.IsBroadcast () || dst.IsMulticast ())
+    {
+      return false;
+    }
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
+       != m_socketAddresses.end (); ++j)
+    {
+      if (dst == j->second.GetBroadcast () || dst == j->second.GetLocal ())
         {
-          NS_LOG_DEBUG ("Route SettlingTime: " << mainrt.GetSettlingTime ().As (Time::S)
-                                               << " and LifeTime:" << mainrt.GetLifeTime ().As (Time::S));
-          weightedTime = m_weightedFactor * mainrt.GetSettlingTime ()  +
-            (1.0 - m_weightedFactor) * mainrt.GetLifeTime ();
-          NS_LOG_DEBUG ("Calculated weightedTime:" << weightedTime.As (Time::S));
-          return weightedTime;
+          return false;
         }
     }
-  return mainrt.GetSettlingTime ();
+  return true;
+}
+
+bool
+RoutingProtocol::EnqueueCommodity (QueueEntry &entry)
+{
+  if (!m_commodityQueue.Enqueue (entry))
+    {
+      NS_LOG_LOGIC ("Commodity queue of " << entry.GetIpv4Header ().GetDestination () << " is full. Drop packet "
+                                          << entry.GetPacket ()->GetUid ());
+      return false;
+    }
+  ServeCommodities ();
+  return true;
+}
+
+bool
+RoutingProtocol::SelectCommodity (Ptr<NetDevice> dev, Ipv4Address &dst, Ipv4Address &neighbor)
+{
+  std::vector<Ipv4Address> dsts;
+  m_commodityQueue.GetDestinations (dsts);
+  std::map<Ipv4Address, uint32_t> backlogs;
+  std::map<Ipv4Address, std::map<Ipv4Address, uint32_t> > distances;
+  for (std::vector<Ipv4Address>::const_iterator d = dsts.begin (); d != dsts.end (); ++d)
+    {
+      backlogs[*d] = m_commodityQueue.GetCountForPacketsWithDst (*d);
+      std::map<Ipv4Address, RoutingTableEntry> candidates;
+      m_routingTable.GetCandidates (*d,candidates);
+      RoutingTableEntry rt;
+      if (m_routingTable.LookupRoute (*d,rt) && rt.GetFlag () == VALID)
+        {
+          // The installed route counts even if its candidate expired
+          candidates.insert (std::make_pair (rt.GetNextHop (),rt));
+        }
+      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = candidates.begin (); i != candidates.end (); ++i)
+        {
+          RoutingTableEntry ne;
+          if (i->second.GetHop () == 0 || !m_routingTable.LookupRoute (i->first,ne) || ne.GetHop () != 1
+              || ne.GetOutputDevice () != dev)
+            {
+              continue;
+            }
+          // Hop counts include the link to the neighbor
+          distances[*d][i->first] = i->second.GetHop () - 1;
+        }
+    }
+  return m_backpressureScheduler.Select (backlogs,distances,m_shortestPathFactor,m_backpressureFactor,dst,neighbor);
 }
 
 void
-RoutingProtocol::MergeTriggerPeriodicUpdates ()
+RoutingProtocol::ServeCommodities ()
 {
-  NS_LOG_FUNCTION ("Merging advertised table changes with main table before sending out periodic update");
-  std::map<Ipv4Address, RoutingTableEntry> allRoutes;
-  m_advRoutingTable.GetListOfAllRoutes (allRoutes);
-  if (allRoutes.size () > 0)
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
+       != m_socketAddresses.end (); ++j)
     {
-      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+      Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (j->second.GetLocal ()));
+      Ipv4Address dst, neighbor;
+      // The decision is taken as late as possible: only when the interface can take another packet
+      while (m_backlogMonitor.GetEgressPackets (dev) < m_maxEgressBacklog && SelectCommodity (dev,dst,neighbor))
         {
-          RoutingTableEntry advEntry = i->second;
-          if ((advEntry.GetEntriesChanged () == true) && (!m_advRoutingTable.AnyRunningEvent (advEntry.GetDestination ())))
+          QueueEntry queueEntry;
+          if (EnableBackpressureLifo ? !m_commodityQueue.DequeueLast (dst,queueEntry)
+              : !m_commodityQueue.Dequeue (dst,queueEntry))
             {
-              if (!(advEntry.GetSeqNo () % 2))
+              break;
+            }
+          RoutingTableEntry ne;
+          m_routingTable.LookupRoute (neighbor,ne);
+          Ptr<Ipv4Route> route = ne.GetRoute ();
+          Ptr<Packet> p = ConstCast<Packet> (queueEntry.GetPacket ());
+          Ipv4Header header = queueEntry.GetIpv4Header ();
+          DeferredRouteOutputTag tag;
+          if (p->RemovePacketTag (tag))
+            {
+              if (tag.oif != -1 && tag.oif != m_ipv4->GetInterfaceForDevice (dev))
                 {
-                  advEntry.SetFlag (VALID);
-                  advEntry.SetEntriesChanged (false);
-                  m_routingTable.Update (advEntry);
+                  NS_LOG_DEBUG ("Output device doesn't match. Dropped.");
+                  queueEntry.GetErrorCallback () (p,header,Socket::ERROR_NOROUTETOHOST);
+                  continue;
+                }
+              header.SetSource (route->GetSource ());
+              header.SetTtl (header.GetTtl () + 1); // compensate extra TTL decrement by fake loopback routing
+            }
+          NS_LOG_LOGIC (m_mainAddress << " is forwarding packet " << p->GetUid ()
+                                      << " to " << dst << " via backpressure neighbor " << neighbor);
+          queueEntry.GetUnicastForwardCallback () (route,p,header);
+        }
+    }
+  if (m_commodityQueue.GetSize () != 0 && !m_backpressureServiceTimer.IsRunning ())
+    {
+      m_backpressureServiceTimer.Schedule (m_backpressureServiceInterval);
+    }
+}
+
+void
+RoutingProtocol::SendBacklog ()
+{
+  BacklogHeader backlogHeader;
+  std::vector<Ipv4Address> dsts;
+  m_commodityQueue.GetDestinations (dsts);
+  for (std::vector<Ipv4Address>::const_iterator d = dsts.begin (); d != dsts.end (); ++d)
+    {
+      backlogHeader.SetBacklog (*d,m_commodityQueue.GetCountForPacketsWithDst (*d));
+    }
+  // Neighbors take a missing destination as an empty queue, so an idle node advertises only once
+  if (!dsts.empty () || m_backlogAdvertised)
+    {
+      for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
+           != m_socketAddresses.end (); ++j)
+        {
+          Ptr<Socket> socket = j->first;
+          Ipv4InterfaceAddress iface = j->second;
+          Ptr<Packet> packet = Create<Packet> ();
+          packet->AddHeader (backlogHeader);
+          packet->AddHeader (TypeHeader (OLSB_BACKLOG));
+          // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
+          Ipv4Address destination;
+          if (iface.GetMask () == Ipv4Mask::GetOnes ())
+            {
+              destination = Ipv4Address ("255.255.255.255");
+            }
+          else
+            {
+              destination = iface.GetBroadcast ();
+            }
+          socket->SendTo (packet, 0, InetSocketAddress (destination, OLSB_PORT));
+          NS_LOG_FUNCTION ("Sent backlogs of " << dsts.size () << " commodities with packet id : " << packet->GetUid ());
+        }
+    }
+  m_backlogAdvertised = !dsts.empty ();
+  m_backlogExchangeTimer.Schedule (m_backlogExchangeInterval + MicroSeconds (m_uniformRandomVariable->GetInteger (0,1000)));
+}
+
+void
+RoutingProtocol::RecvBacklog (Ptr<Packet> packet, Ipv4Address sender)
+{
+  BacklogHeader backlogHeader;
+  if (packet->RemoveHeader (backlogHeader) == 0)
+    {
+      NS_LOG_DEBUG ("Truncated backlog message " << packet->GetUid () << " from " << sender << ". Drop");
+      return;
+    }
+  NS_LOG_DEBUG (m_mainAddress << " received backlogs from " << sender << ": " << backlogHeader);
+  m_backpressureScheduler.UpdateNeighborBacklog (sender,backlogHeader.GetBacklogs ());
+  if (m_forwardingMode == BACKPRESSURE)
+    {
+      // A neighbor that drained its queues may open a positive differential
+      ServeCommodities ();
+    }
+}
+
+bool
+RoutingProtocol::IsAdvertisedChange (const OlsbHeader &record) const
+{
+  std::map<Ipv4Address, OlsbHeader>::const_iterator i = m_lastAdvertised.find (record.GetDst ());
+  if (i == m_lastAdvertised.end ())
+    {
+      return true;
+    }
+  // A new even sequence number alone is a refresh, not a change
+  const OlsbHeader &last = i->second;
+  return last.GetDstSeqno () % 2 != record.GetDstSeqno () % 2 || last.GetHopCount () != record.GetHopCount ()
+         || last.GetQueueSize () != record.GetQueueSize () || last.GetEtx () != record.GetEtx ()
+         || last.GetAirtime () != record.GetAirtime ();
+}
+
+void
+RoutingProtocol::RememberAdvertised (const std::vector<OlsbHeader> &records)
+{
+  for (std::vector<OlsbHeader>::const_iterator r = records.begin (); r != records.end (); ++r)
+    {
+      m_lastAdvertised[r->GetDst ()] = *r;
+      m_deferredDsts.erase (r->GetDst ());
+    }
+}
+
+void
+RoutingProtocol::RecvFullUpdate (const FullUpdateHeader &header, const std::vector<OlsbHeader> &records,
+                                 Ipv4Address sender)
+{
+  if (header.GetFragment () == 0)
+    {
+      FullUpdateState &state = m_fullUpdates[sender];
+      state.updateId = header.GetUpdateId ();
+      state.nextFragment = 0;
+      state.listed.clear ();
+    }
+  std::map<Ipv4Address, FullUpdateState>::iterator s = m_fullUpdates.find (sender);
+  if (s == m_fullUpdates.end () || s->second.updateId != header.GetUpdateId ()
+      || s->second.nextFragment != header.GetFragment ())
+    {
+      // A lost packet of the update may have listed any route
+      if (s != m_fullUpdates.end ())
+        {
+          m_fullUpdates.erase (s);
+        }
+      return;
+    }
+  for (std::vector<OlsbHeader>::const_iterator r = records.begin (); r != records.end (); ++r)
+    {
+      s->second.listed.insert (r->GetDst ());
+    }
+  s->second.nextFragment++;
+  if (s->second.nextFragment < header.GetFragmentCount ())
+    {
+      return;
+    }
+  std::set<Ipv4Address> listed;
+  listed.swap (s->second.listed);
+  m_fullUpdates.erase (s);
+  std::map<Ipv4Address, RoutingTableEntry> allRoutes, dsts;
+  m_routingTable.GetListOfAllRoutes (allRoutes);
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+    {
+      if (listed.find (i->first) == listed.end ())
+        {
+          m_routingTable.DeleteCandidate (i->first,sender);
+        }
+    }
+  // A withdrawal the sender broadcast once may have been lost, so routes it no longer lists are withdrawn here
+  bool withdrawn = false;
+  m_routingTable.GetListOfDestinationWithNextHop (sender,dsts);
+  for (std::map<Ipv4Address, RoutingTableEntry>::iterator d = dsts.begin (); d != dsts.end (); ++d)
+    {
+      RoutingTableEntry &rt = d->second;
+      if (rt.GetHop () <= 1 || listed.find (d->first) != listed.end ())
+        {
+          continue;
+        }
+      NS_LOG_DEBUG ("Full update of " << sender << " leaves out " << d->first << ". Withdraw the route");
+      m_routingTable.DeleteRoute (d->first);
+      ForgetRoute (d->first);
+      if (rt.GetSeqNo () % 2 == 0)
+        {
+          rt.SetSeqNo (rt.GetSeqNo () + 1);
+        }
+      rt.SetEntriesChanged (true);
+      m_advRoutingTable.ForceDeleteIpv4Event (d->first);
+      m_advRoutingTable.DeleteRoute (d->first);
+      m_advRoutingTable.AddRoute (rt);
+      withdrawn = true;
+    }
+  if (withdrawn)
+    {
+      ScheduleTriggeredUpdate ();
+    }
+}
+
+void
+RoutingProtocol::SendFullRequest (Ipv4Address neighbor)
+{
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
+       != m_socketAddresses.end (); ++j)
+    {
+      Ptr<Packet> packet = Create<Packet> ();
+      packet->AddHeader (TypeHeader (OLSB_FULL_REQUEST));
+      packet->AddPacketTag (ControlPacketTag ());
+      j->first->SendTo (packet, 0, InetSocketAddress (neighbor, OLSB_PORT));
+      NS_LOG_FUNCTION ("Asked " << neighbor << " for a full update with packet id : " << packet->GetUid ());
+    }
+}
+
+void
+RoutingProtocol::RecvFullRequest (Ipv4Address sender)
+{
+  NS_LOG_DEBUG (m_mainAddress << " was asked for a full update by " << sender);
+  if (!EnableDeltaUpdates || m_fullUpdatePending)
+    {
+      return;
+    }
+  // Requests from several new neighbors are served by the same update
+  m_fullUpdatePending = true;
+  m_periodicUpdateTimer.Cancel ();
+  m_periodicUpdateTimer.Schedule (MicroSeconds (25 * m_uniformRandomVariable->GetInteger (0,1000)));
+}
+
+void
+RoutingProtocol::GetDigestRoutes (std::map<Ipv4Address, uint32_t> &seqnos)
+{
+  std::map<Ipv4Address, RoutingTableEntry> allRoutes;
+  m_routingTable.GetListOfAllRoutes (allRoutes);
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+    {
+      if (i->second.GetHop () > 0)
+        {
+          seqnos[i->first] = i->second.GetSeqNo ();
+        }
+    }
+  // This node counts with the sequence number it advertises, so a neighbor that missed it differs
+  RoutingTableEntry ownEntry;
+  if (m_routingTable.LookupRoute (m_ipv4->GetAddress (1,0).GetBroadcast (),ownEntry))
+    {
+      seqnos[m_ipv4->GetAddress (1,0).GetLocal ()] = ownEntry.GetSeqNo ();
+    }
+}
+
+void
+RoutingProtocol::SendDigest ()
+{
+  std::map<Ipv4Address, uint32_t> seqnos;
+  GetDigestRoutes (seqnos);
+  DigestHeader digestHeader;
+  digestHeader.SetRoutes (seqnos,m_digestRanges);
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
+       != m_socketAddresses.end (); ++j)
+    {
+      Ptr<Packet> packet = Create<Packet> ();
+      packet->AddHeader (digestHeader);
+      packet->AddHeader (TypeHeader (OLSB_DIGEST));
+      SendUpdatePacket (j->first,packet,GetBroadcastDestination (j->second));
+    }
+  m_digestTimer.Schedule (m_digestInterval + MicroSeconds (25 * m_uniformRandomVariable->GetInteger (0,1000)));
+}
+
+void
+RoutingProtocol::RecvDigest (Ptr<Socket> socket, const DigestHeader &header, Ipv4Address sender)
+{
+  std::map<Ipv4Address, uint32_t> seqnos;
+  GetDigestRoutes (seqnos);
+  std::vector<AddressRange> ranges;
+  header.GetDifferingRanges (seqnos,ranges);
+  if (ranges.empty ())
+    {
+      return;
+    }
+  NS_LOG_DEBUG (m_mainAddress << " differs from " << sender << " in " << ranges.size () << " of "
+                              << header.GetRangeCount () << " ranges");
+  PullHeader pullHeader;
+  for (std::vector<AddressRange>::const_iterator r = ranges.begin (); r != ranges.end (); ++r)
+    {
+      pullHeader.AddRange (*r);
+    }
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (pullHeader);
+  packet->AddHeader (TypeHeader (OLSB_PULL));
+  SendUpdatePacket (socket,packet,sender);
+}
+
+void
+RoutingProtocol::RecvPull (Ptr<Socket> socket, const PullHeader &header, Ipv4Address sender)
+{
+  Ipv4InterfaceAddress iface = m_socketAddresses[socket];
+  std::map<Ipv4Address, RoutingTableEntry> allRoutes;
+  m_routingTable.GetListOfAllRoutes (allRoutes);
+  std::vector<OlsbHeader> records;
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+    {
+      if (i->second.GetHop () == 0 || !header.Contains (i->first))
+        {
+          continue;
+        }
+      OlsbHeader olsbHeader;
+      olsbHeader.SetDst (i->second.GetDestination ());
+      olsbHeader.SetDstSeqno (i->second.GetSeqNo ());
+      olsbHeader.SetHopCount (i->second.GetHop () + 1);
+      SetAdvertisedMetric (olsbHeader,i->second.GetOutputDevice (),i->second.GetEtx (),i->second.GetAirtime ());
+      records.push_back (olsbHeader);
+    }
+  RoutingTableEntry ownEntry;
+  if (header.Contains (m_ipv4->GetAddress (1,0).GetLocal ())
+      && m_routingTable.LookupRoute (m_ipv4->GetAddress (1,0).GetBroadcast (),ownEntry))
+    {
+      OlsbHeader olsbHeader;
+      olsbHeader.SetDst (m_ipv4->GetAddress (1,0).GetLocal ());
+      olsbHeader.SetDstSeqno (ownEntry.GetSeqNo ());
+      olsbHeader.SetHopCount (ownEntry.GetHop () + 1);
+      SetAdvertisedMetric (olsbHeader,m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (iface.GetLocal ())),0,0);
+      records.push_back (olsbHeader);
+    }
+  NS_LOG_DEBUG (m_mainAddress << " answers the pull of " << sender << " with " << records.size () << " records");
+  if (!records.empty ())
+    {
+      std::vector<Ptr<Packet> > packets;
+      BuildUpdatePackets (records,GetUpdateRoom (iface),false,packets);
+      SendUpdatePackets (socket,packets,sender);
+    }
+}
+
+void
+RoutingProtocol::SendHello ()
+{
+  std::vector<Ipv4Address> lost;
+  m_neighborTable.Purge (lost);
+  for (std::vector<Ipv4Address>::const_iterator n = lost.begin (); n != lost.end (); ++n)
+    {
+      NS_LOG_DEBUG (m_mainAddress << " lost neighbor " << *n << " after " << m_allowedHelloLoss << " missed beacons");
+      InvalidateNeighbor (*n);
+    }
+  HelloHeader helloHeader;
+  std::vector<Ipv4Address> neighbors;
+  m_neighborTable.GetNeighbors (neighbors);
+  for (std::vector<Ipv4Address>::const_iterator n = neighbors.begin (); n != neighbors.end (); ++n)
+    {
+      helloHeader.AddNeighbor (*n);
+    }
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
+       != m_socketAddresses.end (); ++j)
+    {
+      Ptr<Packet> packet = Create<Packet> ();
+      packet->AddHeader (helloHeader);
+      packet->AddHeader (TypeHeader (OLSB_HELLO));
+      SendUpdatePacket (j->first,packet,GetBroadcastDestination (j->second));
+    }
+  m_helloTimer.Schedule (m_helloInterval + MicroSeconds (25 * m_uniformRandomVariable->GetInteger (0,1000)));
+}
+
+void
+RoutingProtocol::RecvHello (Ptr<Socket> socket, const HelloHeader &header, Ipv4Address sender)
+{
+  if (!EnableHello)
+    {
+      return;
+    }
+  bool bidirectional = false;
+  for (std::vector<Ipv4Address>::const_iterator n = header.GetNeighbors ().begin (); n != header.GetNeighbors ().end (); ++n)
+    {
+      if (m_ipv4->GetInterfaceForAddress (*n) >= 0)
+        {
+          bidirectional = true;
+          break;
+        }
+    }
+  bool wasBidirectional = m_neighborTable.IsBidirectional (sender);
+  m_neighborTable.Update (sender,bidirectional);
+  if (wasBidirectional && !bidirectional)
+    {
+      NS_LOG_DEBUG (m_mainAddress << " is no longer heard by " << sender);
+      InvalidateNeighbor (sender);
+    }
+  else if (!wasBidirectional && bidirectional)
+    {
+      // Its updates were ignored until now, answer as if it had pulled every route
+      NS_LOG_DEBUG (m_mainAddress << " and " << sender << " hear each other");
+      PullHeader everything;
+      everything.AddRange (AddressRange (Ipv4Address ((uint32_t) 0),Ipv4Address (0xffffffff)));
+      RecvPull (socket,everything,sender);
+    }
+}
+
+void
+RoutingProtocol::InvalidateNeighbor (Ipv4Address neighbor)
+{
+  std::map<Ipv4Address, RoutingTableEntry> allRoutes, dsts;
+  m_routingTable.GetListOfAllRoutes (allRoutes);
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+    {
+      m_routingTable.DeleteCandidate (i->first,neighbor);
+    }
+  m_routingTable.GetListOfDestinationWithNextHop (neighbor,dsts);
+  for (std::map<Ipv4Address, RoutingTableEntry>::iterator d = dsts.begin (); d != dsts.end (); ++d)
+    {
+      RoutingTableEntry &rt = d->second;
+      if (rt.GetHop () == 0)
+        {
+          continue;
+        }
+      // Withdraw the route with an infinite metric, as when it expires
+      m_routingTable.DeleteRoute (d->first);
+      ForgetRoute (d->first);
+      if (rt.GetSeqNo () % 2 == 0)
+        {
+          rt.SetSeqNo (rt.GetSeqNo () + 1);
+        }
+      rt.SetEntriesChanged (true);
+      m_advRoutingTable.ForceDeleteIpv4Event (d->first);
+      m_advRoutingTable.DeleteRoute (d->first);
+      m_advRoutingTable.AddRoute (rt);
+    }
+  // The rest of a full update of the lost neighbor will not come
+  m_fullUpdates.erase (neighbor);
+  m_linkLifetimeEstimator.DeleteNeighbor (neighbor);
+  std::map<Ipv4Address, EventId>::iterator i = m_linkBreakEvents.find (neighbor);
+  if (i != m_linkBreakEvents.end ())
+    {
+      i->second.Cancel ();
+      m_linkBreakEvents.erase (i);
+    }
+  if (!dsts.empty ())
+    {
+      ScheduleTriggeredUpdate ();
+    }
+}
+
+Ptr<Packet>
+RoutingProtocol::BuildUpdate (const std::vector<OlsbHeader> &records)
+{
+  return m_updateCache.Build (records,m_updateFormat);
+}
+
+bool
+RoutingProtocol::GetMobility (Vector &position, Vector &velocity) const
+{
+  Ptr<MobilityModel> mobility = m_ipv4->GetObject<MobilityModel> ();
+  if (mobility == 0)
+    {
+      return false;
+    }
+  position = mobility->GetPosition ();
+  velocity = mobility->GetVelocity ();
+  return true;
+}
+
+Ptr<Packet>
+RoutingProtocol::BuildPosition (uint32_t maxSize) const
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  Vector position, velocity;
+  bool hasPosition = (EnableMobilityPrediction || EnableGeographicFallback) && GetMobility (position,velocity);
+  if (EnableGeographicFallback)
+    {
+      std::map<Ipv4Address, LocationTable::Location> locations;
+      m_locationTable.GetLocations (locations);
+      std::vector<std::pair<Time, Ipv4Address> > byAge;
+      for (std::map<Ipv4Address, LocationTable::Location>::const_iterator i = locations.begin (); i != locations.end (); ++i)
+        {
+          byAge.push_back (std::make_pair (Simulator::Now () - i->second.timestamp,i->first));
+        }
+      // Keep the freshest positions when they do not all fit
+      std::sort (byAge.begin (), byAge.end ());
+      uint32_t overhead = 2 * TypeHeader ().GetSerializedSize () + PositionHeader ().GetSerializedSize ()
+        + LocationHeader ().GetSerializedSize ();
+      uint32_t maxRecords = maxSize > overhead ? (maxSize - overhead) / 20 : 0;
+      if (byAge.size () > maxRecords)
+        {
+          byAge.resize (maxRecords);
+        }
+      if (!byAge.empty ())
+        {
+          LocationHeader locationHeader;
+          for (std::vector<std::pair<Time, Ipv4Address> >::const_iterator i = byAge.begin (); i != byAge.end (); ++i)
+            {
+              locationHeader.SetLocation (i->second,locations[i->second].position,i->first);
+            }
+          packet->AddHeader (locationHeader);
+          packet->AddHeader (TypeHeader (OLSB_LOCATION));
+        }
+    }
+  if (hasPosition)
+    {
+      packet->AddHeader (PositionHeader (position,velocity));
+      packet->AddHeader (TypeHeader (OLSB_POSITION));
+    }
+  return packet;
+}
+
+uint32_t
+RoutingProtocol::GetUpdateSize (const std::vector<OlsbHeader> &records) const
+{
+  if (m_updateFormat == COMPACT_FORMAT)
+    {
+      CompactUpdateSizer compactSize;
+      for (std::vector<OlsbHeader>::const_iterator r = records.begin (); r != records.end (); ++r)
+        {
+          compactSize.AddRecord (*r);
+        }
+      return TypeHeader ().GetSerializedSize () + compactSize.GetSize ();
+    }
+  uint8_t fields = OlsbHeader::GetNeededFields (records);
+  uint32_t fieldsSize = fields != 0 ? TypeHeader ().GetSerializedSize () + RecordFieldsHeader ().GetSerializedSize () : 0;
+  return fieldsSize + records.size () * OlsbHeader::GetRecordSize (fields);
+}
+
+uint32_t
+RoutingProtocol::GetUpdatePriority (const OlsbHeader &record) const
+{
+  if (m_ipv4->GetInterfaceForAddress (record.GetDst ()) >= 0)
+    {
+      return 0;
+    }
+  if (record.GetDstSeqno () % 2 == 1)
+    {
+      return 1;
+    }
+  return IsLargeMetricChange (record) ? 2 : 3;
+}
+
+void
+RoutingProtocol::SelectWithinControlBudget (std::vector<OlsbHeader> &records)
+{
+  if (!m_controlBudget.IsLimited () || records.empty () || m_socketAddresses.empty ())
+    {
+      return;
+    }
+  // Every interface sends the records, the record of this node and the IPv4 and UDP headers
+  uint32_t interfaces = m_socketAddresses.size ();
+  uint32_t recordSize = (GetUpdateSize (records) + records.size () - 1) / records.size ();
+  double available = m_controlBudget.GetAvailable () - (28.0 + recordSize) * interfaces;
+  std::vector<std::vector<OlsbHeader> > byPriority (4);
+  for (std::vector<OlsbHeader>::const_iterator r = records.begin (); r != records.end (); ++r)
+    {
+      byPriority[GetUpdatePriority (*r)].push_back (*r);
+    }
+  records.clear ();
+  uint32_t deferred = 0;
+  for (uint32_t k = 0; k < byPriority.size (); k++)
+    {
+      for (std::vector<OlsbHeader>::const_iterator r = byPriority[k].begin (); r != byPriority[k].end (); ++r)
+        {
+          // Broken routes go out regardless, a stale route costs more than the bytes
+          if (k > 1 && available < recordSize * interfaces)
+            {
+              // A record waiting for budget is counted once, not on every retry
+              if (m_deferredDsts.insert (r->GetDst ()).second)
+                {
+                  m_controlBudget.Defer (k,1);
+                }
+              deferred++;
+              continue;
+            }
+          records.push_back (*r);
+          available -= recordSize * interfaces;
+        }
+    }
+  if (deferred == 0)
+    {
+      return;
+    }
+  NS_LOG_DEBUG (m_mainAddress << " deferred " << deferred << " records for lack of control budget");
+  if (!m_triggeredUpdateEvent.IsRunning ())
+    {
+      Time delay = m_controlBudget.GetDelay ((28 + 2 * recordSize) * interfaces);
+      m_triggeredUpdateEvent = Simulator::Schedule (std::max (delay,m_minTriggeredUpdateDelay),
+                                                    &RoutingProtocol::SendTriggeredUpdate,this);
+    }
+}
+
+bool
+RoutingProtocol::IsLargeMetricChange (const OlsbHeader &record) const
+{
+  std::map<Ipv4Address, OlsbHeader>::const_iterator i = m_lastAdvertised.find (record.GetDst ());
+  if (i == m_lastAdvertised.end ())
+    {
+      return true;
+    }
+  const OlsbHeader &last = i->second;
+  if (last.GetDstSeqno () % 2 != record.GetDstSeqno () % 2 || last.GetHopCount () != record.GetHopCount ())
+    {
+      return true;
+    }
+  double queueChange = std::fabs ((double) record.GetQueueSize () - last.GetQueueSize ());
+  double etxChange = std::fabs ((double) record.GetEtx () - last.GetEtx ());
+  double airtimeChange = std::fabs ((double) record.GetAirtime () - last.GetAirtime ());
+  return queueChange > m_largeMetricChange * std::max (record.GetQueueSize (),last.GetQueueSize ())
+         || etxChange > m_largeMetricChange * std::max (record.GetEtx (),last.GetEtx ())
+         || airtimeChange > m_largeMetricChange * std::max (record.GetAirtime (),last.GetAirtime ());
+}
+
+Ipv4Address
+RoutingProtocol::GetBroadcastDestination (Ipv4InterfaceAddress iface) const
+{
+  // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
+  if (iface.GetMask () == Ipv4Mask::GetOnes ())
+    {
+      return Ipv4Address ("255.255.255.255");
+    }
+  return iface.GetBroadcast ();
+}
+
+uint32_t
+RoutingProtocol::GetUpdateRoom (Ipv4InterfaceAddress iface) const
+{
+  // Every packet stays within the MTU after the IPv4 and UDP headers, so no update gets fragmented
+  uint16_t mtu = m_ipv4->GetMtu (m_ipv4->GetInterfaceForAddress (iface.GetLocal ()));
+  return mtu > 28 ? mtu - 28 : 0;
+}
+
+void
+RoutingProtocol::BuildUpdatePackets (const std::vector<OlsbHeader> &records, uint32_t room, bool fullUpdate,
+                                     std::vector<Ptr<Packet> > &packets)
+{
+  // Own, withdrawn and changed records go first, so losing the tail of a split update costs the least
+  std::vector<std::vector<OlsbHeader> > byPriority (4);
+  for (std::vector<OlsbHeader>::const_iterator r = records.begin (); r != records.end (); ++r)
+    {
+      byPriority[GetUpdatePriority (*r)].push_back (*r);
+    }
+  std::vector<OlsbHeader> ordered;
+  for (uint32_t k = 0; k < byPriority.size (); k++)
+    {
+      ordered.insert (ordered.end (), byPriority[k].begin (), byPriority[k].end ());
+    }
+  if (fullUpdate)
+    {
+      uint32_t markerSize = TypeHeader ().GetSerializedSize () + FullUpdateHeader ().GetSerializedSize ();
+      room = room > markerSize ? room - markerSize : 0;
+    }
+  // Every packet is sized for the optional fields of the whole update, its own records need no more
+  uint8_t fields = OlsbHeader::GetNeededFields (ordered);
+  uint32_t recordSize = OlsbHeader::GetRecordSize (fields);
+  if (m_updateFormat == FIXED_FORMAT && fields != 0)
+    {
+      uint32_t fieldsSize = TypeHeader ().GetSerializedSize () + RecordFieldsHeader ().GetSerializedSize ();
+      room = room > fieldsSize ? room - fieldsSize : 0;
+    }
+  // The positions lead the first packet only, the others carry records alone
+  Ptr<Packet> leading = BuildPosition (room / 2);
+  uint32_t firstRoom = room > leading->GetSize () ? room - leading->GetSize () : 0;
+  std::vector<std::vector<OlsbHeader> > chunks (1);
+  // The size of a compact packet is kept record by record, encoding it again for each record is quadratic
+  CompactUpdateSizer compactSize;
+  for (std::vector<OlsbHeader>::const_iterator r = ordered.begin (); r != ordered.end (); ++r)
+    {
+      uint32_t size = recordSize * (chunks.back ().size () + 1);
+      if (m_updateFormat == COMPACT_FORMAT)
+        {
+          size = TypeHeader ().GetSerializedSize () + compactSize.GetSizeWith (*r);
+        }
+      if (!chunks.back ().empty () && size > (chunks.size () == 1 ? firstRoom : room))
+        {
+          chunks.push_back (std::vector<OlsbHeader> ());
+          compactSize = CompactUpdateSizer ();
+        }
+      chunks.back ().push_back (*r);
+      if (m_updateFormat == COMPACT_FORMAT)
+        {
+          compactSize.AddRecord (*r);
+        }
+    }
+  for (std::vector<std::vector<OlsbHeader> >::const_iterator c = chunks.begin (); c != chunks.end (); ++c)
+    {
+      Ptr<Packet> packet = c == chunks.begin () ? leading : Create<Packet> ();
+      packet->AddAtEnd (BuildUpdate (*c));
+      // Receivers can only tell the routes left out of an update they got all packets of
+      if (fullUpdate && chunks.size () <= 255)
+        {
+          packet->AddHeader (FullUpdateHeader (m_periodicUpdateCount,c - chunks.begin (),chunks.size ()));
+          packet->AddHeader (TypeHeader (OLSB_FULL_UPDATE));
+        }
+      packets.push_back (packet);
+    }
+}
+
+void
+RoutingProtocol::SendUpdatePackets (Ptr<Socket> socket, const std::vector<Ptr<Packet> > &packets,
+                                    Ipv4Address destination)
+{
+  for (std::list<EventId>::iterator e = m_fragmentEvents.begin (); e != m_fragmentEvents.end (); )
+    {
+      if (e->IsExpired ())
+        {
+          e = m_fragmentEvents.erase (e);
+        }
+      else
+        {
+          ++e;
+        }
+    }
+  // Spread the packets of a split update so that they do not collide with the neighbors' own
+  Time delay = Seconds (0);
+  for (std::vector<Ptr<Packet> >::const_iterator p = packets.begin (); p != packets.end (); ++p)
+    {
+      // The packets are shared by all interfaces, every socket gets a copy to add its headers to
+      if (p == packets.begin ())
+        {
+          SendUpdatePacket (socket,(*p)->Copy (),destination);
+          continue;
+        }
+      delay = delay + MicroSeconds (m_uniformRandomVariable->GetInteger (0,m_maxFragmentJitter.GetMicroSeconds ()));
+      m_fragmentEvents.push_back (Simulator::Schedule (delay,&RoutingProtocol::SendUpdatePacket,this,socket,
+                                                       (*p)->Copy (),destination));
+    }
+}
+
+void
+RoutingProtocol::SendUpdatePacket (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination)
+{
+  m_controlBudget.Charge (packet->GetSize () + 28);
+  packet->AddPacketTag (ControlPacketTag ());
+  socket->SendTo (packet, 0, InetSocketAddress (destination, OLSB_PORT));
+  NS_LOG_FUNCTION ("Sent update to " << destination << " with packet id : " << packet->GetUid ()
+                                     << " and packet Size: " << packet->GetSize ());
+}
+
+void
+RoutingProtocol::RecvPosition (const PositionHeader &header, Ipv4Address sender)
+{
+  NS_LOG_DEBUG (m_mainAddress << " received the position of " << sender << ": " << header);
+  m_linkLifetimeEstimator.UpdateNeighbor (sender,header.GetPosition (),header.GetVelocity ());
+  m_locationTable.Update (sender,header.GetPosition (),Seconds (0));
+  std::map<Ipv4Address, EventId>::iterator i = m_linkBreakEvents.find (sender);
+  if (i != m_linkBreakEvents.end ())
+    {
+      i->second.Cancel ();
+      m_linkBreakEvents.erase (i);
+    }
+  Vector position, velocity;
+  if (!EnableMobilityPrediction || !GetMobility (position,velocity))
+    {
+      return;
+    }
+  Time lifetime = m_linkLifetimeEstimator.GetLinkLifetime (sender,position,velocity);
+  if (lifetime == Time::Max ())
+    {
+      return;
+    }
+  Time delay = lifetime > m_minLinkLifetime ? lifetime - m_minLinkLifetime : Seconds (0);
+  NS_LOG_LOGIC ("Link to " << sender << " predicted to break in " << lifetime.As (Time::S));
+  m_linkBreakEvents[sender] = Simulator::Schedule (delay,&RoutingProtocol::AvoidExpiringLink,this,sender);
+}
+
+void
+RoutingProtocol::RecvLocation (const LocationHeader &header)
+{
+  for (std::map<Ipv4Address, LocationHeader::Record>::const_iterator i = header.GetLocations ().begin ();
+       i != header.GetLocations ().end (); ++i)
+    {
+      // Nobody knows better than this node where it is
+      if (m_ipv4->GetInterfaceForAddress (i->first) < 0)
+        {
+          m_locationTable.Update (i->first,i->second.position,i->second.age);
+        }
+    }
+}
+
+bool
+RoutingProtocol::SelectGreedyNeighbor (Ipv4Address dst, Ipv4Address &nextHop)
+{
+  Vector dstPosition, position, velocity;
+  if (!EnableGeographicFallback || !m_locationTable.Lookup (dst,dstPosition) || !GetMobility (position,velocity))
+    {
+      return false;
+    }
+  std::map<Ipv4Address, RoutingTableEntry> allRoutes;
+  m_routingTable.GetListOfAllRoutes (allRoutes);
+  std::vector<Ipv4Address> neighbors;
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+    {
+      if (i->second.GetHop () == 1 && !IsLinkExpiring (i->first))
+        {
+          neighbors.push_back (i->first);
+        }
+    }
+  return m_locationTable.GetClosestNeighbor (position,dstPosition,neighbors,nextHop);
+}
+
+bool
+RoutingProtocol::IsLinkExpiring (Ipv4Address neighbor) const
+{
+  Vector position, velocity;
+  if (!EnableMobilityPrediction || !GetMobility (position,velocity))
+    {
+      return false;
+    }
+  return m_linkLifetimeEstimator.GetLinkLifetime (neighbor,position,velocity) < m_minLinkLifetime;
+}
+
+bool
+RoutingProtocol::LookupStableCandidate (Ipv4Address dst, uint32_t seqNo, uint32_t maxHops, Ipv4Address avoid,
+                                        RoutingTableEntry &chosen)
+{
+  std::map<Ipv4Address, RoutingTableEntry> candidates;
+  m_routingTable.GetCandidates (dst,candidates);
+  RouteMetric best = { 0, 0, 0, 0 };
+  bool found = false;
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = candidates.begin (); i != candidates.end (); ++i)
+    {
+      // Older sequence numbers may lead back through this node
+      RoutingTableEntry other;
+      if (i->first == avoid || i->second.GetSeqNo () < seqNo
+          || (i->second.GetSeqNo () == seqNo && i->second.GetHop () > maxHops)
+          || !m_routingTable.LookupRoute (i->first,other) || other.GetHop () != 1 || IsLinkExpiring (i->first))
+        {
+          continue;
+        }
+      RouteMetric candidate = { i->second.GetHop (), i->second.GetQueueSize (), i->second.GetEtx (), i->second.GetAirtime () };
+      if (!found || GetMetricPolicy ()->IsBetter (best,candidate))
+        {
+          best = candidate;
+          chosen = i->second;
+          found = true;
+        }
+    }
+  return found;
+}
+
+void
+RoutingProtocol::AvoidExpiringLink (Ipv4Address neighbor)
+{
+  m_linkBreakEvents.erase (neighbor);
+  // This node may have turned since the prediction was made
+  if (!IsLinkExpiring (neighbor))
+    {
+      return;
+    }
+  std::map<Ipv4Address, RoutingTableEntry> dsts;
+  m_routingTable.GetListOfDestinationWithNextHop (neighbor,dsts);
+  for (std::map<Ipv4Address, RoutingTableEntry>::iterator d = dsts.begin (); d != dsts.end (); ++d)
+    {
+      RoutingTableEntry &rt = d->second;
+      if (rt.GetHop () <= 1)
+        {
+          continue;
+        }
+      RoutingTableEntry chosen;
+      if (!LookupStableCandidate (d->first,rt.GetSeqNo (),rt.GetHop (),neighbor,chosen))
+        {
+          NS_LOG_DEBUG ("No neighbor in reach to take over the route to " << d->first << " from " << neighbor);
+          continue;
+        }
+      NS_LOG_DEBUG ("Moving the route to " << d->first << " from " << neighbor << " to " << chosen.GetNextHop ()
+                                           << " before the link breaks");
+      rt.SetNextHop (chosen.GetNextHop ());
+      rt.SetOutputDevice (chosen.GetOutputDevice ());
+      rt.SetInterface (chosen.GetInterface ());
+      rt.SetHop (chosen.GetHop ());
+      rt.SetQueueSize (chosen.GetQueueSize ());
+      rt.SetEtx (chosen.GetEtx ());
+      rt.SetAirtime (chosen.GetAirtime ());
+      m_routingTable.Update (rt);
+      // A pending triggered update must not bring the old next hop back
+      RoutingTableEntry advTableEntry;
+      if (m_advRoutingTable.LookupRoute (d->first,advTableEntry) && advTableEntry.GetNextHop () == neighbor)
+        {
+          advTableEntry.SetNextHop (chosen.GetNextHop ());
+          advTableEntry.SetOutputDevice (chosen.GetOutputDevice ());
+          advTableEntry.SetInterface (chosen.GetInterface ());
+          advTableEntry.SetHop (chosen.GetHop ());
+          advTableEntry.SetQueueSize (chosen.GetQueueSize ());
+          advTableEntry.SetEtx (chosen.GetEtx ());
+          advTableEntry.SetAirtime (chosen.GetAirtime ());
+          m_advRoutingTable.Update (advTableEntry);
+        }
+      m_routeChanges++;
+      m_lastSwitch[d->first] = Simulator::Now ();
+    }
+}
+
+void
+RoutingProtocol::AdaptFactors ()
+{
+  double backlog = 0;
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
+       != m_socketAddresses.end (); ++j)
+    {
+      Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (j->second.GetLocal ()));
+      backlog += m_backlogMonitor.GetSmoothedDrainTime (dev).GetSeconds ();
+    }
+  uint32_t drops = m_queue.GetDropCount () + m_custodyQueue.GetDropCount () + m_commodityQueue.GetDropCount ();
+  if (m_factorController.Update (m_factorAdaptationInterval,backlog - m_lastBacklog,drops - m_lastDrops,m_routeChanges))
+    {
+      SetShortestPathFactor (m_factorController.GetShortestPathFactor ());
+      SetBackpressureFactor (m_factorController.GetBackpressureFactor ());
+      NS_LOG_DEBUG ("Adapted factors: ShortestPathFactor " << m_shortestPathFactor
+                                                          << ", BackpressureFactor " << m_backpressureFactor);
+    }
+  m_factorTrace (m_shortestPathFactor,m_backpressureFactor);
+  m_lastBacklog = backlog;
+  m_lastDrops = drops;
+  m_routeChanges = 0;
+  m_factorAdaptationTimer.Schedule (m_factorAdaptationInterval);
+}
+
+double
+RoutingProtocol::GetCongestionPrice (Ipv4Address dst)
+{
+  uint32_t backlogPackets = m_backlogMonitor.GetBacklogPackets (dst);
+  double price = m_queue.GetCountForPacketsWithDst (dst) + m_commodityQueue.GetCountForPacketsWithDst (dst)
+    + backlogPackets;
+  RoutingTableEntry rt;
+  if (!m_routingTable.LookupRoute (dst,rt) || rt.GetHop () <= 1)
+    {
+      return price;
+    }
+  if (m_queueMetricSource == ROUTE_BUFFER)
+    {
+      return price + rt.GetQueueSize ();
+    }
+  // The next hop advertises the time to drain its backlog. It holds about as many packets as this node sends
+  // to it in that time, of the size of the packets that this node holds towards dst
+  double packetSize = backlogPackets > 0 ? (double) m_backlogMonitor.GetBacklogBytes (dst) / backlogPackets
+    : m_airtimeReferenceSize;
+  double drainSeconds = rt.GetQueueSize () * m_queueMetricResolution.GetSeconds ();
+  DataRate rate = rt.GetOutputDevice () != 0 ? m_backlogMonitor.GetDataRate (rt.GetOutputDevice ())
+    : m_backlogMonitor.GetDefaultDataRate ();
+  return price + drainSeconds * rate.GetBitRate () / 8 / packetSize;
+}
+
+void
+RoutingProtocol::UpdateAdmission ()
+{
+  std::vector<Ipv4Address> dsts;
+  m_admissionController.GetFlows (dsts);
+  std::map<Ipv4Address, double> prices, rates;
+  for (std::vector<Ipv4Address>::const_iterator d = dsts.begin (); d != dsts.end (); ++d)
+    {
+      prices[*d] = GetCongestionPrice (*d);
+    }
+  m_admissionController.Update (prices,rates);
+  for (std::map<Ipv4Address, double>::const_iterator i = rates.begin (); i != rates.end (); ++i)
+    {
+      m_admittedRateTrace (i->first,i->second);
+    }
+  m_admissionTimer.Schedule (m_admissionInterval);
+}
+
+bool
+RoutingProtocol::IsSwitchAllowed (Ipv4Address dst, const RouteMetric &current, const RouteMetric &candidate)
+{
+  if (!GetMetricPolicy ()->IsClearlyBetter (current,candidate,m_switchThreshold,m_relativeSwitchThreshold))
+    {
+      return false;
+    }
+  std::map<Ipv4Address, Time>::const_iterator i = m_lastSwitch.find (dst);
+  if (i != m_lastSwitch.end () && Simulator::Now () - i->second < m_minDwellTime)
+    {
+      NS_LOG_DEBUG ("Keeping the next hop of " << dst << ", switched " << (Simulator::Now () - i->second).As (Time::S)
+                                               << " ago");
+      return false;
+    }
+  return true;
+}
+
+void
+RoutingProtocol::ForgetRoute (Ipv4Address dst)
+{
+  m_lastSwitch.erase (dst);
+  m_deferredDsts.erase (dst);
+  m_updateCache.Invalidate (dst);
+}
+
+Ipv4Address
+RoutingProtocol::SelectNextHop (const RoutingTableEntry &rt, uint8_t tos)
+{
+  Ipv4Address nextHop = rt.GetNextHop ();
+  if (EnableTrafficClasses && GetTrafficClass (tos) == LATENCY_CLASS
+      && m_routingTable.LookupClassNextHop (rt.GetDestination (),LATENCY_CLASS,nextHop))
+    {
+      RoutingTableEntry neighbor;
+      if (m_routingTable.LookupRoute (nextHop,neighbor) && neighbor.GetHop () == 1)
+        {
+          return nextHop;
+        }
+      nextHop = rt.GetNextHop ();
+    }
+  if (!EnableForwardTimeSelection || rt.GetHop () <= 1)
+    {
+      return nextHop;
+    }
+  std::map<Ipv4Address, RoutingTableEntry> candidates;
+  m_routingTable.GetCandidates (rt.GetDestination (),candidates);
+  // Start from the metric that the installed next hop advertised last
+  std::map<Ipv4Address, RoutingTableEntry>::const_iterator installed = candidates.find (nextHop);
+  const RoutingTableEntry &current = installed != candidates.end () ? installed->second : rt;
+  RouteMetric best = { current.GetHop (), current.GetQueueSize (), current.GetEtx (), current.GetAirtime () };
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = candidates.begin (); i != candidates.end (); ++i)
+    {
+      // Older sequence numbers may lead back through this node
+      if (i->first == rt.GetNextHop () || i->second.GetSeqNo () < rt.GetSeqNo ())
+        {
+          continue;
+        }
+      RoutingTableEntry neighbor;
+      if (!m_routingTable.LookupRoute (i->first,neighbor) || neighbor.GetHop () != 1)
+        {
+          continue;
+        }
+      if (i->second.GetSeqNo () == rt.GetSeqNo ())
+        {
+          // A lateral neighbor on the same sequence number is only loop free if its own cost, without the link
+          // to it, is below the cost of this node
+          Ptr<NetDevice> dev = i->second.GetOutputDevice ();
+          uint32_t linkEtx = m_linkEstimator.GetEtx (i->first);
+          uint32_t linkAirtime = m_airtimeEstimator.GetEtt (dev,i->first,m_backlogMonitor.GetDataRate (dev)).GetMicroSeconds ();
+          RouteMetric own = { rt.GetHop (), rt.GetQueueSize (), rt.GetEtx (), rt.GetAirtime () };
+          RouteMetric advertised = { i->second.GetHop () - 1, i->second.GetQueueSize (),
+                                     i->second.GetEtx () > linkEtx ? i->second.GetEtx () - linkEtx : 0,
+                                     i->second.GetAirtime () > linkAirtime ? i->second.GetAirtime () - linkAirtime : 0 };
+          if (!GetMetricPolicy ()->IsBetter (own,advertised))
+            {
+              continue;
+            }
+        }
+      RouteMetric candidate = { i->second.GetHop (), i->second.GetQueueSize (), i->second.GetEtx (), i->second.GetAirtime () };
+      if (GetMetricPolicy ()->IsClearlyBetter (best,candidate,m_switchThreshold,m_relativeSwitchThreshold))
+        {
+          best = candidate;
+          nextHop = i->first;
+        }
+    }
+  if (nextHop != rt.GetNextHop ())
+    {
+      NS_LOG_LOGIC ("Forwarding to " << rt.GetDestination () << " via " << nextHop << " instead of " << rt.GetNextHop ());
+    }
+  return nextHop;
+}
+
+Ptr<MetricPolicy>
+RoutingProtocol::GetMetricPolicy ()
+{
+  if (m_metricPolicy == 0)
+    {
+      MetricWeights weights = { m_shortestPathFactor, m_backpressureFactor, m_linkQualityFactor, m_airtimeFactor };
+      m_metricPolicy = CreateMetricPolicy (m_metricPolicyType,weights,m_metricPolicyCallback,m_metricPolicyFields);
+    }
+  return m_metricPolicy;
+}
+
+Ptr<MetricPolicy>
+RoutingProtocol::GetLatencyPolicy ()
+{
+  if (m_latencyPolicy == 0)
+    {
+      MetricWeights weights = { m_latencyShortestPathFactor, m_latencyBackpressureFactor, m_linkQualityFactor,
+                                m_airtimeFactor };
+      m_latencyPolicy = CreateMetricPolicy (WEIGHTED,weights);
+    }
+  return m_latencyPolicy;
+}
+
+uint8_t
+RoutingProtocol::GetMetricFields ()
+{
+  uint8_t fields = GetMetricPolicy ()->GetFields ();
+  if (EnableTrafficClasses)
+    {
+      fields |= GetLatencyPolicy ()->GetFields ();
+    }
+  return fields;
+}
+
+TrafficClass
+RoutingProtocol::GetTrafficClass (uint8_t tos) const
+{
+  return (tos >> 2) >= m_latencyDscpThreshold ? LATENCY_CLASS : BULK_CLASS;
+}
+
+void
+RoutingProtocol::UpdateClassNextHop (Ipv4Address dst)
+{
+  std::map<Ipv4Address, RoutingTableEntry> candidates;
+  m_routingTable.GetCandidates (dst,candidates);
+  RoutingTableEntry rt;
+  uint32_t seqNo = m_routingTable.LookupRoute (dst,rt) ? rt.GetSeqNo () : 0;
+  Ptr<MetricPolicy> policy = GetLatencyPolicy ();
+  RouteMetric best = { 0, 0, 0, 0 };
+  Ipv4Address nextHop;
+  bool found = false;
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = candidates.begin (); i != candidates.end (); ++i)
+    {
+      // Older sequence numbers may lead back through this node
+      RoutingTableEntry neighbor;
+      if (i->second.GetSeqNo () < seqNo || !m_routingTable.LookupRoute (i->first,neighbor) || neighbor.GetHop () != 1)
+        {
+          continue;
+        }
+      RouteMetric candidate = { i->second.GetHop (), i->second.GetQueueSize (), i->second.GetEtx (), i->second.GetAirtime () };
+      if (!found || policy->IsBetter (best,candidate))
+        {
+          best = candidate;
+          nextHop = i->first;
+          found = true;
+        }
+    }
+  if (found)
+    {
+      m_routingTable.SetClassNextHop (dst,LATENCY_CLASS,nextHop);
+    }
+  else
+    {
+      m_routingTable.DeleteClassNextHop (dst,LATENCY_CLASS);
+    }
+}
+
+void
+RoutingProtocol::SetAdvertisedMetric (OlsbHeader &olsbHeader, Ptr<NetDevice> dev, uint32_t etx, uint32_t airtime)
+{
+  uint8_t fields = GetMetricFields ();
+  olsbHeader.SetQueueSize ((fields & MetricPolicy::QUEUE) ? GetQueueMetric (dev,olsbHeader.GetDst ()) : 0);
+  olsbHeader.SetEtx ((fields & MetricPolicy::ETX) ? etx : 0);
+  olsbHeader.SetAirtime ((fields & MetricPolicy::AIRTIME) ? airtime : 0);
+}
+
+uint32_t
+RoutingProtocol::GetQueueMetric (Ptr<NetDevice> dev, Ipv4Address dst)
+{
+  if (m_queueMetricSource == ROUTE_BUFFER)
+    {
+      return EnablePerDestinationBacklog ? m_queue.GetCountForPacketsWithDst (dst) : m_queue.GetSize ();
+    }
+  if (dev == 0)
+    {
+      return 0;
+    }
+  Time drainTime;
+  if (AdvertiseSmoothedQueue)
+    {
+      drainTime = EnablePerDestinationBacklog ? m_backlogMonitor.GetSmoothedDrainTime (dev,dst)
+        : m_backlogMonitor.GetSmoothedDrainTime (dev);
+    }
+  else
+    {
+      drainTime = EnablePerDestinationBacklog ? m_backlogMonitor.GetDrainTime (dev,dst)
+        : m_backlogMonitor.GetDrainTime (dev);
+    }
+  if (drainTime.IsZero ())
+    {
+      return 0;
+    }
+  // Round up so that any backlog at all is distinguishable from an idle interface
+  return static_cast<uint32_t> ((drainTime.GetNanoSeconds () + m_queueMetricResolution.GetNanoSeconds () - 1)
+                                / m_queueMetricResolution.GetNanoSeconds ());
+}
+
+Time
+RoutingProtocol::GetSettlingTime (Ipv4Address address)
+{
+  NS_LOG_FUNCTION ("Calculating the settling time for " << address);
+  RoutingTableEntry mainrt;
+  Time weightedTime;
+  m_routingTable.LookupRoute (address,mainrt);
+  if (EnableWST)
+    {
+      if (mainrt.GetSettlingTime () == Seconds (0))
+        {
+          return Seconds (0);
+        }
+      else
+        {
+          NS_LOG_DEBUG ("Route SettlingTime: " << mainrt.GetSettlingTime ().As (Time::S)
+                                               << " and LifeTime:" << mainrt.GetLifeTime ().As (Time::S));
+          weightedTime = m_weightedFactor * mainrt.GetSettlingTime ()  +
+            (1.0 - m_weightedFactor) * mainrt.GetLifeTime ();
+          NS_LOG_DEBUG ("Calculated weightedTime:" << weightedTime.As (Time::S));
+          return weightedTime;
+        }
+    }
+  return mainrt.GetSettlingTime ();
+}
+
+void
+RoutingProtocol::MergeTriggerPeriodicUpdates ()
+{
+  NS_LOG_FUNCTION ("Merging advertised table changes with main table before sending out periodic update");
+  std::map<Ipv4Address, RoutingTableEntry> allRoutes;
+  m_advRoutingTable.GetListOfAllRoutes (allRoutes);
+  if (allRoutes.size () > 0)
+    {
+      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+        {
+          RoutingTableEntry advEntry = i->second;
+          if ((advEntry.GetEntriesChanged () == true) && (!m_advRoutingTable.AnyRunningEvent (advEntry.GetDestination ())))
+            {
+              if (!(advEntry.GetSeqNo () % 2))
+                {
+                  advEntry.SetFlag (VALID);
+                  advEntry.SetEntriesChanged (false);
+                  if (m_routingTable.Update (advEntry))
+                    {
+                      LookForQueuedPackets (advEntry.GetDestination ());
+                    }
                   NS_LOG_DEBUG ("Merged update for " << advEntry.GetDestination () << " with main routing Table");
                 }
               m_advRoutingTable.DeleteRoute (advEntry.GetDestination ());
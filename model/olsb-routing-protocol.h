@@ -29,12 +29,27 @@
 #include "olsb-rtable.h"
 #include "olsb-packet-queue.h"
 #include "olsb-packet.h"
+#include "olsb-backlog-monitor.h"
+#include "olsb-link-estimator.h"
+#include "olsb-airtime-estimator.h"
+#include "olsb-metric-policy.h"
+#include "olsb-factor-controller.h"
+#include "olsb-backpressure-scheduler.h"
+#include "olsb-admission-controller.h"
+#include "olsb-link-lifetime-estimator.h"
+#include "olsb-location-table.h"
+#include "olsb-update-cache.h"
+#include "olsb-control-budget.h"
+#include "olsb-neighbor-table.h"
 #include "ns3/node.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-interface.h"
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/traced-callback.h"
+#include <list>
+#include <set>
 
 namespace ns3 {
 namespace olsb {
@@ -53,6 +68,21 @@ public:
   static TypeId GetTypeId (void);
   static const uint32_t OLSB_PORT;
 
+  /**
+   * TracedCallback signature for the factors chosen by the adaptation.
+   *
+   * \param [in] shortestPathFactor The shortest path factor.
+   * \param [in] backpressureFactor The backpressure factor.
+   */
+  typedef void (* FactorTracedCallback)(double shortestPathFactor, double backpressureFactor);
+  /**
+   * TracedCallback signature for the rate admitted by the admission control.
+   *
+   * \param [in] dst The destination of the local flow.
+   * \param [in] rate The rate admitted over the last interval, in packets per second.
+   */
+  typedef void (* AdmittedRateTracedCallback)(Ipv4Address dst, double rate);
+
   /// c-tor
   RoutingProtocol ();
   virtual
@@ -93,6 +123,16 @@ public:
    * \returns the enable buffer flag
    */
   bool GetEnableBufferFlag () const;
+  /**
+   * Set enable custody buffering flag
+   * \param f The enable custody buffering flag
+   */
+  void SetEnableCustodyBufferFlag (bool f);
+  /**
+   * Get enable custody buffering flag
+   * \returns the enable custody buffering flag
+   */
+  bool GetEnableCustodyBufferFlag () const;
   /**
    * Set weighted settling time (WST) flag
    * \param f the weighted settling time (WST) flag
@@ -133,6 +173,48 @@ public:
    * \returns the Backpressure Factor
    */
   double GetBackpressureFactor () const;
+  /**
+   * Set Link Quality Factor
+   * \param factor the Link Quality Factor
+   */
+  void SetLinkQualityFactor (double factor);
+  /**
+   * Get Link Quality Factor
+   * \returns the Link Quality Factor
+   */
+  double GetLinkQualityFactor () const;
+  /**
+   * Set Airtime Factor
+   * \param factor the Airtime Factor
+   */
+  void SetAirtimeFactor (double factor);
+  /**
+   * Get Airtime Factor
+   * \returns the Airtime Factor
+   */
+  double GetAirtimeFactor () const;
+  /**
+   * Use a user supplied comparison as the metric policy
+   * \param compare the comparison, returns true to switch to the candidate route
+   * \param fields the optional record fields (MetricPolicy::Field) that the comparison reads
+   */
+  void SetMetricPolicyCallback (MetricPolicy::CompareCallback compare, uint8_t fields = MetricPolicy::ALL);
+  /**
+   * Get the number of control bytes sent
+   * \returns the bytes of the control packets, IPv4 and UDP headers included
+   */
+  uint64_t GetControlBytesSent () const;
+  /**
+   * Get the number of triggered update records deferred for lack of control budget
+   * \param priority the priority of the records, 2 for large metric changes and 3 for the others
+   * \returns the number of records of that priority deferred, a record deferred again counting once
+   */
+  uint32_t GetDeferredRecords (uint32_t priority) const;
+  /**
+   * Get the number of next hop changes, the oscillation signal of AdaptiveFactors
+   * \returns the changes counted since the last adaptation of the factors, or since the start without it
+   */
+  uint32_t GetRouteChanges () const;
 
 
   /**
@@ -179,6 +261,50 @@ private:
   PacketQueue m_queue;
   /// Flag that is used to enable or disable buffering
   bool EnableBuffering;
+  /// The maximum number of transit packets that a relay is allowed to hold in custody.
+  uint32_t m_maxCustodyQueueLen;
+  /// The maximum number of transit packets per destination that a relay is allowed to hold in custody.
+  uint32_t m_maxCustodyPacketsPerDst;
+  /// The maximum period of time that a relay is allowed to hold a transit packet in custody.
+  Time m_maxCustodyQueueTime;
+  /// Queue used by relays to hold transit packets to which they do not have a route (store-carry-forward).
+  PacketQueue m_custodyQueue;
+  /// Flag that is used to enable or disable custody buffering of transit packets at intermediate hops
+  bool EnableCustodyBuffering;
+  /// How transit packets are forwarded
+  ForwardingMode m_forwardingMode;
+  /// The maximum number of packets held in the commodity queues in backpressure mode.
+  uint32_t m_maxCommodityQueueLen;
+  /// The maximum number of packets per destination held in the commodity queues in backpressure mode.
+  uint32_t m_maxCommodityPacketsPerDst;
+  /// The maximum period of time that a packet is held in the commodity queues in backpressure mode.
+  Time m_maxCommodityQueueTime;
+  /// Per destination (commodity) queues of the packets forwarded in backpressure mode
+  PacketQueue m_commodityQueue;
+  /// Flag that is used to serve the latest packet of a commodity first in backpressure mode
+  bool EnableBackpressureLifo;
+  /// Time between two advertisements of the commodity backlogs in backpressure mode
+  Time m_backlogExchangeInterval;
+  /// Time between two checks for a transmit opportunity while packets wait in the commodity queues
+  Time m_backpressureServiceInterval;
+  /// Packets in the egress queue of an interface below which the interface has a transmit opportunity
+  uint32_t m_maxEgressBacklog;
+  /// Choice of the commodity and neighbor served at a transmit opportunity
+  BackpressureScheduler m_backpressureScheduler;
+  /// Whether the last backlog advertisement carried any backlog
+  bool m_backlogAdvertised;
+  /// Flag that is used to enable or disable the admission control of locally originated packets
+  bool EnableAdmissionControl;
+  /// Time between two updates of the admission control
+  Time m_admissionInterval;
+  /// Utility weight V of the admission control
+  double m_admissionUtilityWeight;
+  /// Largest rate admitted per local flow, in packets per second
+  double m_maxSourceRate;
+  /// Drift-plus-penalty admission of locally originated packets
+  AdmissionController m_admissionController;
+  /// Trace of the rate admitted per local flow after every update
+  TracedCallback<Ipv4Address, double> m_admittedRateTrace;
   /// Flag that is used to enable or disable Weighted Settling Time
   bool EnableWST;
   /// This is the wighted factor to determine the weighted settling time
@@ -186,8 +312,38 @@ private:
   /// This is a flag to enable route aggregation. Route aggregation will aggregate all routes for
   /// 'RouteAggregationTime' from the time an update is received by a node and sends them as a single update .
   bool EnableRouteAggregation;
-  /// Parameter that holds the route aggregation time interval
+  /// Parameter that holds the longest route aggregation time interval
   Time m_routeAggregationTime;
+  /// Parameter that holds the shortest route aggregation time interval
+  Time m_minTriggeredUpdateDelay;
+  /// Current route aggregation time interval, between the shortest and the longest
+  Time m_triggeredUpdateWindow;
+  /// Number of changes that joined the pending triggered update
+  uint32_t m_coalescedTriggers;
+  /// The pending triggered update, if any
+  EventId m_triggeredUpdateEvent;
+  /// Rate of control bytes a node may send, 0 for no bound
+  DataRate m_controlDataRate;
+  /// Control bytes that can be sent at once above the control rate
+  uint32_t m_controlBurstSize;
+  /// Relative metric change above which a changed route is sent first when the control budget is tight
+  double m_largeMetricChange;
+  /// Control bytes sent against the control rate, and the records deferred for lack of them
+  ControlBudget m_controlBudget;
+  /// Flag that is used to exchange digests of the routing table and pull the routes that differ
+  bool EnableAntiEntropy;
+  /// Time between two digests
+  Time m_digestInterval;
+  /// Largest number of address ranges of a digest
+  uint32_t m_digestRanges;
+  /// Flag that is used to beacon the neighbors heard and detect lost neighbors from missed beacons
+  bool EnableHello;
+  /// Time between two beacons
+  Time m_helloInterval;
+  /// Number of beacons in a row a neighbor may miss before it is lost
+  uint32_t m_allowedHelloLoss;
+  /// Neighbors heard through their beacons
+  NeighborTable m_neighborTable;
   /// Unicast callback for own packets
   UnicastForwardCallback m_scb;
   /// Error callback for own packets
@@ -196,6 +352,131 @@ private:
   double m_shortestPathFactor;
   /// This is the wighted factor for backpressure
   double m_backpressureFactor;
+  /// This is the wighted factor for the link quality (ETX)
+  double m_linkQualityFactor;
+  /// Number of periodic update intervals over which the delivery ratio of a neighbor is estimated
+  uint32_t m_linkQualityWindow;
+  /// Delivery ratio of the periodic updates of every neighbor
+  LinkEstimator m_linkEstimator;
+  /// This is the wighted factor for the airtime (ETT)
+  double m_airtimeFactor;
+  /// Size of the reference packet whose expected transmission time is the airtime cost of a link
+  uint32_t m_airtimeReferenceSize;
+  /// Expected transmission time of the Wi-Fi links to every neighbor
+  AirtimeEstimator m_airtimeEstimator;
+  /// Policy that decides whether an update with the same sequence number replaces the current route
+  MetricPolicyType m_metricPolicyType;
+  /// Comparison used by the custom metric policy
+  MetricPolicy::CompareCallback m_metricPolicyCallback;
+  /// Optional record fields read by the custom metric policy
+  uint8_t m_metricPolicyFields;
+  /// Metric policy built from the parameters above, 0 until first use or after a parameter changed
+  Ptr<MetricPolicy> m_metricPolicy;
+  /// Flag that is used to enable or disable the run time adaptation of the factors
+  bool EnableAdaptiveFactors;
+  /// Time between two adaptations of the factors
+  Time m_factorAdaptationInterval;
+  /// Largest change of the backpressure share of the factors per adaptation
+  double m_factorAdaptationStep;
+  /// Smallest backpressure share of the factors reached by adaptation
+  double m_minBackpressureShare;
+  /// Largest backpressure share of the factors reached by adaptation
+  double m_maxBackpressureShare;
+  /// Route changes per second above which adaptation moves the factors towards shortest path
+  double m_maxRouteChangeRate;
+  /// Change of the local backlog per adaptation, in time to drain, below which the factors are kept
+  Time m_backlogTrendDeadband;
+  /// Control law of the adaptation of the factors
+  FactorController m_factorController;
+  /// Local backlog at the previous adaptation, in seconds to drain
+  double m_lastBacklog;
+  /// Drop count of the packet queues at the previous adaptation
+  uint32_t m_lastDrops;
+  /// Next hop changes decided by the metric policy since the previous adaptation
+  uint32_t m_routeChanges;
+  /// Trace of the factors after every adaptation
+  TracedCallback<double, double> m_factorTrace;
+  /// Cost reduction that an update from another neighbor must bring to take over a route
+  double m_switchThreshold;
+  /// Cost reduction, as a fraction of the current cost, that an update from another neighbor must bring
+  double m_relativeSwitchThreshold;
+  /// Minimum time a destination keeps its next hop before the metric policy may switch it again
+  Time m_minDwellTime;
+  /// Time of the last next hop switch decided by the metric policy, per destination
+  std::map<Ipv4Address, Time> m_lastSwitch;
+  /// Flag that is used to choose the next hop of every forwarded packet among the candidate neighbors
+  bool EnableForwardTimeSelection;
+  /// Flag that is used to give the latency class a next hop of its own
+  bool EnableTrafficClasses;
+  /// DSCP from which packets belong to the latency class
+  uint8_t m_latencyDscpThreshold;
+  /// This is the wighted factor for the shortest path of the latency class
+  double m_latencyShortestPathFactor;
+  /// This is the wighted factor for backpressure of the latency class
+  double m_latencyBackpressureFactor;
+  /// Metric policy of the latency class, 0 until first use or after a parameter changed
+  Ptr<MetricPolicy> m_latencyPolicy;
+  /// Flag that is used to advertise positions and avoid next hops whose link is predicted to break
+  bool EnableMobilityPrediction;
+  /// Distance beyond which a neighbor is predicted to be out of reach
+  double m_transmissionRange;
+  /// Predicted remaining lifetime below which a link is avoided
+  Time m_minLinkLifetime;
+  /// Remaining lifetime of the link to every neighbor, predicted from their positions
+  LinkLifetimeEstimator m_linkLifetimeEstimator;
+  /// Events that move routes away from a neighbor shortly before its link is predicted to break
+  std::map<Ipv4Address, EventId> m_linkBreakEvents;
+  /// Flag that is used to forward packets without a route towards the position of their destination
+  bool EnableGeographicFallback;
+  /// Maximum number of hops a packet is forwarded greedily
+  uint32_t m_maxGreedyHops;
+  /// Time after which the position of a node is forgotten
+  Time m_locationLifetime;
+  /// Last known positions of the nodes
+  LocationTable m_locationTable;
+  /// Encoding of the route update records
+  UpdateFormat m_updateFormat;
+  /// Flag that is used to leave the routes advertised unchanged out of the periodic updates
+  bool EnableDeltaUpdates;
+  /// Number of periodic updates between two full updates
+  uint32_t m_fullUpdateInterval;
+  /// Number of periodic updates sent
+  uint32_t m_periodicUpdateCount;
+  /// Whether a neighbor asked for a full update that was not sent yet
+  bool m_fullUpdatePending;
+  /// Last record advertised per destination
+  std::map<Ipv4Address, OlsbHeader> m_lastAdvertised;
+  /// Destinations whose record was deferred and not advertised since
+  std::set<Ipv4Address> m_deferredDsts;
+  /// Full update of a neighbor being received
+  struct FullUpdateState
+  {
+    uint16_t updateId; ///< Identifier of the update
+    uint8_t nextFragment; ///< Index of the next packet expected
+    std::set<Ipv4Address> listed; ///< Destinations listed by the packets received so far
+  };
+  /// Full updates being received, per neighbor
+  std::map<Ipv4Address, FullUpdateState> m_fullUpdates;
+  /// Serialized records of the previous updates
+  UpdateCache m_updateCache;
+  /// Largest delay between two packets of a split update
+  Time m_maxFragmentJitter;
+  /// Sending of the later packets of split updates
+  std::list<EventId> m_fragmentEvents;
+  /// Queues whose backlog is advertised as the queue metric
+  QueueMetricSource m_queueMetricSource;
+  /// Flag that is used to advertise the backlog per destination instead of per interface
+  bool EnablePerDestinationBacklog;
+  /// Time to drain that counts as one unit of the advertised queue metric
+  Time m_queueMetricResolution;
+  /// Time constant of the moving average of the egress backlog
+  Time m_queueMetricTimeConstant;
+  /// Flag that is used to advertise the moving average of the backlog instead of its instantaneous value
+  bool AdvertiseSmoothedQueue;
+  /// Data rate used to compute the time to drain when the rate of an interface is unknown
+  DataRate m_egressDataRate;
+  /// Egress backlog of the OLSB interfaces
+  BacklogMonitor m_backlogMonitor;
 
 
 private:
@@ -211,9 +492,12 @@ private:
    */
   void
   DeferredRouteOutput (Ptr<const Packet> p, const Ipv4Header & header, UnicastForwardCallback ucb, ErrorCallback ecb);
-  /// Look for any queued packets to send them out
+  /**
+   * Look for packets queued for a destination whose route just became valid and send them out
+   * \param dst - destination address whose route was installed or updated
+   */
   void
-  LookForQueuedPackets (void);
+  LookForQueuedPackets (Ipv4Address dst);
   /**
    * Send packet from queue
    * \param dst - destination address to which we are sending the packet to
@@ -221,6 +505,264 @@ private:
    */
   void
   SendPacketFromQueue (Ipv4Address dst, Ptr<Ipv4Route> route);
+  /**
+   * Send a transit packet held in custody
+   * \param dst - destination address to which we are forwarding the packet to
+   * \param route - route identified for this packet
+   */
+  void
+  SendPacketFromCustodyQueue (Ipv4Address dst, Ptr<Ipv4Route> route);
+  /**
+   * Check whether packets to a destination are forwarded by the backpressure engine
+   * \param dst - destination address
+   * \return true unless dst is a broadcast, multicast or local address
+   */
+  bool
+  IsCommodity (Ipv4Address dst) const;
+  /**
+   * Queue a packet in the commodity queue of its destination and serve the commodity queues
+   * \param entry - the packet with its header and callbacks
+   * \return true if the packet was queued
+   */
+  bool
+  EnqueueCommodity (QueueEntry &entry);
+  /**
+   * Choose the commodity and the neighbor served at a transmit opportunity of an interface
+   * \param dev - the interface
+   * \param dst - destination chosen
+   * \param neighbor - neighbor chosen, reachable through dev
+   * \return true if some commodity has a positive weight
+   */
+  bool
+  SelectCommodity (Ptr<NetDevice> dev, Ipv4Address &dst, Ipv4Address &neighbor);
+  /// Send packets from the commodity queues on every interface that has a transmit opportunity
+  void
+  ServeCommodities ();
+  /// Broadcast the backlog of every commodity
+  void
+  SendBacklog ();
+  /**
+   * Process the backlogs advertised by a neighbor
+   * \param packet - the backlog message, without its type header
+   * \param sender - the neighbor
+   */
+  void
+  RecvBacklog (Ptr<Packet> packet, Ipv4Address sender);
+  /**
+   * Check whether a record differs from the last one advertised for its destination
+   * \param record - the route update record
+   * \return true if the destination was never advertised or its metric or validity changed
+   */
+  bool
+  IsAdvertisedChange (const OlsbHeader &record) const;
+  /**
+   * Remember the records sent in an update
+   * \param records - the route update records
+   */
+  void
+  RememberAdvertised (const std::vector<OlsbHeader> &records);
+  /**
+   * Collect the destinations listed by a packet of a full update and, once all packets of the
+   * update arrived in order, withdraw the routes through the sender it left out
+   * \param header - the full update message of the packet
+   * \param records - the route update records of the packet
+   * \param sender - the sender of the update
+   */
+  void
+  RecvFullUpdate (const FullUpdateHeader &header, const std::vector<OlsbHeader> &records, Ipv4Address sender);
+  /**
+   * Ask a neighbor for a full update
+   * \param neighbor - the neighbor
+   */
+  void
+  SendFullRequest (Ipv4Address neighbor);
+  /**
+   * Send a full periodic update soon, as a neighbor asked for it
+   * \param sender - the neighbor
+   */
+  void
+  RecvFullRequest (Ipv4Address sender);
+  /**
+   * Get the routes summarised by a digest
+   * \param seqnos - the sequence number of every valid route, and of this node
+   */
+  void
+  GetDigestRoutes (std::map<Ipv4Address, uint32_t> &seqnos);
+  /// Broadcast a digest of the routing table on every interface
+  void
+  SendDigest ();
+  /**
+   * Pull the address ranges where the digest of a neighbor differs from the routing table
+   * \param socket - the socket the digest was received on
+   * \param header - the digest
+   * \param sender - the neighbor
+   */
+  void
+  RecvDigest (Ptr<Socket> socket, const DigestHeader &header, Ipv4Address sender);
+  /**
+   * Send the routes in the requested address ranges to the neighbor that asked for them
+   * \param socket - the socket the request was received on
+   * \param header - the request
+   * \param sender - the neighbor
+   */
+  void
+  RecvPull (Ptr<Socket> socket, const PullHeader &header, Ipv4Address sender);
+  /// Forget the neighbors that missed too many beacons and beacon the others on every interface
+  void
+  SendHello ();
+  /**
+   * Record the beacon of a neighbor and check whether it hears this node
+   * \param socket - the socket the beacon was received on
+   * \param header - the beacon
+   * \param sender - the neighbor
+   */
+  void
+  RecvHello (Ptr<Socket> socket, const HelloHeader &header, Ipv4Address sender);
+  /**
+   * Withdraw the routes through a neighbor that was lost and advertise it in a triggered update
+   * \param neighbor - the neighbor
+   */
+  void
+  InvalidateNeighbor (Ipv4Address neighbor);
+  /**
+   * Encode route update records in the configured format, reusing the records serialized before
+   * \param records - the records, in the order they were added
+   * \return the update packet
+   */
+  Ptr<Packet>
+  BuildUpdate (const std::vector<OlsbHeader> &records);
+  /**
+   * Get the position and velocity of this node
+   * \param position - the position of the node
+   * \param velocity - the velocity of the node
+   * \return false if the node has no mobility model
+   */
+  bool
+  GetMobility (Vector &position, Vector &velocity) const;
+  /**
+   * Build the messages that lead every route update: the position and velocity of this node, and with the
+   * geographic fallback the freshest positions it knows of other nodes
+   * \param maxSize - the size the messages may take
+   * \return the packet holding the messages, empty without mobility prediction and geographic fallback
+   */
+  Ptr<Packet>
+  BuildPosition (uint32_t maxSize) const;
+  /**
+   * Get the size of the encoding of route update records
+   * \param records - the records
+   * \return the size in bytes in the configured format
+   */
+  uint32_t
+  GetUpdateSize (const std::vector<OlsbHeader> &records) const;
+  /**
+   * Get the priority of a record in a split update
+   * \param record - the route update record
+   * \return 0 for the own record, 1 for withdrawn routes, 2 for large metric changes and 3 for the others
+   */
+  uint32_t
+  GetUpdatePriority (const OlsbHeader &record) const;
+  /**
+   * Check whether a record changed a lot since it was last advertised
+   * \param record - the route update record
+   * \return true if the destination was never advertised, its validity or hop count changed, or its queue
+   * size, path ETX or airtime changed by more than LargeMetricChange
+   */
+  bool
+  IsLargeMetricChange (const OlsbHeader &record) const;
+  /**
+   * Keep the records of a triggered update that fit in the control budget, most urgent first, and
+   * retry the others once the budget allows
+   * \param records - the records, replaced by those to send now
+   */
+  void
+  SelectWithinControlBudget (std::vector<OlsbHeader> &records);
+  /**
+   * Get the room for an update packet on an interface
+   * \param iface - the interface address
+   * \return the MTU of the interface less the IPv4 and UDP headers
+   */
+  uint32_t
+  GetUpdateRoom (Ipv4InterfaceAddress iface) const;
+  /**
+   * Split route update records in packets that fit the room, the most urgent records first
+   * \param records - the records
+   * \param room - the largest size of a packet
+   * \param fullUpdate - whether the records list every route of this node
+   * \param packets - the packets of the update
+   */
+  void
+  BuildUpdatePackets (const std::vector<OlsbHeader> &records, uint32_t room, bool fullUpdate,
+                      std::vector<Ptr<Packet> > &packets);
+  /**
+   * Send the packets of an update, the first one now and the others spread after it
+   * \param socket - the socket of the interface
+   * \param packets - the packets of the update, shared with the other interfaces
+   * \param destination - the broadcast address of the interface, or a neighbor
+   */
+  void
+  SendUpdatePackets (Ptr<Socket> socket, const std::vector<Ptr<Packet> > &packets, Ipv4Address destination);
+  /**
+   * Get the address that reaches all neighbors on an interface
+   * \param iface - the interface address
+   * \return the all-hosts broadcast address on a /32 address, the subnet-directed one otherwise
+   */
+  Ipv4Address
+  GetBroadcastDestination (Ipv4InterfaceAddress iface) const;
+  /**
+   * Send one control packet and charge it to the control budget
+   * \param socket - the socket of the interface
+   * \param packet - the packet
+   * \param destination - the broadcast address of the interface, or a neighbor
+   */
+  void
+  SendUpdatePacket (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination);
+  /**
+   * Process the position and velocity advertised by a neighbor
+   * \param header - the position message
+   * \param sender - the neighbor
+   */
+  void
+  RecvPosition (const PositionHeader &header, Ipv4Address sender);
+  /**
+   * Process the positions of other nodes advertised by a neighbor
+   * \param header - the location message
+   */
+  void
+  RecvLocation (const LocationHeader &header);
+  /**
+   * Choose the neighbor closest to the position of a destination
+   * \param dst - destination address
+   * \param nextHop - the chosen neighbor
+   * \return false if the geographic fallback is disabled, the position of dst is unknown or no neighbor is closer to it
+   */
+  bool
+  SelectGreedyNeighbor (Ipv4Address dst, Ipv4Address &nextHop);
+  /**
+   * Check whether the link to a neighbor is predicted to break soon
+   * \param neighbor - the neighbor
+   * \return true if mobility prediction is enabled and the link lasts less than MinLinkLifetime
+   */
+  bool
+  IsLinkExpiring (Ipv4Address neighbor) const;
+  /**
+   * Find the best neighbor in reach that advertised a recent enough route to a destination
+   * \param dst - destination address
+   * \param seqNo - the oldest acceptable sequence number
+   * \param maxHops - the most hops of a route with sequence number seqNo, a longer one may lead back
+   * through this node
+   * \param avoid - a neighbor to leave out
+   * \param chosen - the route advertised by the chosen neighbor
+   * \return false if no neighbor whose link is not about to break advertised such a route
+   */
+  bool
+  LookupStableCandidate (Ipv4Address dst, uint32_t seqNo, uint32_t maxHops, Ipv4Address avoid,
+                         RoutingTableEntry &chosen);
+  /**
+   * Move the routes through a neighbor whose link is predicted to break to the best other candidate
+   * \param neighbor - the neighbor
+   */
+  void
+  AvoidExpiringLink (Ipv4Address neighbor);
   /**
    * Find socket with local interface address iface
    * \param iface the interface
@@ -261,6 +803,94 @@ private:
    */
   Time
   GetSettlingTime (Ipv4Address dst);
+  /**
+   * Get the queue metric to advertise for a route
+   * \param dev - output device of the route
+   * \param dst - destination of the route
+   * \return the backlog, in packets for the route buffer or in units of QueueMetricResolution otherwise
+   */
+  uint32_t
+  GetQueueMetric (Ptr<NetDevice> dev, Ipv4Address dst);
+  /**
+   * Get the metric policy, building it if a parameter changed
+   * \return the metric policy
+   */
+  Ptr<MetricPolicy>
+  GetMetricPolicy ();
+  /**
+   * Get the metric policy of the latency class, building it if a parameter changed
+   * \return the metric policy
+   */
+  Ptr<MetricPolicy>
+  GetLatencyPolicy ();
+  /**
+   * Get the optional record fields read by the metric policies in use
+   * \return the fields, a combination of MetricPolicy::Field
+   */
+  uint8_t
+  GetMetricFields ();
+  /**
+   * Get the traffic class of a packet
+   * \param tos - the type of service of the packet
+   * \return the traffic class
+   */
+  TrafficClass
+  GetTrafficClass (uint8_t tos) const;
+  /**
+   * Choose the next hop of the latency class among the candidates for a destination
+   * \param dst - destination address
+   */
+  void
+  UpdateClassNextHop (Ipv4Address dst);
+  /**
+   * Fill in the optional metrics of a record, leaving out those that the metric policy does not read
+   * \param olsbHeader - the record, with its destination set
+   * \param dev - output device of the route
+   * \param etx - path ETX of the route
+   * \param airtime - path airtime of the route
+   */
+  void
+  SetAdvertisedMetric (OlsbHeader &olsbHeader, Ptr<NetDevice> dev, uint32_t etx, uint32_t airtime);
+  /// Adapt the shortest path and backpressure factors to the signals observed since the last adaptation
+  void
+  AdaptFactors ();
+  /**
+   * Get the congestion price of the local flow to a destination
+   * \param dst - destination of the flow
+   * \return the packets held locally for dst plus the packets that the next hop holds for it, in packets
+   */
+  double
+  GetCongestionPrice (Ipv4Address dst);
+  /// End the interval of the admission control and trace the admitted rates
+  void
+  UpdateAdmission ();
+  /**
+   * Check whether an update from another neighbor may take over a route
+   * \param dst - destination of the route
+   * \param current - metric of the current route
+   * \param candidate - metric of the route through the sender of the update
+   * \return true if the candidate clears the switch thresholds and the current next hop was kept long enough
+   */
+  bool
+  IsSwitchAllowed (Ipv4Address dst, const RouteMetric &current, const RouteMetric &candidate);
+  /**
+   * Drop the per destination state kept besides the routing table once a route is removed
+   * \param dst - destination of the removed route
+   */
+  void
+  ForgetRoute (Ipv4Address dst);
+  /**
+   * Choose the next hop of a packet among the neighbors that advertised a route to its destination
+   * \param rt - installed route to the destination
+   * \param tos - the type of service of the packet
+   * \return the next hop of the packet's traffic class, the next hop of the installed route, or a feasible
+   * candidate that the metric policy finds clearly better
+   */
+  Ipv4Address
+  SelectNextHop (const RoutingTableEntry &rt, uint8_t tos);
+  /// Schedules a triggered update, unless one is pending already
+  void
+  ScheduleTriggeredUpdate ();
   /// Sends trigger update from a node
   void
   SendTriggeredUpdate ();
@@ -282,6 +912,18 @@ private:
   Timer m_periodicUpdateTimer;
   /// Timer used by the trigger updates in case of Weighted Settling Time is used
   Timer m_triggeredExpireTimer;
+  /// Timer to adapt the factors
+  Timer m_factorAdaptationTimer;
+  /// Timer to advertise the commodity backlogs
+  Timer m_backlogExchangeTimer;
+  /// Timer to look for a transmit opportunity while packets wait in the commodity queues
+  Timer m_backpressureServiceTimer;
+  /// Timer to update the admission control
+  Timer m_admissionTimer;
+  /// Timer of the digests
+  Timer m_digestTimer;
+  /// Timer of the beacons
+  Timer m_helloTimer;
 
   /// Provides uniform random variables.
   Ptr<UniformRandomVariable> m_uniformRandomVariable;
@@ -46,6 +46,8 @@ RoutingTableEntry::RoutingTableEntry (Ptr<NetDevice> dev,
   : m_seqNo (seqNo),
     m_hops (hops),
     m_qsize (qsize),
+    m_etx (0),
+    m_airtime (0),
     m_lifeTime (lifetime),
     m_iface (iface),
     m_flag (VALID),
@@ -107,6 +109,7 @@ RoutingTable::LookupRoute (Ipv4Address id,
 bool
 RoutingTable::DeleteRoute (Ipv4Address dst)
 {
+  m_classNextHops.erase (dst);
   if (m_ipv4AddressEntry.erase (dst) != 0)
     {
       // NS_LOG_DEBUG("Route erased");
@@ -191,6 +194,101 @@ RoutingTable::GetListOfDestinationWithNextHop (Ipv4Address nextHop,
     }
 }
 
+void
+RoutingTable::UpdateCandidate (RoutingTableEntry & rt)
+{
+  std::map<Ipv4Address, RoutingTableEntry> &candidates = m_candidates[rt.GetDestination ()];
+  std::map<Ipv4Address, RoutingTableEntry>::iterator i = candidates.find (rt.GetNextHop ());
+  if (i == candidates.end ())
+    {
+      candidates.insert (std::make_pair (rt.GetNextHop (),rt));
+    }
+  else
+    {
+      i->second = rt;
+    }
+}
+
+void
+RoutingTable::DeleteCandidate (Ipv4Address dst, Ipv4Address nextHop)
+{
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry> >::iterator i = m_candidates.find (dst);
+  if (i == m_candidates.end ())
+    {
+      return;
+    }
+  i->second.erase (nextHop);
+  if (i->second.empty ())
+    {
+      m_candidates.erase (i);
+    }
+}
+
+void
+RoutingTable::GetCandidates (Ipv4Address dst, std::map<Ipv4Address, RoutingTableEntry> & candidates)
+{
+  candidates.clear ();
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry> >::iterator i = m_candidates.find (dst);
+  if (i == m_candidates.end ())
+    {
+      return;
+    }
+  for (std::map<Ipv4Address, RoutingTableEntry>::iterator j = i->second.begin (); j != i->second.end (); )
+    {
+      if (j->second.GetLifeTime () > m_holddownTime)
+        {
+          i->second.erase (j++);
+        }
+      else
+        {
+          candidates.insert (*j);
+          ++j;
+        }
+    }
+  if (i->second.empty ())
+    {
+      m_candidates.erase (i);
+    }
+}
+
+void
+RoutingTable::SetClassNextHop (Ipv4Address dst, TrafficClass trafficClass, Ipv4Address nextHop)
+{
+  m_classNextHops[dst][trafficClass] = nextHop;
+}
+
+void
+RoutingTable::DeleteClassNextHop (Ipv4Address dst, TrafficClass trafficClass)
+{
+  std::map<Ipv4Address, std::map<TrafficClass, Ipv4Address> >::iterator i = m_classNextHops.find (dst);
+  if (i == m_classNextHops.end ())
+    {
+      return;
+    }
+  i->second.erase (trafficClass);
+  if (i->second.empty ())
+    {
+      m_classNextHops.erase (i);
+    }
+}
+
+bool
+RoutingTable::LookupClassNextHop (Ipv4Address dst, TrafficClass trafficClass, Ipv4Address & nextHop) const
+{
+  std::map<Ipv4Address, std::map<TrafficClass, Ipv4Address> >::const_iterator i = m_classNextHops.find (dst);
+  if (i == m_classNextHops.end ())
+    {
+      return false;
+    }
+  std::map<TrafficClass, Ipv4Address>::const_iterator j = i->second.find (trafficClass);
+  if (j == i->second.end ())
+    {
+      return false;
+    }
+  nextHop = j->second;
+  return true;
+}
+
 void
 RoutingTableEntry::Print (Ptr<OutputStreamWrapper> stream, Time::Unit unit /*= Time::S*/) const
 {
@@ -213,6 +311,8 @@ RoutingTableEntry::Print (Ptr<OutputStreamWrapper> stream, Time::Unit unit /*= T
   *os << std::setw (16) << iface.str ();
   *os << std::setw (16) << m_hops;
   *os << std::setw (16) << m_qsize;
+  *os << std::setw (16) << m_etx;
+  *os << std::setw (16) << m_airtime;
   *os << std::setw (16) << m_seqNo;
   *os << std::setw(16) << ltime.str ();
   *os << stime.str () << std::endl;
@@ -274,6 +374,8 @@ RoutingTable::Print (Ptr<OutputStreamWrapper> stream, Time::Unit unit /*= Time::
   *os << std::setw (16) << "Interface";
   *os << std::setw (16) << "HopCount";
   *os << std::setw (16) << "QueueSize";
+  *os << std::setw (16) << "Etx";
+  *os << std::setw (16) << "Airtime";
   *os << std::setw (16) << "SeqNum";
   *os << std::setw (16) << "LifeTime";
   *os << "SettlingTime" << std::endl;
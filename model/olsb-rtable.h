@@ -43,6 +43,13 @@ enum RouteFlags
   INVALID = 1,     // !< INVALID
 };
 
+/// Traffic classes that may follow a next hop of their own
+enum TrafficClass
+{
+  BULK_CLASS = 0,     // !< follows the installed route
+  LATENCY_CLASS = 1,     // !< follows the class next hop when one is known
+};
+
 /**
  * \ingroup olsb
  * \brief Routing table entry
@@ -276,6 +283,42 @@ public:
   {
     return m_qsize;
   }
+  /**
+   * Set path ETX
+   * \param etx The path ETX, scaled by LinkEstimator::ETX_SCALE
+   */
+  void
+  SetEtx (uint32_t etx)
+  {
+    m_etx = etx;
+  }
+  /**
+   * Get path ETX
+   * \returns the path ETX, scaled by LinkEstimator::ETX_SCALE
+   */
+  uint32_t
+  GetEtx () const
+  {
+    return m_etx;
+  }
+  /**
+   * Set path airtime
+   * \param airtime The path airtime in microseconds
+   */
+  void
+  SetAirtime (uint32_t airtime)
+  {
+    m_airtime = airtime;
+  }
+  /**
+   * Get path airtime
+   * \returns the path airtime in microseconds
+   */
+  uint32_t
+  GetAirtime () const
+  {
+    return m_airtime;
+  }
   /**
    * \brief Compare destination address
    * \param destination destination node IP address
@@ -302,6 +345,10 @@ private:
   uint32_t m_hops;
   /// Queue Size of the next hop unit
   uint32_t m_qsize;
+  /// Expected transmission count of the path through the next hop
+  uint32_t m_etx;
+  /// Expected transmission time of the path through the next hop, in microseconds
+  uint32_t m_airtime;
   /**
    * \brief Expiration or deletion time of the route
    *	Lifetime field in the routing table plays dual role --
@@ -399,7 +446,53 @@ public:
   Clear ()
   {
     m_ipv4AddressEntry.clear ();
+    m_candidates.clear ();
+    m_classNextHops.clear ();
   }
+  /**
+   * Remember the route that a neighbor advertised for a destination as a forwarding candidate
+   * \param rt routing table entry whose next hop is the advertising neighbor
+   */
+  void
+  UpdateCandidate (RoutingTableEntry & rt);
+  /**
+   * Forget the route that a neighbor advertised for a destination
+   * \param dst destination address
+   * \param nextHop the advertising neighbor
+   */
+  void
+  DeleteCandidate (Ipv4Address dst, Ipv4Address nextHop);
+  /**
+   * Get the forwarding candidates for a destination that were refreshed within the hold down time
+   * \param dst destination address
+   * \param candidates the candidates, indexed by next hop
+   */
+  void
+  GetCandidates (Ipv4Address dst, std::map<Ipv4Address, RoutingTableEntry> & candidates);
+  /**
+   * Set the best next hop of a traffic class for a destination
+   * \param dst destination address
+   * \param trafficClass the traffic class
+   * \param nextHop the next hop
+   */
+  void
+  SetClassNextHop (Ipv4Address dst, TrafficClass trafficClass, Ipv4Address nextHop);
+  /**
+   * Forget the next hop of a traffic class for a destination
+   * \param dst destination address
+   * \param trafficClass the traffic class
+   */
+  void
+  DeleteClassNextHop (Ipv4Address dst, TrafficClass trafficClass);
+  /**
+   * Lookup the best next hop of a traffic class for a destination
+   * \param dst destination address
+   * \param trafficClass the traffic class
+   * \param nextHop the next hop, if exists
+   * \return true on success
+   */
+  bool
+  LookupClassNextHop (Ipv4Address dst, TrafficClass trafficClass, Ipv4Address & nextHop) const;
   /**
    * Delete all outdated entries if Lifetime is expired
    * \param removedAddresses is the list of addresses to purge
@@ -482,6 +575,10 @@ private:
   std::map<Ipv4Address, RoutingTableEntry> m_ipv4AddressEntry;
   /// an entry in the event table.
   std::map<Ipv4Address, EventId> m_ipv4Events;
+  /// routes advertised by every neighbor, per destination and next hop
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry> > m_candidates;
+  /// best next hop of every traffic class that does not follow the installed route, per destination
+  std::map<Ipv4Address, std::map<TrafficClass, Ipv4Address> > m_classNextHops;
   /// hold down time of an expired route
   Time m_holddownTime;
 
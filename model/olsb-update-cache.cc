@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#include <algorithm>
+#include "olsb-update-cache.h"
+#include "ns3/buffer.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OlsbUpdateCache");
+
+namespace olsb {
+
+namespace {
+/**
+ * Compare every field of two records
+ * \param a a route update record
+ * \param b another route update record
+ * \returns true if the records serialize to the same bytes
+ */
+bool
+IsSameRecord (const OlsbHeader &a, const OlsbHeader &b)
+{
+  return a.GetDst () == b.GetDst () && a.GetDstSeqno () == b.GetDstSeqno () && a.GetHopCount () == b.GetHopCount ()
+         && a.GetQueueSize () == b.GetQueueSize () && a.GetEtx () == b.GetEtx () && a.GetAirtime () == b.GetAirtime ()
+         && a.GetFields () == b.GetFields ();
+}
+}
+
+UpdateCache::UpdateCache ()
+  : m_lastFormat (FIXED_FORMAT),
+    m_hits (0),
+    m_misses (0)
+{
+}
+
+Ptr<Packet>
+UpdateCache::Build (const std::vector<OlsbHeader> &records, UpdateFormat format)
+{
+  if (m_lastUpdate != 0 && format == m_lastFormat && records.size () == m_lastRecords.size ()
+      && std::equal (records.begin (), records.end (), m_lastRecords.begin (), IsSameRecord))
+    {
+      NS_LOG_LOGIC ("Sharing the last update of " << records.size () << " records");
+      return m_lastUpdate->Copy ();
+    }
+  Ptr<Packet> packet;
+  if (format == COMPACT_FORMAT)
+    {
+      // Records are coded relative to each other, so there is nothing to reuse per record
+      CompactUpdateHeader compactHeader;
+      for (std::vector<OlsbHeader>::const_iterator r = records.begin (); r != records.end (); ++r)
+        {
+          compactHeader.AddRecord (*r);
+        }
+      packet = Create<Packet> ();
+      packet->AddHeader (compactHeader);
+      packet->AddHeader (TypeHeader (OLSB_COMPACT_UPDATE));
+    }
+  else
+    {
+      // Records without optional fields keep the original 16 byte format, with no leading message
+      uint8_t fields = OlsbHeader::GetNeededFields (records);
+      std::vector<uint8_t> payload;
+      payload.reserve (records.size () * OlsbHeader::GetRecordSize (fields));
+      for (std::vector<OlsbHeader>::const_iterator r = records.begin (); r != records.end (); ++r)
+        {
+          OlsbHeader record (*r);
+          record.SetFields (fields);
+          Append (record,payload);
+        }
+      packet = payload.empty () ? Create<Packet> () : Create<Packet> (&payload[0],payload.size ());
+      if (fields != 0)
+        {
+          packet->AddHeader (RecordFieldsHeader (fields));
+          packet->AddHeader (TypeHeader (OLSB_RECORD_FIELDS));
+        }
+    }
+  m_lastRecords = records;
+  m_lastFormat = format;
+  m_lastUpdate = packet;
+  return packet->Copy ();
+}
+
+void
+UpdateCache::Append (const OlsbHeader &record, std::vector<uint8_t> &payload)
+{
+  std::map<Ipv4Address, Entry>::iterator i = m_entries.find (record.GetDst ());
+  if (i == m_entries.end () || !IsSameRecord (i->second.record,record))
+    {
+      Entry &entry = m_entries[record.GetDst ()];
+      uint32_t size = record.GetSerializedSize ();
+      Buffer buffer;
+      buffer.AddAtStart (size);
+      record.Serialize (buffer.Begin ());
+      entry.record = record;
+      entry.data.resize (size);
+      buffer.CopyData (&entry.data[0],size);
+      payload.insert (payload.end (), entry.data.begin (), entry.data.end ());
+      m_misses++;
+      return;
+    }
+  payload.insert (payload.end (), i->second.data.begin (), i->second.data.end ());
+  m_hits++;
+}
+
+void
+UpdateCache::Invalidate (Ipv4Address dst)
+{
+  m_entries.erase (dst);
+}
+
+void
+UpdateCache::Clear ()
+{
+  m_entries.clear ();
+  m_lastRecords.clear ();
+  m_lastUpdate = 0;
+}
+
+}
+}
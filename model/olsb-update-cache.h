@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2022 Aziza Atayev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Aziza Atayev <azizaa@post.bgu.ac.il>
+ * Kobi lab reference
+ * Ben Gurion University (BGU)
+ * Department of Electrical Engineering
+ * Beer Sheva, Israel.
+ *
+ */
+
+#ifndef OLSB_UPDATE_CACHE_H
+#define OLSB_UPDATE_CACHE_H
+
+#include <map>
+#include <vector>
+#include "ns3/ipv4-address.h"
+#include "ns3/packet.h"
+#include "olsb-packet.h"
+
+namespace ns3 {
+namespace olsb {
+/**
+ * \ingroup olsb
+ * \brief Serialized route update records, kept from one update to the next
+ *
+ * Most records of an update are the same as in the previous one. The cache keeps the serialized
+ * form of the last record of every destination and serializes a record again only when one of its
+ * fields changed, so a fixed format update is assembled by copying bytes. The last update built is
+ * kept as well: the same records sent on another interface share its buffer instead of being
+ * encoded again.
+ */
+class UpdateCache
+{
+public:
+  /// c-tor
+  UpdateCache ();
+  /**
+   * Build the payload of an update
+   * \param records the route update records
+   * \param format the encoding of the records
+   * \returns the update
+   */
+  Ptr<Packet>
+  Build (const std::vector<OlsbHeader> &records, UpdateFormat format);
+  /**
+   * Forget the serialized record of a destination whose route was removed
+   * \param dst the destination
+   */
+  void
+  Invalidate (Ipv4Address dst);
+  /// Forget all serialized records
+  void
+  Clear ();
+  /**
+   * Get the number of records copied from the cache
+   * \returns the number of records that were not serialized again
+   */
+  uint32_t
+  GetHits () const
+  {
+    return m_hits;
+  }
+  /**
+   * Get the number of records serialized
+   * \returns the number of records that were new or changed
+   */
+  uint32_t
+  GetMisses () const
+  {
+    return m_misses;
+  }
+
+private:
+  /// A record and its serialized form
+  struct Entry
+  {
+    OlsbHeader record; ///< the record
+    std::vector<uint8_t> data; ///< the record serialized in the fixed format
+  };
+  /**
+   * Append a record in the fixed format, serializing it only if it changed
+   * \param record the route update record
+   * \param payload the bytes of the update
+   */
+  void
+  Append (const OlsbHeader &record, std::vector<uint8_t> &payload);
+
+  /// last serialized record per destination
+  std::map<Ipv4Address, Entry> m_entries;
+  /// records of the last update built
+  std::vector<OlsbHeader> m_lastRecords;
+  /// encoding of the last update built
+  UpdateFormat m_lastFormat;
+  /// the last update built, 0 if none
+  Ptr<Packet> m_lastUpdate;
+  /// number of records copied from the cache
+  uint32_t m_hits;
+  /// number of records serialized
+  uint32_t m_misses;
+};
+
+}
+}
+
+#endif /* OLSB_UPDATE_CACHE_H */
@@ -36,8 +36,34 @@
 #include "ns3/pcap-file.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-queue-disc-item.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/data-rate.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/wifi-mac-helper.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/txop.h"
+#include "ns3/pointer.h"
 #include "ns3/olsb-packet.h"
 #include "ns3/olsb-rtable.h"
+#include "ns3/olsb-packet-queue.h"
+#include "ns3/olsb-backlog-monitor.h"
+#include "ns3/olsb-airtime-estimator.h"
+#include "ns3/olsb-link-estimator.h"
+#include "ns3/olsb-metric-policy.h"
+#include "ns3/olsb-factor-controller.h"
+#include "ns3/olsb-backpressure-scheduler.h"
+#include "ns3/olsb-admission-controller.h"
+#include "ns3/olsb-link-lifetime-estimator.h"
+#include "ns3/olsb-location-table.h"
+#include "ns3/olsb-update-cache.h"
+#include "ns3/olsb-control-budget.h"
+#include "ns3/olsb-neighbor-table.h"
+#include "ns3/olsb-routing-protocol.h"
 
 using namespace ns3;
 
@@ -85,7 +111,7 @@ OlsbHeaderTestCase::DoRun ()
     hdr2.SetDstSeqno (4);
     hdr2.SetHopCount (1);
     packet->AddHeader (hdr2);
-    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 24, "001");
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 32, "001");
   }
 
   {
@@ -102,6 +128,331 @@ OlsbHeaderTestCase::DoRun ()
     NS_TEST_ASSERT_MSG_EQ (hdr1.GetDstSeqno (),2,"009");
     NS_TEST_ASSERT_MSG_EQ (hdr1.GetHopCount (),2,"010");
   }
+
+  {
+    olsb::OlsbHeader hdr;
+    hdr.SetDst (Ipv4Address ("10.1.1.3"));
+    hdr.SetEtx (250);
+    hdr.SetAirtime (1500);
+    hdr.SetFields (olsb::OlsbHeader::ETX | olsb::OlsbHeader::AIRTIME);
+    packet->AddHeader (hdr);
+    packet->AddHeader (olsb::RecordFieldsHeader (olsb::OlsbHeader::ETX | olsb::OlsbHeader::AIRTIME));
+    packet->AddHeader (olsb::TypeHeader (olsb::OLSB_RECORD_FIELDS));
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 27, "115");
+    olsb::TypeHeader typeHeader;
+    packet->RemoveHeader (typeHeader);
+    NS_TEST_ASSERT_MSG_EQ (typeHeader.Get (),olsb::OLSB_RECORD_FIELDS,"116");
+    olsb::RecordFieldsHeader fieldsHeader;
+    packet->RemoveHeader (fieldsHeader);
+    NS_TEST_ASSERT_MSG_EQ (fieldsHeader.IsValid (),true,"117");
+    olsb::OlsbHeader received;
+    received.SetFields (fieldsHeader.GetFields ());
+    packet->RemoveHeader (received);
+    NS_TEST_ASSERT_MSG_EQ (received.GetEtx (),250,"011");
+    NS_TEST_ASSERT_MSG_EQ (received.GetAirtime (),1500,"013");
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 0, "012");
+  }
+
+  {
+    olsb::BacklogHeader backlogHeader;
+    backlogHeader.SetBacklog (Ipv4Address ("10.1.1.2"),7);
+    backlogHeader.SetBacklog (Ipv4Address ("10.1.1.3"),1);
+    packet->AddHeader (backlogHeader);
+    packet->AddHeader (olsb::TypeHeader (olsb::OLSB_BACKLOG));
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 20, "014");
+    uint8_t marker = 0;
+    packet->CopyData (&marker,1);
+    NS_TEST_ASSERT_MSG_EQ (marker,olsb::TypeHeader::MARKER,"015");
+    olsb::TypeHeader typeHeader;
+    packet->RemoveHeader (typeHeader);
+    NS_TEST_ASSERT_MSG_EQ (typeHeader.IsValid (),true,"016");
+    NS_TEST_ASSERT_MSG_EQ (typeHeader.Get (),olsb::OLSB_BACKLOG,"017");
+    olsb::BacklogHeader received;
+    packet->RemoveHeader (received);
+    NS_TEST_ASSERT_MSG_EQ (received.GetBacklogs ().size (),2,"018");
+    NS_TEST_ASSERT_MSG_EQ (received.GetBacklogs ().find (Ipv4Address ("10.1.1.2"))->second,7,"019");
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 0, "020");
+  }
+
+  {
+    packet->AddHeader (olsb::OlsbHeader (Ipv4Address ("10.1.1.2"), 1, 2));
+    packet->AddHeader (olsb::PositionHeader (Vector (12.34, -5.5, 0), Vector (-1.25, 10, 0)));
+    packet->AddHeader (olsb::TypeHeader (olsb::OLSB_POSITION));
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 42, "021");
+    olsb::TypeHeader typeHeader;
+    packet->RemoveHeader (typeHeader);
+    NS_TEST_ASSERT_MSG_EQ (typeHeader.IsValid (),true,"022");
+    NS_TEST_ASSERT_MSG_EQ (typeHeader.Get (),olsb::OLSB_POSITION,"023");
+    olsb::PositionHeader positionHeader;
+    packet->RemoveHeader (positionHeader);
+    NS_TEST_ASSERT_MSG_EQ_TOL (positionHeader.GetPosition ().x,12.34,1e-9,"024");
+    NS_TEST_ASSERT_MSG_EQ_TOL (positionHeader.GetPosition ().y,-5.5,1e-9,"025");
+    NS_TEST_ASSERT_MSG_EQ_TOL (positionHeader.GetVelocity ().x,-1.25,1e-9,"026");
+    NS_TEST_ASSERT_MSG_EQ_TOL (positionHeader.GetVelocity ().y,10,1e-9,"027");
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 16, "028");
+    olsb::OlsbHeader record;
+    packet->RemoveHeader (record);
+  }
+
+  {
+    olsb::LocationHeader locationHeader;
+    locationHeader.SetLocation (Ipv4Address ("10.1.1.4"), Vector (250, -0.5, 0), MilliSeconds (1500));
+    packet->AddHeader (locationHeader);
+    packet->AddHeader (olsb::TypeHeader (olsb::OLSB_LOCATION));
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 24, "029");
+    olsb::TypeHeader typeHeader;
+    packet->RemoveHeader (typeHeader);
+    NS_TEST_ASSERT_MSG_EQ (typeHeader.Get (),olsb::OLSB_LOCATION,"030");
+    olsb::LocationHeader received;
+    packet->RemoveHeader (received);
+    NS_TEST_ASSERT_MSG_EQ (received.GetLocations ().size (),1,"031");
+    const olsb::LocationHeader::Record &record = received.GetLocations ().find (Ipv4Address ("10.1.1.4"))->second;
+    NS_TEST_ASSERT_MSG_EQ_TOL (record.position.x,250,1e-9,"032");
+    NS_TEST_ASSERT_MSG_EQ_TOL (record.position.y,-0.5,1e-9,"033");
+    NS_TEST_ASSERT_MSG_EQ (record.age,MilliSeconds (1500),"034");
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 0, "035");
+  }
+
+  {
+    olsb::CompactUpdateHeader compactHeader;
+    compactHeader.AddRecord (olsb::OlsbHeader (Ipv4Address ("10.1.1.7"), 3, 40, 2));
+    compactHeader.AddRecord (olsb::OlsbHeader (Ipv4Address ("10.1.1.2"), 1, 42, 2));
+    compactHeader.AddRecord (olsb::OlsbHeader (Ipv4Address ("10.1.1.3"), 300, 37, 2));
+    packet->AddHeader (compactHeader);
+    // 2 + count 1 + queue 1 + base address 4, then 3 bytes per record
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 17, "036");
+    olsb::CompactUpdateHeader received;
+    packet->RemoveHeader (received);
+    NS_TEST_ASSERT_MSG_EQ (received.IsValid (),true,"037");
+    NS_TEST_ASSERT_MSG_EQ (received.GetRecords ().size (),3,"038");
+    const olsb::OlsbHeader &first = received.GetRecords ()[0];
+    NS_TEST_ASSERT_MSG_EQ (first.GetDst (),Ipv4Address ("10.1.1.2"),"039");
+    NS_TEST_ASSERT_MSG_EQ (first.GetDstSeqno (),42,"040");
+    NS_TEST_ASSERT_MSG_EQ (first.GetQueueSize (),2,"041");
+    const olsb::OlsbHeader &second = received.GetRecords ()[1];
+    NS_TEST_ASSERT_MSG_EQ (second.GetDst (),Ipv4Address ("10.1.1.3"),"042");
+    NS_TEST_ASSERT_MSG_EQ (second.GetHopCount (),255,"043");
+    NS_TEST_ASSERT_MSG_EQ (second.GetDstSeqno (),37,"044");
+    NS_TEST_ASSERT_MSG_EQ (received.GetRecords ()[2].GetDst (),Ipv4Address ("10.1.1.7"),"045");
+    NS_TEST_ASSERT_MSG_EQ (received.GetRecords ()[2].GetDstSeqno (),40,"046");
+
+    olsb::CompactUpdateHeader withMetrics;
+    withMetrics.AddRecord (olsb::OlsbHeader (Ipv4Address ("10.1.1.2"), 1, 2, 0, 100, 1500));
+    withMetrics.AddRecord (olsb::OlsbHeader (Ipv4Address ("10.1.1.3"), 2, 2, 9, 250, 0));
+    packet->AddHeader (withMetrics);
+    packet->RemoveHeader (received);
+    NS_TEST_ASSERT_MSG_EQ (received.GetRecords ()[0].GetEtx (),100,"047");
+    NS_TEST_ASSERT_MSG_EQ (received.GetRecords ()[0].GetAirtime (),1500,"048");
+    NS_TEST_ASSERT_MSG_EQ (received.GetRecords ()[1].GetQueueSize (),9,"049");
+    NS_TEST_ASSERT_MSG_EQ (received.GetRecords ()[1].GetAirtime (),0,"050");
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 0, "051");
+  }
+
+  {
+    packet->AddHeader (olsb::TypeHeader (olsb::OLSB_FULL_REQUEST));
+    olsb::TypeHeader typeHeader;
+    packet->RemoveHeader (typeHeader);
+    NS_TEST_ASSERT_MSG_EQ (typeHeader.IsValid (),true,"052");
+    NS_TEST_ASSERT_MSG_EQ (typeHeader.Get (),olsb::OLSB_FULL_REQUEST,"053");
+  }
+
+  {
+    olsb::OlsbHeader hdr1 (Ipv4Address ("10.1.1.2"), 1, 2);
+    uint8_t fields = olsb::OlsbHeader::ETX | olsb::OlsbHeader::AIRTIME;
+    hdr1.SetFields (fields);
+    packet->AddHeader (hdr1);
+    olsb::OlsbHeader hdr2 (Ipv4Address ("10.1.1.3"), 2, 4, 5, 250, 1500);
+    hdr2.SetFields (fields);
+    packet->AddHeader (hdr2);
+    std::vector<uint8_t> payload (packet->GetSize ());
+    packet->CopyData (&payload[0],payload.size ());
+    std::vector<olsb::OlsbHeader> records;
+    bool decoded = olsb::OlsbHeader::DeserializeRecords (&payload[0],payload.size (),fields,records);
+    NS_TEST_ASSERT_MSG_EQ (decoded,true,"054");
+    NS_TEST_ASSERT_MSG_EQ (records.size (),2,"055");
+    NS_TEST_ASSERT_MSG_EQ (records[0].GetDst (),Ipv4Address ("10.1.1.3"),"056");
+    NS_TEST_ASSERT_MSG_EQ (records[0].GetDstSeqno (),4,"057");
+    NS_TEST_ASSERT_MSG_EQ (records[0].GetQueueSize (),5,"058");
+    NS_TEST_ASSERT_MSG_EQ (records[0].GetEtx (),250,"118");
+    NS_TEST_ASSERT_MSG_EQ (records[0].GetAirtime (),1500,"059");
+    NS_TEST_ASSERT_MSG_EQ (records[1].GetDst (),Ipv4Address ("10.1.1.2"),"060");
+    NS_TEST_ASSERT_MSG_EQ (records[1].GetHopCount (),1,"061");
+    decoded = olsb::OlsbHeader::DeserializeRecords (&payload[0],payload.size () - 1,fields,records);
+    NS_TEST_ASSERT_MSG_EQ (decoded,false,"062");
+    NS_TEST_ASSERT_MSG_EQ (records.size (),2,"063");
+    packet->RemoveAtStart (packet->GetSize ());
+  }
+
+  {
+    std::map<Ipv4Address, uint32_t> mine, theirs;
+    mine[Ipv4Address ("10.1.1.2")] = 2;
+    mine[Ipv4Address ("10.1.1.3")] = 4;
+    mine[Ipv4Address ("10.1.1.4")] = 6;
+    mine[Ipv4Address ("10.1.1.5")] = 8;
+    theirs = mine;
+    olsb::DigestHeader digestHeader;
+    digestHeader.SetRoutes (mine,2);
+    NS_TEST_ASSERT_MSG_EQ (digestHeader.GetRangeCount (),2,"064");
+    packet->AddHeader (digestHeader);
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (),18,"065");
+    olsb::DigestHeader received;
+    packet->RemoveHeader (received);
+    std::vector<olsb::AddressRange> ranges;
+    received.GetDifferingRanges (theirs,ranges);
+    NS_TEST_ASSERT_MSG_EQ (ranges.size (),0,"066");
+    theirs[Ipv4Address ("10.1.1.5")] = 10;
+    received.GetDifferingRanges (theirs,ranges);
+    NS_TEST_ASSERT_MSG_EQ (ranges.size (),1,"067");
+    NS_TEST_ASSERT_MSG_EQ (ranges[0].first,Ipv4Address ("10.1.1.4"),"068");
+    NS_TEST_ASSERT_MSG_EQ (ranges[0].second,Ipv4Address ("255.255.255.255"),"069");
+
+    olsb::PullHeader pullHeader;
+    pullHeader.AddRange (ranges[0]);
+    packet->AddHeader (pullHeader);
+    olsb::PullHeader pulled;
+    packet->RemoveHeader (pulled);
+    NS_TEST_ASSERT_MSG_EQ (pulled.GetRanges ().size (),1,"070");
+    NS_TEST_ASSERT_MSG_EQ (pulled.Contains (Ipv4Address ("10.1.1.5")),true,"071");
+    NS_TEST_ASSERT_MSG_EQ (pulled.Contains (Ipv4Address ("10.1.1.3")),false,"072");
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (),0,"073");
+  }
+
+  {
+    olsb::HelloHeader helloHeader;
+    helloHeader.AddNeighbor (Ipv4Address ("10.1.1.2"));
+    helloHeader.AddNeighbor (Ipv4Address ("10.1.1.3"));
+    packet->AddHeader (helloHeader);
+    packet->AddHeader (olsb::TypeHeader (olsb::OLSB_HELLO));
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (),12,"074");
+    olsb::TypeHeader typeHeader;
+    packet->RemoveHeader (typeHeader);
+    NS_TEST_ASSERT_MSG_EQ (typeHeader.Get (),olsb::OLSB_HELLO,"075");
+    olsb::HelloHeader received;
+    packet->RemoveHeader (received);
+    NS_TEST_ASSERT_MSG_EQ (received.GetNeighbors ().size (),2,"076");
+    NS_TEST_ASSERT_MSG_EQ (received.GetNeighbors ()[1],Ipv4Address ("10.1.1.3"),"077");
+  }
+
+  {
+    olsb::BacklogHeader backlogHeader;
+    backlogHeader.SetBacklog (Ipv4Address ("10.1.1.2"),7);
+    backlogHeader.SetBacklog (Ipv4Address ("10.1.1.3"),1);
+    packet->AddHeader (backlogHeader);
+    Ptr<Packet> truncated = packet->CreateFragment (0,packet->GetSize () - 1);
+    olsb::BacklogHeader received;
+    NS_TEST_ASSERT_MSG_EQ (truncated->RemoveHeader (received),0,"078");
+    NS_TEST_ASSERT_MSG_EQ (truncated->GetSize (),17,"079");
+    packet->RemoveAtStart (packet->GetSize ());
+    uint8_t marker = olsb::TypeHeader::MARKER;
+    olsb::TypeHeader typeHeader;
+    NS_TEST_ASSERT_MSG_EQ (Create<Packet> (&marker,1)->RemoveHeader (typeHeader),0,"080");
+    NS_TEST_ASSERT_MSG_EQ (typeHeader.IsValid (),false,"081");
+  }
+
+  {
+    packet->AddHeader (olsb::PositionHeader (Vector (12.34, -5.5, 0), Vector (-1.25, 10, 0)));
+    Ptr<Packet> truncated = packet->CreateFragment (0,packet->GetSize () - 1);
+    olsb::PositionHeader received;
+    NS_TEST_ASSERT_MSG_EQ (truncated->RemoveHeader (received),0,"082");
+    packet->RemoveAtStart (packet->GetSize ());
+  }
+
+  {
+    olsb::LocationHeader locationHeader;
+    locationHeader.SetLocation (Ipv4Address ("10.1.1.4"), Vector (250, -0.5, 0), MilliSeconds (1500));
+    packet->AddHeader (locationHeader);
+    Ptr<Packet> truncated = packet->CreateFragment (0,packet->GetSize () - 1);
+    olsb::LocationHeader received;
+    NS_TEST_ASSERT_MSG_EQ (truncated->RemoveHeader (received),0,"083");
+    NS_TEST_ASSERT_MSG_EQ (received.GetLocations ().size (),0,"084");
+    packet->RemoveAtStart (packet->GetSize ());
+  }
+
+  {
+    olsb::CompactUpdateHeader compactHeader;
+    compactHeader.AddRecord (olsb::OlsbHeader (Ipv4Address ("10.1.1.2"), 1, 2, 0, 100, 1500));
+    compactHeader.AddRecord (olsb::OlsbHeader (Ipv4Address ("10.1.1.3"), 2, 2, 9, 250, 0));
+    packet->AddHeader (compactHeader);
+    olsb::CompactUpdateHeader received;
+    for (uint32_t size = 0; size < packet->GetSize (); size++)
+      {
+        Ptr<Packet> truncated = packet->CreateFragment (0,size);
+        NS_TEST_ASSERT_MSG_EQ (truncated->RemoveHeader (received),0,"085");
+        NS_TEST_ASSERT_MSG_EQ (received.GetRecords ().size (),0,"086");
+      }
+    packet->RemoveAtStart (packet->GetSize ());
+  }
+
+  {
+    packet->AddHeader (olsb::FullUpdateHeader (513,2,3));
+    packet->AddHeader (olsb::TypeHeader (olsb::OLSB_FULL_UPDATE));
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (),6,"087");
+    olsb::TypeHeader typeHeader;
+    packet->RemoveHeader (typeHeader);
+    NS_TEST_ASSERT_MSG_EQ (typeHeader.Get (),olsb::OLSB_FULL_UPDATE,"088");
+    Ptr<Packet> truncated = packet->CreateFragment (0,packet->GetSize () - 1);
+    olsb::FullUpdateHeader received;
+    NS_TEST_ASSERT_MSG_EQ (truncated->RemoveHeader (received),0,"089");
+    packet->RemoveHeader (received);
+    NS_TEST_ASSERT_MSG_EQ (received.GetUpdateId (),513,"090");
+    NS_TEST_ASSERT_MSG_EQ ((uint32_t) received.GetFragment (),2,"091");
+    NS_TEST_ASSERT_MSG_EQ ((uint32_t) received.GetFragmentCount (),3,"092");
+    NS_TEST_ASSERT_MSG_EQ (packet->GetSize (),0,"093");
+  }
+
+  {
+    olsb::CompactUpdateHeader compactHeader;
+    olsb::CompactUpdateSizer compactSize;
+    NS_TEST_ASSERT_MSG_EQ (compactSize.GetSize (),compactHeader.GetSerializedSize (),"094");
+    // Out of address order, with the queue size, ETX and airtime each turning their field on
+    std::vector<olsb::OlsbHeader> records;
+    records.push_back (olsb::OlsbHeader (Ipv4Address ("10.1.1.9"), 1, 40, 3, 0, 0));
+    records.push_back (olsb::OlsbHeader (Ipv4Address ("10.1.1.2"), 2, 2, 3, 0, 0));
+    records.push_back (olsb::OlsbHeader (Ipv4Address ("10.1.200.5"), 3, 300, 3, 250, 0));
+    records.push_back (olsb::OlsbHeader (Ipv4Address ("10.1.1.2"), 2, 4, 500, 100, 0));
+    records.push_back (olsb::OlsbHeader (Ipv4Address ("10.1.1.1"), 1, 8, 3, 0, 120000));
+    for (std::vector<olsb::OlsbHeader>::const_iterator r = records.begin (); r != records.end (); ++r)
+      {
+        uint32_t sizeWith = compactSize.GetSizeWith (*r);
+        compactHeader.AddRecord (*r);
+        compactSize.AddRecord (*r);
+        NS_TEST_ASSERT_MSG_EQ (sizeWith,compactHeader.GetSerializedSize (),"095");
+        NS_TEST_ASSERT_MSG_EQ (compactSize.GetSize (),compactHeader.GetSerializedSize (),"096");
+      }
+  }
+
+  {
+    std::map<Ipv4Address, uint32_t> seqnos;
+    seqnos[Ipv4Address ("10.1.1.2")] = 2;
+    seqnos[Ipv4Address ("10.1.1.9")] = 4;
+    olsb::DigestHeader digestHeader;
+    digestHeader.SetRoutes (seqnos,2);
+    packet->AddHeader (digestHeader);
+    Ptr<Packet> truncated = packet->CreateFragment (0,packet->GetSize () - 1);
+    olsb::DigestHeader receivedDigest;
+    NS_TEST_ASSERT_MSG_EQ (truncated->RemoveHeader (receivedDigest),0,"097");
+    packet->RemoveAtStart (packet->GetSize ());
+    olsb::PullHeader pullHeader;
+    pullHeader.AddRange (olsb::AddressRange (Ipv4Address ("10.1.1.1"), Ipv4Address ("10.1.1.5")));
+    packet->AddHeader (pullHeader);
+    truncated = packet->CreateFragment (0,packet->GetSize () - 1);
+    olsb::PullHeader receivedPull;
+    NS_TEST_ASSERT_MSG_EQ (truncated->RemoveHeader (receivedPull),0,"098");
+    NS_TEST_ASSERT_MSG_EQ (receivedPull.GetRanges ().size (),0,"099");
+    packet->RemoveAtStart (packet->GetSize ());
+  }
+
+  {
+    olsb::HelloHeader helloHeader;
+    helloHeader.AddNeighbor (Ipv4Address ("10.1.1.2"));
+    helloHeader.AddNeighbor (Ipv4Address ("10.1.1.3"));
+    packet->AddHeader (helloHeader);
+    Ptr<Packet> truncated = packet->CreateFragment (0,packet->GetSize () - 1);
+    olsb::HelloHeader received;
+    NS_TEST_ASSERT_MSG_EQ (truncated->RemoveHeader (received),0,"100");
+    NS_TEST_ASSERT_MSG_EQ (received.GetNeighbors ().size (),0,"101");
+    packet->RemoveAtStart (packet->GetSize ());
+  }
 }
 
 /**
@@ -200,6 +551,1002 @@ OlsbTableTestCase::DoRun ()
     NS_TEST_ASSERT_MSG_EQ (rEntry.GetInterface ().GetBroadcast (),Ipv4Address ("10.1.1.255"),"111");
     NS_TEST_ASSERT_MSG_EQ (rtable.RoutingTableSize (),4,"Rtable size incorrect");
   }
+  {
+    // Both neighbors advertise a route to 10.1.1.4, the candidates are kept apart from the routes
+    rtable.Setholddowntime (Seconds (45));
+    olsb::RoutingTableEntry viaFirst (dev, Ipv4Address ("10.1.1.4"), 2,
+                                      Ipv4InterfaceAddress (Ipv4Address ("10.1.1.1"), Ipv4Mask ("255.255.255.0")),
+                                      2, 7, Ipv4Address ("10.1.1.2"));
+    olsb::RoutingTableEntry viaSecond (dev, Ipv4Address ("10.1.1.4"), 2,
+                                       Ipv4InterfaceAddress (Ipv4Address ("10.1.1.1"), Ipv4Mask ("255.255.255.0")),
+                                       2, 1, Ipv4Address ("10.1.1.3"));
+    rtable.UpdateCandidate (viaFirst);
+    rtable.UpdateCandidate (viaSecond);
+    viaSecond.SetQueueSize (3);
+    rtable.UpdateCandidate (viaSecond);
+    std::map<Ipv4Address, olsb::RoutingTableEntry> candidates;
+    rtable.GetCandidates (Ipv4Address ("10.1.1.4"), candidates);
+    NS_TEST_EXPECT_MSG_EQ (candidates.size (),2,"one candidate per neighbor");
+    NS_TEST_EXPECT_MSG_EQ (candidates[Ipv4Address ("10.1.1.3")].GetQueueSize (),3,"latest advertisement kept");
+    rtable.DeleteCandidate (Ipv4Address ("10.1.1.4"), Ipv4Address ("10.1.1.2"));
+    rtable.GetCandidates (Ipv4Address ("10.1.1.4"), candidates);
+    NS_TEST_EXPECT_MSG_EQ (candidates.size (),1,"candidate deleted");
+    NS_TEST_EXPECT_MSG_EQ (rtable.RoutingTableSize (),4,"candidates are not routes");
+  }
+  {
+    // The latency class keeps a next hop of its own until the route goes away
+    Ipv4Address nextHop;
+    NS_TEST_EXPECT_MSG_EQ (rtable.LookupClassNextHop (Ipv4Address ("10.1.1.4"), olsb::LATENCY_CLASS, nextHop),false,
+                           "no class next hop yet");
+    rtable.SetClassNextHop (Ipv4Address ("10.1.1.4"), olsb::LATENCY_CLASS, Ipv4Address ("10.1.1.3"));
+    NS_TEST_EXPECT_MSG_EQ (rtable.LookupClassNextHop (Ipv4Address ("10.1.1.4"), olsb::LATENCY_CLASS, nextHop),true,
+                           "class next hop kept");
+    NS_TEST_EXPECT_MSG_EQ (nextHop,Ipv4Address ("10.1.1.3"),"class next hop");
+    NS_TEST_EXPECT_MSG_EQ (rtable.LookupClassNextHop (Ipv4Address ("10.1.1.4"), olsb::BULK_CLASS, nextHop),false,
+                           "classes are kept apart");
+    rtable.DeleteClassNextHop (Ipv4Address ("10.1.1.4"), olsb::LATENCY_CLASS);
+    NS_TEST_EXPECT_MSG_EQ (rtable.LookupClassNextHop (Ipv4Address ("10.1.1.4"), olsb::LATENCY_CLASS, nextHop),false,
+                           "class next hop deleted");
+    rtable.SetClassNextHop (Ipv4Address ("10.1.1.4"), olsb::LATENCY_CLASS, Ipv4Address ("10.1.1.3"));
+    rtable.DeleteRoute (Ipv4Address ("10.1.1.4"));
+    NS_TEST_EXPECT_MSG_EQ (rtable.LookupClassNextHop (Ipv4Address ("10.1.1.4"), olsb::LATENCY_CLASS, nextHop),false,
+                           "class next hop deleted with the route");
+  }
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB packet queue tests (per destination buckets and limits)
+ */
+class OlsbPacketQueueTestCase : public TestCase
+{
+public:
+  OlsbPacketQueueTestCase ();
+  ~OlsbPacketQueueTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbPacketQueueTestCase::OlsbPacketQueueTestCase ()
+  : TestCase ("Olsb packet queue test case")
+{
+}
+OlsbPacketQueueTestCase::~OlsbPacketQueueTestCase ()
+{
+}
+void
+OlsbPacketQueueTestCase::DoRun ()
+{
+  olsb::PacketQueue queue;
+  queue.SetMaxQueueLen (3);
+  queue.SetMaxPacketsPerDst (2);
+  queue.SetQueueTimeout (Seconds (30));
+
+  Ipv4Header h1;
+  h1.SetDestination (Ipv4Address ("10.1.1.2"));
+  Ipv4Header h2;
+  h2.SetDestination (Ipv4Address ("10.1.1.3"));
+  Ptr<Packet> p1 = Create<Packet> ();
+  Ptr<Packet> p2 = Create<Packet> ();
+  Ptr<Packet> p3 = Create<Packet> ();
+  Ptr<Packet> p4 = Create<Packet> ();
+
+  olsb::QueueEntry e1 (p1, h1);
+  NS_TEST_EXPECT_MSG_EQ (queue.Enqueue (e1), true, "enqueue first packet");
+  NS_TEST_EXPECT_MSG_EQ (queue.Enqueue (e1), false, "duplicate packet is rejected");
+  olsb::QueueEntry e2 (p2, h1);
+  NS_TEST_EXPECT_MSG_EQ (queue.Enqueue (e2), true, "enqueue second packet");
+  olsb::QueueEntry e3 (p3, h1);
+  NS_TEST_EXPECT_MSG_EQ (queue.Enqueue (e3), false, "per destination limit");
+  olsb::QueueEntry e4 (p4, h2);
+  NS_TEST_EXPECT_MSG_EQ (queue.Enqueue (e4), true, "other destination has its own bucket");
+  NS_TEST_EXPECT_MSG_EQ (queue.GetSize (), 3, "queue size");
+  NS_TEST_EXPECT_MSG_EQ (queue.GetCountForPacketsWithDst (Ipv4Address ("10.1.1.2")), 2, "bucket size");
+
+  olsb::QueueEntry out;
+  NS_TEST_EXPECT_MSG_EQ (queue.Dequeue (Ipv4Address ("10.1.1.2"), out), true, "dequeue");
+  NS_TEST_EXPECT_MSG_EQ (out.GetPacket ()->GetUid (), p1->GetUid (), "buckets are FIFO");
+  NS_TEST_EXPECT_MSG_EQ (queue.Enqueue (e3), true, "room after dequeue");
+  NS_TEST_EXPECT_MSG_EQ (queue.DequeueLast (Ipv4Address ("10.1.1.2"), out), true, "dequeue last");
+  NS_TEST_EXPECT_MSG_EQ (out.GetPacket ()->GetUid (), p3->GetUid (), "latest packet");
+  std::vector<Ipv4Address> dsts;
+  queue.GetDestinations (dsts);
+  NS_TEST_EXPECT_MSG_EQ (dsts.size (), 2, "destinations");
+  queue.DropPacketWithDst (Ipv4Address ("10.1.1.2"));
+  NS_TEST_EXPECT_MSG_EQ (queue.Find (Ipv4Address ("10.1.1.2")), false, "bucket dropped");
+  NS_TEST_EXPECT_MSG_EQ (queue.Find (Ipv4Address ("10.1.1.3")), true, "other bucket kept");
+  NS_TEST_EXPECT_MSG_EQ (queue.GetSize (), 1, "queue size after drop");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB backlog monitor tests (queue metric sources, unknown devices and reconciliation)
+ */
+class OlsbBacklogMonitorTestCase : public TestCase
+{
+public:
+  OlsbBacklogMonitorTestCase ();
+  ~OlsbBacklogMonitorTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbBacklogMonitorTestCase::OlsbBacklogMonitorTestCase ()
+  : TestCase ("Olsb backlog monitor test case")
+{
+}
+OlsbBacklogMonitorTestCase::~OlsbBacklogMonitorTestCase ()
+{
+}
+void
+OlsbBacklogMonitorTestCase::DoRun ()
+{
+  // A Wi-Fi device with a queue disc and a MAC queue, and a device with a queue disc only
+  Ptr<Node> node = CreateObject<Node> ();
+  YansWifiPhyHelper phy;
+  phy.SetChannel (YansWifiChannelHelper::Default ().Create ());
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  WifiHelper wifi;
+  NetDeviceContainer devices = wifi.Install (phy, mac, node);
+  Ptr<SimpleNetDevice> simple = CreateObject<SimpleNetDevice> ();
+  node->AddDevice (simple);
+  devices.Add (simple);
+  InternetStackHelper stack;
+  stack.Install (node);
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc ("ns3::FifoQueueDisc");
+  QueueDiscContainer qdiscs = tch.Install (devices);
+  qdiscs.Get (0)->Initialize ();
+  qdiscs.Get (1)->Initialize ();
+  Ptr<NetDevice> wifiDev = devices.Get (0);
+  PointerValue txop;
+  DynamicCast<WifiNetDevice> (wifiDev)->GetMac ()->GetAttribute ("Txop", txop);
+  Ptr<WifiMacQueue> macQueue = txop.Get<Txop> ()->GetWifiMacQueue ();
+
+  olsb::BacklogMonitor monitor;
+  monitor.SetSource (olsb::QUEUE_DISC);
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetBacklogPackets (wifiDev), 0, "device not monitored");
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetDrainTime (wifiDev), Seconds (0), "no drain time of an unknown device");
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetDataRate (wifiDev), monitor.GetDefaultDataRate (), "default rate of an unknown device");
+
+  monitor.AddDevice (wifiDev);
+  monitor.AddDevice (simple);
+  // Resolving the queues connects the traces
+  monitor.GetBacklogPackets (wifiDev);
+  monitor.GetBacklogPackets (simple);
+  Ipv4Address dst ("10.1.1.9");
+  Ipv4Header header;
+  header.SetDestination (dst);
+  qdiscs.Get (0)->Enqueue (Create<Ipv4QueueDiscItem> (Create<Packet> (100), Address (), Ipv4L3Protocol::PROT_NUMBER, header));
+  qdiscs.Get (1)->Enqueue (Create<Ipv4QueueDiscItem> (Create<Packet> (100), Address (), Ipv4L3Protocol::PROT_NUMBER, header));
+  qdiscs.Get (1)->Enqueue (Create<Ipv4QueueDiscItem> (Create<Packet> (100), Address (), Ipv4L3Protocol::PROT_NUMBER, header));
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_DATA);
+  macQueue->Enqueue (Create<WifiMacQueueItem> (Create<Packet> (100), hdr));
+
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetBacklogPackets (wifiDev), 1, "queue disc");
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetBacklogPackets (dst), 3, "traced backlog of the queue discs");
+  monitor.SetSource (olsb::MAC_QUEUE);
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetBacklogPackets (wifiDev), 1, "MAC queue");
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetBacklogPackets (simple), 0, "no MAC queue");
+  monitor.SetSource (olsb::EGRESS);
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetBacklogPackets (wifiDev), 2, "queue disc and MAC queue");
+  monitor.SetSource (olsb::ROUTE_BUFFER);
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetBacklogPackets (wifiDev), 0, "egress queues not used");
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetEgressPackets (wifiDev), 2, "egress occupancy whatever the source");
+
+  // Once no monitored queue disc holds packets the traced backlog is reset, whatever waits in the MAC queue
+  monitor.SetSource (olsb::QUEUE_DISC);
+  qdiscs.Get (0)->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetBacklogPackets (dst), 2, "dequeue traced");
+  NS_TEST_EXPECT_MSG_NE (monitor.GetDrainTime (wifiDev, dst), Seconds (0), "backlog of the other device");
+  monitor.RemoveDevice (simple);
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetDrainTime (wifiDev, dst), Seconds (0), "reconciled with the queue discs");
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetBacklogPackets (dst), 0, "traced backlog reset");
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetEgressPackets (simple), 2, "egress occupancy of a device not monitored");
+
+  monitor.Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB link estimator tests (delivery ratio and ETX from periodic update gaps)
+ */
+class OlsbLinkEstimatorTestCase : public TestCase
+{
+public:
+  OlsbLinkEstimatorTestCase ();
+  ~OlsbLinkEstimatorTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbLinkEstimatorTestCase::OlsbLinkEstimatorTestCase ()
+  : TestCase ("Olsb link estimator test case")
+{
+}
+OlsbLinkEstimatorTestCase::~OlsbLinkEstimatorTestCase ()
+{
+}
+void
+OlsbLinkEstimatorTestCase::DoRun ()
+{
+  olsb::LinkEstimator estimator;
+  Ipv4Address neighbor ("10.1.1.2");
+  NS_TEST_EXPECT_MSG_EQ (estimator.GetEtx (neighbor), olsb::LinkEstimator::ETX_SCALE, "unknown neighbor");
+
+  estimator.NotifyUpdate (neighbor, 2);
+  estimator.NotifyUpdate (neighbor, 4);
+  NS_TEST_EXPECT_MSG_EQ (estimator.GetEtx (neighbor), olsb::LinkEstimator::ETX_SCALE, "no loss");
+  // The update with sequence number 6 was lost
+  estimator.NotifyUpdate (neighbor, 8);
+  estimator.NotifyUpdate (neighbor, 8);
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimator.GetDeliveryRatio (neighbor), 0.75, 1e-9, "one of four updates lost");
+  NS_TEST_EXPECT_MSG_EQ (estimator.GetEtx (neighbor), 178, "ETX is 1 / (d * d)");
+
+  estimator.DeleteNeighbor (neighbor);
+  NS_TEST_EXPECT_MSG_EQ (estimator.GetEtx (neighbor), olsb::LinkEstimator::ETX_SCALE, "neighbor forgotten");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB airtime estimator tests (ETT from the rate of transmitted frames, fallback rate)
+ */
+class OlsbAirtimeEstimatorTestCase : public TestCase
+{
+public:
+  OlsbAirtimeEstimatorTestCase ();
+  ~OlsbAirtimeEstimatorTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbAirtimeEstimatorTestCase::OlsbAirtimeEstimatorTestCase ()
+  : TestCase ("Olsb airtime estimator test case")
+{
+}
+OlsbAirtimeEstimatorTestCase::~OlsbAirtimeEstimatorTestCase ()
+{
+}
+void
+OlsbAirtimeEstimatorTestCase::DoRun ()
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  MobilityHelper mobility;
+  Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+  positions->Add (Vector (0, 0, 0));
+  positions->Add (Vector (5, 0, 0));
+  mobility.SetPositionAllocator (positions);
+  mobility.Install (nodes);
+  YansWifiPhyHelper phy;
+  phy.SetChannel (YansWifiChannelHelper::Default ().Create ());
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_STANDARD_80211b);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager", "DataMode", StringValue ("DsssRate2Mbps"),
+                                "ControlMode", StringValue ("DsssRate1Mbps"));
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+  Mac48Address peer = Mac48Address::ConvertFrom (devices.Get (1)->GetAddress ());
+
+  olsb::AirtimeEstimator estimator;
+  estimator.SetReferenceSize (1500);
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimator.GetEtt (peer, DataRate ("12Mbps")).GetSeconds (), 0.001, 1e-9,
+                             "fallback rate without losses");
+  NS_TEST_EXPECT_MSG_EQ (estimator.GetEtt (peer, DataRate (0)), Time (0), "no rate known");
+  // Without an IPv4 stack the neighbor address cannot be resolved
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimator.GetEtt (devices.Get (0), Ipv4Address ("10.1.1.2"), DataRate ("12Mbps")).GetSeconds (),
+                             0.001, 1e-9, "unresolved neighbor");
+
+  estimator.AddDevice (devices.Get (0));
+  Simulator::Schedule (Seconds (1), &NetDevice::Send, devices.Get (0), Create<Packet> (1000), Address (peer), 0x0800);
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  // 1500 bytes at 2 Mbps, the frame was acknowledged
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimator.GetEtt (peer, DataRate ("12Mbps")).GetSeconds (), 0.006, 1e-9,
+                             "rate of the transmitted frame");
+  estimator.Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB link lifetime estimator tests (time until a neighbor leaves the transmission range)
+ */
+class OlsbLinkLifetimeEstimatorTestCase : public TestCase
+{
+public:
+  OlsbLinkLifetimeEstimatorTestCase ();
+  ~OlsbLinkLifetimeEstimatorTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbLinkLifetimeEstimatorTestCase::OlsbLinkLifetimeEstimatorTestCase ()
+  : TestCase ("Olsb link lifetime estimator test case")
+{
+}
+OlsbLinkLifetimeEstimatorTestCase::~OlsbLinkLifetimeEstimatorTestCase ()
+{
+}
+void
+OlsbLinkLifetimeEstimatorTestCase::DoRun ()
+{
+  olsb::LinkLifetimeEstimator estimator;
+  estimator.SetRange (250);
+  Vector origin (0, 0, 0);
+  Ipv4Address leaving ("10.1.1.2");
+  Ipv4Address crossing ("10.1.1.3");
+  Ipv4Address still ("10.1.1.4");
+  Ipv4Address away ("10.1.1.5");
+  NS_TEST_EXPECT_MSG_EQ (estimator.GetLinkLifetime (leaving, origin, origin), Time::Max (), "unknown neighbor");
+
+  estimator.UpdateNeighbor (leaving, Vector (100, 0, 0), Vector (10, 0, 0));
+  estimator.UpdateNeighbor (crossing, Vector (100, 0, 0), Vector (-10, 0, 0));
+  estimator.UpdateNeighbor (still, Vector (0, 100, 0), origin);
+  estimator.UpdateNeighbor (away, Vector (300, 0, 0), origin);
+  NS_TEST_EXPECT_MSG_EQ (estimator.GetLinkLifetime (leaving, origin, origin), Seconds (15), "leaves at 250 m");
+  NS_TEST_EXPECT_MSG_EQ (estimator.GetLinkLifetime (crossing, origin, origin), Seconds (35), "passes by, then leaves");
+  NS_TEST_EXPECT_MSG_EQ (estimator.GetLinkLifetime (still, origin, origin), Time::Max (), "no relative motion");
+  NS_TEST_EXPECT_MSG_EQ (estimator.GetLinkLifetime (still, origin, Vector (0, -5, 0)), Seconds (30),
+                         "this node moves away");
+  NS_TEST_EXPECT_MSG_EQ (estimator.GetLinkLifetime (away, origin, origin), Seconds (0), "out of range");
+
+  estimator.DeleteNeighbor (leaving);
+  NS_TEST_EXPECT_MSG_EQ (estimator.GetLinkLifetime (leaving, origin, origin), Time::Max (), "neighbor forgotten");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB location table tests (most recent positions and greedy neighbor choice)
+ */
+class OlsbLocationTableTestCase : public TestCase
+{
+public:
+  OlsbLocationTableTestCase ();
+  ~OlsbLocationTableTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbLocationTableTestCase::OlsbLocationTableTestCase ()
+  : TestCase ("Olsb location table test case")
+{
+}
+OlsbLocationTableTestCase::~OlsbLocationTableTestCase ()
+{
+}
+void
+OlsbLocationTableTestCase::DoRun ()
+{
+  olsb::LocationTable table;
+  table.SetLifetime (Seconds (60));
+  Ipv4Address dst ("10.1.1.9");
+  Ipv4Address east ("10.1.1.2");
+  Ipv4Address west ("10.1.1.3");
+  Ipv4Address far ("10.1.1.4");
+  Vector position;
+  NS_TEST_EXPECT_MSG_EQ (table.Lookup (dst, position), false, "unknown node");
+
+  table.Update (dst, Vector (1000, 0, 0), Seconds (5));
+  table.Update (dst, Vector (900, 0, 0), Seconds (10));
+  NS_TEST_EXPECT_MSG_EQ (table.Lookup (dst, position), true, "known node");
+  NS_TEST_EXPECT_MSG_EQ_TOL (position.x, 1000, 1e-9, "older position ignored");
+  table.Update (dst, Vector (1100, 0, 0), Seconds (1));
+  table.Lookup (dst, position);
+  NS_TEST_EXPECT_MSG_EQ_TOL (position.x, 1100, 1e-9, "newer position kept");
+  table.Update (far, Vector (0, 0, 0), Seconds (70));
+  NS_TEST_EXPECT_MSG_EQ (table.Lookup (far, position), false, "expired position");
+
+  table.Update (east, Vector (200, 0, 0), Seconds (0));
+  table.Update (west, Vector (-200, 0, 0), Seconds (0));
+  std::vector<Ipv4Address> neighbors;
+  neighbors.push_back (east);
+  neighbors.push_back (west);
+  neighbors.push_back (far);
+  Ipv4Address nextHop;
+  NS_TEST_EXPECT_MSG_EQ (table.GetClosestNeighbor (Vector (0, 0, 0), Vector (1100, 0, 0), neighbors, nextHop), true,
+                         "progress towards the destination");
+  NS_TEST_EXPECT_MSG_EQ (nextHop, east, "closest neighbor");
+  NS_TEST_EXPECT_MSG_EQ (table.GetClosestNeighbor (Vector (300, 0, 0), Vector (1100, 0, 0), neighbors, nextHop), false,
+                         "no neighbor is closer than this node");
+
+  std::map<Ipv4Address, olsb::LocationTable::Location> locations;
+  table.GetLocations (locations);
+  NS_TEST_EXPECT_MSG_EQ (locations.size (), 3, "expired position left out");
+  table.Purge ();
+  locations.clear ();
+  table.GetLocations (locations);
+  NS_TEST_EXPECT_MSG_EQ (locations.size (), 3, "purge keeps live positions");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB update cache tests (records serialized once, updates shared between interfaces)
+ */
+class OlsbUpdateCacheTestCase : public TestCase
+{
+public:
+  OlsbUpdateCacheTestCase ();
+  ~OlsbUpdateCacheTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbUpdateCacheTestCase::OlsbUpdateCacheTestCase ()
+  : TestCase ("Olsb update cache test case")
+{
+}
+OlsbUpdateCacheTestCase::~OlsbUpdateCacheTestCase ()
+{
+}
+void
+OlsbUpdateCacheTestCase::DoRun ()
+{
+  olsb::UpdateCache cache;
+  std::vector<olsb::OlsbHeader> records;
+  records.push_back (olsb::OlsbHeader (Ipv4Address ("10.1.1.2"), 1, 2));
+  records.push_back (olsb::OlsbHeader (Ipv4Address ("10.1.1.3"), 2, 4, 5, 250, 1500));
+
+  Ptr<Packet> packet = cache.Build (records, olsb::FIXED_FORMAT);
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 51, "two fixed records with their ETX");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetMisses (), 2, "new records serialized");
+  olsb::TypeHeader typeHeader;
+  packet->RemoveHeader (typeHeader);
+  NS_TEST_EXPECT_MSG_EQ (typeHeader.Get (), olsb::OLSB_RECORD_FIELDS, "optional fields announced");
+  olsb::RecordFieldsHeader fieldsHeader;
+  packet->RemoveHeader (fieldsHeader);
+  std::vector<uint8_t> payload (packet->GetSize ());
+  packet->CopyData (&payload[0], payload.size ());
+  std::vector<olsb::OlsbHeader> decoded;
+  olsb::OlsbHeader::DeserializeRecords (&payload[0], payload.size (), fieldsHeader.GetFields (), decoded);
+  NS_TEST_ASSERT_MSG_EQ (decoded.size (), 2, "records decoded");
+  NS_TEST_EXPECT_MSG_EQ (decoded[0].GetDst (), Ipv4Address ("10.1.1.2"), "records kept in order");
+  NS_TEST_EXPECT_MSG_EQ (decoded[1].GetAirtime (), 1500, "metrics serialized");
+
+  cache.Build (records, olsb::FIXED_FORMAT);
+  NS_TEST_EXPECT_MSG_EQ (cache.GetMisses () + cache.GetHits (), 2, "same update shared, not rebuilt");
+
+  records[1].SetDstSeqno (6);
+  packet = cache.Build (records, olsb::FIXED_FORMAT);
+  NS_TEST_EXPECT_MSG_EQ (cache.GetHits (), 1, "unchanged record copied");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetMisses (), 3, "changed record serialized again");
+  packet->RemoveHeader (typeHeader);
+  packet->RemoveHeader (fieldsHeader);
+  packet->CopyData (&payload[0], payload.size ());
+  decoded.clear ();
+  olsb::OlsbHeader::DeserializeRecords (&payload[0], payload.size (), fieldsHeader.GetFields (), decoded);
+  NS_TEST_EXPECT_MSG_EQ (decoded[1].GetDstSeqno (), 6, "changed record advertised");
+
+  std::vector<olsb::OlsbHeader> plain;
+  plain.push_back (olsb::OlsbHeader (Ipv4Address ("10.1.1.4"), 1, 2));
+  plain.push_back (olsb::OlsbHeader (Ipv4Address ("10.1.1.5"), 2, 4, 5));
+  NS_TEST_EXPECT_MSG_EQ (olsb::UpdateCache ().Build (plain, olsb::FIXED_FORMAT)->GetSize (), 32,
+                         "records without optional fields keep the 16 byte format");
+
+  // A table of routes with nearby addresses and sequence numbers, in both formats
+  std::vector<olsb::OlsbHeader> table;
+  for (uint32_t k = 0; k < 50; k++)
+    {
+      table.push_back (olsb::OlsbHeader (Ipv4Address (Ipv4Address ("10.1.1.2").Get () + k), 1 + k % 4,
+                                         100 + 2 * (k * 37 % 50)));
+    }
+  uint32_t fixedSize = olsb::UpdateCache ().Build (table, olsb::FIXED_FORMAT)->GetSize ();
+  uint32_t compactSize = olsb::UpdateCache ().Build (table, olsb::COMPACT_FORMAT)->GetSize ();
+  NS_TEST_EXPECT_MSG_EQ (fixedSize, 50 * 16, "fixed format is the original record");
+  NS_TEST_EXPECT_MSG_LT (3 * compactSize, fixedSize, "compact format at least three times smaller");
+
+  packet = cache.Build (records, olsb::COMPACT_FORMAT);
+  packet->RemoveHeader (typeHeader);
+  NS_TEST_EXPECT_MSG_EQ (typeHeader.Get (), olsb::OLSB_COMPACT_UPDATE, "format changed, update rebuilt");
+
+  cache.Invalidate (Ipv4Address ("10.1.1.2"));
+  cache.Build (records, olsb::FIXED_FORMAT);
+  NS_TEST_EXPECT_MSG_EQ (cache.GetMisses (), 4, "record of a removed route serialized again");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetHits (), 2, "other records still copied");
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB control budget tests (token bucket and deferred records)
+ */
+class OlsbControlBudgetTestCase : public TestCase
+{
+public:
+  OlsbControlBudgetTestCase ();
+  ~OlsbControlBudgetTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbControlBudgetTestCase::OlsbControlBudgetTestCase ()
+  : TestCase ("Olsb control budget test case")
+{
+}
+OlsbControlBudgetTestCase::~OlsbControlBudgetTestCase ()
+{
+}
+void
+OlsbControlBudgetTestCase::DoRun ()
+{
+  olsb::ControlBudget budget;
+  NS_TEST_EXPECT_MSG_EQ (budget.IsLimited (), false, "no bound by default");
+  NS_TEST_EXPECT_MSG_EQ (budget.GetDelay (100000), Seconds (0), "unbounded traffic never waits");
+
+  budget.SetRate (1000);
+  budget.SetBurst (500);
+  budget.Reset ();
+  NS_TEST_EXPECT_MSG_EQ (budget.IsLimited (), true, "bounded");
+  NS_TEST_EXPECT_MSG_EQ_TOL (budget.GetAvailable (), 500, 1e-9, "starts full");
+  budget.Charge (700);
+  NS_TEST_EXPECT_MSG_EQ_TOL (budget.GetAvailable (), -200, 1e-9, "in debt");
+  NS_TEST_EXPECT_MSG_EQ (budget.GetSentBytes (), 700, "bytes counted");
+  NS_TEST_EXPECT_MSG_EQ (budget.GetDelay (300), MilliSeconds (500), "debt repaid first");
+
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (budget.GetAvailable (), 500, 1e-9, "refilled up to the burst size");
+  NS_TEST_EXPECT_MSG_EQ (budget.GetDelay (300), Seconds (0), "enough tokens");
+
+  budget.Defer (2, 3);
+  budget.Defer (3, 1);
+  budget.Defer (3, 2);
+  NS_TEST_EXPECT_MSG_EQ (budget.GetDeferred (1), 0, "nothing deferred");
+  NS_TEST_EXPECT_MSG_EQ (budget.GetDeferred (2), 3, "large changes deferred");
+  NS_TEST_EXPECT_MSG_EQ (budget.GetDeferred (3), 3, "other records deferred");
+  NS_TEST_EXPECT_MSG_EQ (budget.GetDeferred (7), 0, "unknown priority");
+  budget.Reset ();
+  NS_TEST_EXPECT_MSG_EQ (budget.GetDeferred (2), 0, "counters reset");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB neighbor table tests (bidirectional links and missed beacons)
+ */
+class OlsbNeighborTableTestCase : public TestCase
+{
+public:
+  OlsbNeighborTableTestCase ();
+  ~OlsbNeighborTableTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbNeighborTableTestCase::OlsbNeighborTableTestCase ()
+  : TestCase ("Olsb neighbor table test case")
+{
+}
+OlsbNeighborTableTestCase::~OlsbNeighborTableTestCase ()
+{
+}
+void
+OlsbNeighborTableTestCase::DoRun ()
+{
+  olsb::NeighborTable table;
+  table.SetHelloInterval (Seconds (1));
+  table.SetAllowedHelloLoss (2);
+  Ipv4Address both ("10.1.1.2");
+  Ipv4Address oneWay ("10.1.1.3");
+  table.Update (both, true);
+  table.Update (oneWay, false);
+  NS_TEST_EXPECT_MSG_EQ (table.IsNeighbor (oneWay), true, "heard");
+  NS_TEST_EXPECT_MSG_EQ (table.IsBidirectional (both), true, "hears this node");
+  NS_TEST_EXPECT_MSG_EQ (table.IsBidirectional (oneWay), false, "does not hear this node");
+  NS_TEST_EXPECT_MSG_EQ (table.IsNeighbor (Ipv4Address ("10.1.1.4")), false, "never heard");
+  std::vector<Ipv4Address> neighbors;
+  table.GetNeighbors (neighbors);
+  NS_TEST_EXPECT_MSG_EQ (neighbors.size (), 2, "both beaconed");
+
+  Simulator::Stop (Seconds (2.5));
+  Simulator::Run ();
+  table.Update (both, true);
+  std::vector<Ipv4Address> lost;
+  table.Purge (lost);
+  NS_TEST_EXPECT_MSG_EQ (lost.size (), 0, "two missed beacons are tolerated");
+
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  table.Purge (lost);
+  NS_TEST_ASSERT_MSG_EQ (lost.size (), 1, "third missed beacon");
+  NS_TEST_EXPECT_MSG_EQ (lost[0], oneWay, "silent neighbor lost");
+  NS_TEST_EXPECT_MSG_EQ (table.IsNeighbor (oneWay), false, "forgotten");
+  NS_TEST_EXPECT_MSG_EQ (table.IsNeighbor (both), true, "still beaconing");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB metric policy tests
+ */
+class OlsbMetricPolicyTestCase : public TestCase
+{
+public:
+  OlsbMetricPolicyTestCase ();
+  ~OlsbMetricPolicyTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbMetricPolicyTestCase::OlsbMetricPolicyTestCase ()
+  : TestCase ("Olsb metric policy test case")
+{
+}
+OlsbMetricPolicyTestCase::~OlsbMetricPolicyTestCase ()
+{
+}
+static bool
+PreferLowEtx (const olsb::RouteMetric &current, const olsb::RouteMetric &candidate)
+{
+  return candidate.etx < current.etx;
+}
+void
+OlsbMetricPolicyTestCase::DoRun ()
+{
+  // Candidate is one hop longer but much less loaded
+  olsb::RouteMetric current = { 2, 10, 200, 0 };
+  olsb::RouteMetric candidate = { 3, 2, 300, 0 };
+
+  olsb::MetricWeights weights = { 0.5, 0.5, 0, 0 };
+  Ptr<olsb::MetricPolicy> policy = olsb::CreateMetricPolicy (olsb::WEIGHTED, weights);
+  NS_TEST_EXPECT_MSG_EQ (policy->IsBetter (current, candidate), true, "weighted: backlog outweighs one hop");
+  NS_TEST_EXPECT_MSG_EQ (policy->IsBetter (candidate, current), false, "weighted: no switch back");
+  NS_TEST_EXPECT_MSG_EQ (policy->GetFields (), olsb::MetricPolicy::QUEUE, "weighted: only the backlog is advertised");
+  // Costs are 6 and 2.5
+  NS_TEST_EXPECT_MSG_EQ (policy->IsClearlyBetter (current, candidate, 3, 0), true, "absolute threshold cleared");
+  NS_TEST_EXPECT_MSG_EQ (policy->IsClearlyBetter (current, candidate, 4, 0), false, "absolute threshold");
+  NS_TEST_EXPECT_MSG_EQ (policy->IsClearlyBetter (current, candidate, 0, 0.5), true, "relative threshold cleared");
+  NS_TEST_EXPECT_MSG_EQ (policy->IsClearlyBetter (current, candidate, 0, 0.6), false, "relative threshold");
+
+  weights.queue = 0;
+  policy = olsb::CreateMetricPolicy (olsb::WEIGHTED, weights);
+  NS_TEST_EXPECT_MSG_NE (DynamicCast<olsb::HopOnlyPolicy> (policy), 0, "backpressure factor 0 picks the hop policy");
+  NS_TEST_EXPECT_MSG_EQ (policy->IsBetter (current, candidate), false, "hop only");
+  NS_TEST_EXPECT_MSG_EQ (policy->GetFields (), 0, "hop only advertises no optional field");
+
+  weights.hops = 0;
+  weights.queue = 1;
+  policy = olsb::CreateMetricPolicy (olsb::WEIGHTED, weights);
+  NS_TEST_EXPECT_MSG_NE (DynamicCast<olsb::QueueOnlyPolicy> (policy), 0, "shortest path factor 0 picks the backlog policy");
+  NS_TEST_EXPECT_MSG_EQ (policy->IsBetter (current, candidate), true, "queue only");
+
+  policy = olsb::CreateMetricPolicy (olsb::LEXICOGRAPHIC, weights);
+  NS_TEST_EXPECT_MSG_EQ (policy->IsBetter (current, candidate), false, "lexicographic: hops first");
+  candidate.hops = 2;
+  NS_TEST_EXPECT_MSG_EQ (policy->IsBetter (current, candidate), true, "lexicographic: backlog breaks ties");
+
+  policy = olsb::CreateMetricPolicy (olsb::CUSTOM, weights, MakeCallback (&PreferLowEtx), olsb::MetricPolicy::ETX);
+  NS_TEST_EXPECT_MSG_EQ (policy->IsBetter (current, candidate), false, "custom comparison");
+  NS_TEST_EXPECT_MSG_EQ (policy->GetFields (), olsb::MetricPolicy::ETX, "custom fields");
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB factor adaptation tests
+ */
+class OlsbFactorControllerTestCase : public TestCase
+{
+public:
+  OlsbFactorControllerTestCase ();
+  ~OlsbFactorControllerTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbFactorControllerTestCase::OlsbFactorControllerTestCase ()
+  : TestCase ("Olsb factor controller test case")
+{
+}
+OlsbFactorControllerTestCase::~OlsbFactorControllerTestCase ()
+{
+}
+void
+OlsbFactorControllerTestCase::DoRun ()
+{
+  olsb::FactorController controller;
+  controller.SetStep (0.1);
+  controller.SetShareBounds (0.2, 0.7);
+  controller.SetMaxRouteChangeRate (1);
+  controller.Reset (0.5, 0.5);
+
+  NS_TEST_EXPECT_MSG_EQ (controller.Update (Seconds (5), 0.01, 0, 0), true, "growing backlog");
+  NS_TEST_EXPECT_MSG_EQ_TOL (controller.GetBackpressureFactor (), 0.6, 1e-9, "one step towards backpressure");
+  NS_TEST_EXPECT_MSG_EQ_TOL (controller.GetShortestPathFactor (), 0.4, 1e-9, "the sum is kept");
+  controller.Update (Seconds (5), 0, 3, 0);
+  controller.Update (Seconds (5), 0, 3, 0);
+  NS_TEST_EXPECT_MSG_EQ_TOL (controller.GetBackpressureFactor (), 0.7, 1e-9, "upper bound");
+  NS_TEST_EXPECT_MSG_EQ (controller.Update (Seconds (5), 0, 3, 0), false, "no change at the bound");
+  controller.Update (Seconds (5), 0.01, 3, 6);
+  NS_TEST_EXPECT_MSG_EQ_TOL (controller.GetBackpressureFactor (), 0.6, 1e-9, "route oscillation wins over congestion");
+  controller.Update (Seconds (5), -0.01, 0, 0);
+  NS_TEST_EXPECT_MSG_EQ_TOL (controller.GetBackpressureFactor (), 0.55, 1e-9, "half step back when the load subsides");
+  NS_TEST_EXPECT_MSG_EQ (controller.Update (Seconds (5), 0, 0, 0), false, "steady state");
+  controller.SetDeadband (0.02);
+  NS_TEST_EXPECT_MSG_EQ (controller.Update (Seconds (5), 0.01, 0, 0), false, "growth within the deadband");
+  NS_TEST_EXPECT_MSG_EQ (controller.Update (Seconds (5), -0.01, 0, 0), false, "decrease within the deadband");
+  NS_TEST_EXPECT_MSG_EQ (controller.Update (Seconds (5), 0.03, 0, 0), true, "growth beyond the deadband");
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB backpressure scheduler tests (max-weight choice of commodity and neighbor)
+ */
+class OlsbBackpressureSchedulerTestCase : public TestCase
+{
+public:
+  OlsbBackpressureSchedulerTestCase ();
+  ~OlsbBackpressureSchedulerTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbBackpressureSchedulerTestCase::OlsbBackpressureSchedulerTestCase ()
+  : TestCase ("Olsb backpressure scheduler test case")
+{
+}
+OlsbBackpressureSchedulerTestCase::~OlsbBackpressureSchedulerTestCase ()
+{
+}
+void
+OlsbBackpressureSchedulerTestCase::DoRun ()
+{
+  olsb::BackpressureScheduler scheduler;
+  Ipv4Address a ("10.1.1.2");
+  Ipv4Address b ("10.1.1.3");
+  Ipv4Address d ("10.1.1.9");
+  std::map<Ipv4Address, uint32_t> advertised;
+  advertised[d] = 4;
+  scheduler.UpdateNeighborBacklog (a, advertised);
+  NS_TEST_EXPECT_MSG_EQ (scheduler.GetNeighborBacklog (a, d), 4, "advertised backlog");
+  NS_TEST_EXPECT_MSG_EQ (scheduler.GetNeighborBacklog (a, a), 0, "a destination has no backlog");
+  NS_TEST_EXPECT_MSG_EQ (scheduler.GetNeighborBacklog (b, d), 0, "unknown neighbor");
+
+  std::map<Ipv4Address, uint32_t> backlogs;
+  backlogs[d] = 4;
+  std::map<Ipv4Address, std::map<Ipv4Address, uint32_t> > distances;
+  distances[d][a] = 1;
+  distances[d][b] = 2;
+  Ipv4Address dst, neighbor;
+  NS_TEST_EXPECT_MSG_EQ (scheduler.Select (backlogs, distances, 0.5, 0.5, dst, neighbor), true, "positive weight");
+  NS_TEST_EXPECT_MSG_EQ (neighbor, b, "the backlog differential outweighs one extra hop");
+  NS_TEST_EXPECT_MSG_EQ (dst, d, "commodity");
+  scheduler.Select (backlogs, distances, 1, 0, dst, neighbor);
+  NS_TEST_EXPECT_MSG_EQ (neighbor, a, "shortest path only");
+
+  advertised[d] = 5;
+  scheduler.UpdateNeighborBacklog (b, advertised);
+  NS_TEST_EXPECT_MSG_EQ (scheduler.Select (backlogs, distances, 0, 1, dst, neighbor), false, "no positive differential");
+
+  backlogs[a] = 1;
+  distances[a][a] = 0;
+  NS_TEST_EXPECT_MSG_EQ (scheduler.Select (backlogs, distances, 0, 1, dst, neighbor), true, "neighbor destination");
+  NS_TEST_EXPECT_MSG_EQ (dst, a, "served commodity");
+  scheduler.Clear ();
+  NS_TEST_EXPECT_MSG_EQ (scheduler.GetNeighborBacklog (b, d), 0, "backlogs forgotten");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB admission control tests (drift-plus-penalty budget of local flows)
+ */
+class OlsbAdmissionControllerTestCase : public TestCase
+{
+public:
+  OlsbAdmissionControllerTestCase ();
+  ~OlsbAdmissionControllerTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbAdmissionControllerTestCase::OlsbAdmissionControllerTestCase ()
+  : TestCase ("Olsb admission controller test case")
+{
+}
+OlsbAdmissionControllerTestCase::~OlsbAdmissionControllerTestCase ()
+{
+}
+void
+OlsbAdmissionControllerTestCase::DoRun ()
+{
+  olsb::AdmissionController controller;
+  controller.SetUtilityWeight (10);
+  controller.SetMaxRate (100);
+  controller.SetInterval (MilliSeconds (100));
+  Ipv4Address d ("10.1.1.9");
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (controller.Admit (d), true, "full budget of a new flow");
+    }
+  NS_TEST_EXPECT_MSG_EQ (controller.Admit (d), false, "budget exhausted");
+
+  std::map<Ipv4Address, double> prices, rates;
+  prices[d] = 0;
+  controller.Update (prices, rates);
+  NS_TEST_EXPECT_MSG_EQ_TOL (rates[d], 100, 1e-9, "admitted rate");
+  NS_TEST_EXPECT_MSG_EQ_TOL (controller.GetVirtualQueue (d), 10, 1e-9, "virtual queue grows by the target");
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      controller.Admit (d);
+    }
+  prices[d] = 50;
+  controller.Update (prices, rates);
+  NS_TEST_EXPECT_MSG_EQ (controller.Admit (d), false, "congested flow is throttled");
+  controller.Update (prices, rates);
+  NS_TEST_EXPECT_MSG_EQ_TOL (rates[d], 0, 1e-9, "nothing admitted");
+  NS_TEST_EXPECT_MSG_EQ (controller.Admit (d), false, "still congested");
+  prices[d] = 5;
+  controller.Update (prices, rates);
+  NS_TEST_EXPECT_MSG_EQ (controller.Admit (d), true, "admitted again once the backlog drains");
+
+  controller.Update (prices, rates);
+  controller.Update (prices, rates);
+  std::vector<Ipv4Address> dsts;
+  controller.GetFlows (dsts);
+  NS_TEST_EXPECT_MSG_EQ (dsts.size (), 0, "idle flow forgotten");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup olsb-test
+ * \ingroup tests
+ *
+ * \brief OLSB routing protocol tests (attributes and counters)
+ */
+class OlsbRoutingProtocolTestCase : public TestCase
+{
+public:
+  OlsbRoutingProtocolTestCase ();
+  ~OlsbRoutingProtocolTestCase ();
+  virtual void
+  DoRun (void);
+};
+
+OlsbRoutingProtocolTestCase::OlsbRoutingProtocolTestCase ()
+  : TestCase ("Olsb routing protocol test case")
+{
+}
+OlsbRoutingProtocolTestCase::~OlsbRoutingProtocolTestCase ()
+{
+}
+void
+OlsbRoutingProtocolTestCase::DoRun ()
+{
+  Ptr<olsb::RoutingProtocol> protocol = CreateObject<olsb::RoutingProtocol> ();
+  NS_TEST_EXPECT_MSG_EQ (protocol->SetAttributeFailSafe ("MinTriggeredUpdateDelay", TimeValue (Seconds (0))), false,
+                         "a triggered update window of zero never grows");
+  NS_TEST_EXPECT_MSG_EQ (protocol->SetAttributeFailSafe ("MinTriggeredUpdateDelay", TimeValue (MicroSeconds (1))),
+                         true, "shortest triggered update window");
+  protocol->Dispose ();
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  SimpleNetDeviceHelper simple;
+  NetDeviceContainer devices = simple.Install (nodes);
+  OlsbHelper olsb;
+  // The first periodic update leaves an empty bucket in debt, so the triggered updates that follow wait
+  olsb.Set ("ControlDataRate", DataRateValue (DataRate ("8bps")));
+  olsb.Set ("ControlBurstSize", UintegerValue (0));
+  InternetStackHelper stack;
+  stack.SetRoutingHelper (olsb);
+  stack.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (devices);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<olsb::RoutingProtocol> routing =
+        DynamicCast<olsb::RoutingProtocol> (nodes.Get (i)->GetObject<Ipv4> ()->GetRoutingProtocol ());
+      NS_TEST_ASSERT_MSG_NE (routing, 0, "OLSB installed");
+      NS_TEST_EXPECT_MSG_GT (routing->GetControlBytesSent (), 0, "periodic updates charged to the budget");
+      NS_TEST_EXPECT_MSG_EQ (routing->GetDeferredRecords (1), 0, "withdrawals are never deferred");
+      NS_TEST_EXPECT_MSG_LT (routing->GetDeferredRecords (2), 2, "the route to the neighbor deferred once at most");
+    }
+  Simulator::Destroy ();
+
+  // a reaches d through b in two hops or through c and e in three; the latency class prefers the longer path
+  NodeContainer a, b, c, e, d;
+  a.Create (1);
+  b.Create (1);
+  c.Create (1);
+  e.Create (1);
+  d.Create (1);
+  NetDeviceContainer ab = simple.Install (NodeContainer (a,b));
+  NetDeviceContainer ac = simple.Install (NodeContainer (a,c));
+  NetDeviceContainer ce = simple.Install (NodeContainer (c,e));
+  NetDeviceContainer bed = simple.Install (NodeContainer (b,e,d));
+  OlsbHelper classes;
+  classes.Set ("TrafficClasses", BooleanValue (true));
+  classes.Set ("LatencyShortestPathFactor", DoubleValue (-1));
+  InternetStackHelper classStack;
+  classStack.SetRoutingHelper (classes);
+  classStack.Install (NodeContainer (a,b,c,e,d));
+  address.SetBase ("10.1.2.0", "255.255.255.0");
+  Ipv4InterfaceContainer abIfaces = address.Assign (ab);
+  address.SetBase ("10.1.3.0", "255.255.255.0");
+  Ipv4InterfaceContainer acIfaces = address.Assign (ac);
+  address.SetBase ("10.1.4.0", "255.255.255.0");
+  address.Assign (ce);
+  address.SetBase ("10.1.5.0", "255.255.255.0");
+  Ipv4InterfaceContainer bedIfaces = address.Assign (bed);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  Ptr<olsb::RoutingProtocol> routing =
+    DynamicCast<olsb::RoutingProtocol> (a.Get (0)->GetObject<Ipv4> ()->GetRoutingProtocol ());
+  Ipv4Header header;
+  header.SetDestination (bedIfaces.GetAddress (2));
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route = routing->RouteOutput (Create<Packet> (64),header,0,sockerr);
+  NS_TEST_ASSERT_MSG_NE (route, 0, "route to d");
+  NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), abIfaces.GetAddress (1), "untagged packets take the installed next hop");
+  Ptr<Packet> packet = Create<Packet> (64);
+  SocketIpTosTag tosTag;
+  tosTag.SetTos (0xb8);
+  packet->AddPacketTag (tosTag);
+  route = routing->RouteOutput (packet,header,0,sockerr);
+  NS_TEST_ASSERT_MSG_NE (route, 0, "route to d");
+  NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), acIfaces.GetAddress (1), "EF packets take the latency class next hop");
+  Simulator::Destroy ();
+
+  // Both relays reach the sink in one hop, so either may bring a new sequence number of the sink first
+  NodeContainer source, relays, sink;
+  source.Create (1);
+  relays.Create (2);
+  sink.Create (1);
+  NetDeviceContainer first = simple.Install (NodeContainer (source,NodeContainer (relays.Get (0))));
+  NetDeviceContainer second = simple.Install (NodeContainer (source,NodeContainer (relays.Get (1))));
+  NetDeviceContainer shared = simple.Install (NodeContainer (relays,sink));
+  OlsbHelper refresh;
+  refresh.Set ("PeriodicUpdateInterval", TimeValue (Seconds (1)));
+  InternetStackHelper refreshStack;
+  refreshStack.SetRoutingHelper (refresh);
+  refreshStack.Install (NodeContainer (source,relays,sink));
+  address.SetBase ("10.1.6.0", "255.255.255.0");
+  address.Assign (first);
+  address.SetBase ("10.1.7.0", "255.255.255.0");
+  address.Assign (second);
+  address.SetBase ("10.1.8.0", "255.255.255.0");
+  address.Assign (shared);
+  Simulator::Stop (Seconds (30));
+  Simulator::Run ();
+  routing = DynamicCast<olsb::RoutingProtocol> (source.Get (0)->GetObject<Ipv4> ()->GetRoutingProtocol ());
+  NS_TEST_EXPECT_MSG_GT (routing->GetRouteChanges (), 0, "next hops changed by new sequence numbers counted");
   Simulator::Destroy ();
 }
 
@@ -216,5 +1563,19 @@ public:
   {
     AddTestCase (new OlsbHeaderTestCase (), TestCase::QUICK);
     AddTestCase (new OlsbTableTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbPacketQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbBacklogMonitorTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbLinkEstimatorTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbAirtimeEstimatorTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbLinkLifetimeEstimatorTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbLocationTableTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbUpdateCacheTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbControlBudgetTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbNeighborTableTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbMetricPolicyTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbFactorControllerTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbBackpressureSchedulerTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbAdmissionControllerTestCase (), TestCase::QUICK);
+    AddTestCase (new OlsbRoutingProtocolTestCase (), TestCase::QUICK);
   }
 } g_olsbTestSuite; ///< the test suite